@@ -0,0 +1,365 @@
+// bench/vm_bench.cpp
+// Benchmark harness: runs guest workloads with warmup and repeated trials and reports
+// interpreter throughput, VM lifecycle latency and memory bandwidth (median / p99).
+#include "src/vm/vm.h"
+#include "src/common/instruction.h"
+#include "src/workloads/workloads.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using vm::makeInstruction;
+using vm::Opcode;
+using vm::AddressingMode;
+
+namespace {
+    constexpr size_t BENCH_MEMORY_SIZE = vm::WORKLOAD_MEMORY_SIZE; // CODE, DATA, HEAP and STACK segments
+    constexpr uint32_t HEAP_BASE = 0x200000;
+
+    struct BenchConfig {
+        int warmup = 2;
+        int trials = 10;
+        uint32_t iterations = 1000000;
+        uint32_t scale = 1;
+        std::string jsonFile;
+        std::string filter;
+    };
+
+    struct Workload {
+        std::string name;
+        std::string description;
+        std::function<std::vector<uint64_t>(uint32_t)> generator;
+        bool selfChecking = false;   // Corpus workload: scaled, reports WORKLOAD_PASS
+    };
+
+    struct Stats {
+        double median = 0.0;
+        double p99 = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+    };
+
+    struct WorkloadResult {
+        std::string name;
+        uint64_t instructions = 0;
+        uint64_t memoryOps = 0;
+        Stats nsPerInstruction;
+        Stats mips;
+        Stats bandwidth;          // MB/s of guest loads and stores
+        bool valid = true;
+    };
+
+    // p99 is the slow tail: the high end for latencies, the low end for throughputs
+    Stats ComputeStats(std::vector<double> samples, bool higherIsBetter = false) {
+        Stats stats;
+        if (samples.empty()) {
+            return stats;
+        }
+        std::sort(samples.begin(), samples.end());
+        // Nearest-rank percentiles
+        auto rank = [&](double p) {
+            size_t index = static_cast<size_t>(p * static_cast<double>(samples.size()) + 0.999999);
+            return samples[std::clamp<size_t>(index, 1, samples.size()) - 1];
+        };
+        stats.median = rank(0.50);
+        stats.p99 = higherIsBetter ? rank(0.01) : rank(0.99);
+        stats.min = samples.front();
+        stats.max = samples.back();
+        return stats;
+    }
+
+    // Tight ALU loop: ADD/XOR/SHL/SUB then LOOP
+    std::vector<uint64_t> createAluLoop(uint32_t iterations) {
+        return {
+            makeInstruction(Opcode::MOV, AddressingMode::IMMEDIATE, 1, 0, iterations),  // 0x00: counter
+            makeInstruction(Opcode::ADD, AddressingMode::IMMEDIATE, 0, 0, 3),           // 0x08: loop
+            makeInstruction(Opcode::XOR, AddressingMode::REGISTER, 2, 0, 0),
+            makeInstruction(Opcode::SHL, AddressingMode::IMMEDIATE, 2, 0, 1),
+            makeInstruction(Opcode::SUB, AddressingMode::REGISTER, 2, 0, 0),
+            makeInstruction(Opcode::LOOP, AddressingMode::IMMEDIATE, 1, 0, 0x08),
+            makeInstruction(Opcode::HLT, AddressingMode::REGISTER, 0, 0, 0)
+        };
+    }
+
+    // Store/load stream through the HEAP segment (1 MB window, wraps around)
+    std::vector<uint64_t> createMemoryLoop(uint32_t iterations) {
+        return {
+            makeInstruction(Opcode::MOV, AddressingMode::IMMEDIATE, 1, 0, iterations),  // 0x00: counter
+            makeInstruction(Opcode::MOV, AddressingMode::IMMEDIATE, 3, 0, HEAP_BASE),   // 0x08: pointer
+            makeInstruction(Opcode::STORE, AddressingMode::REGISTER, 3, 0, 0),          // 0x10: loop
+            makeInstruction(Opcode::LOAD, AddressingMode::REGISTER, 2, 3, 0),
+            makeInstruction(Opcode::ADD, AddressingMode::REGISTER, 0, 2, 0),
+            makeInstruction(Opcode::ADD, AddressingMode::IMMEDIATE, 3, 0, 8),
+            makeInstruction(Opcode::AND, AddressingMode::IMMEDIATE, 3, 0, HEAP_BASE | 0xFFFF8),
+            makeInstruction(Opcode::LOOP, AddressingMode::IMMEDIATE, 1, 0, 0x10),
+            makeInstruction(Opcode::HLT, AddressingMode::REGISTER, 0, 0, 0)
+        };
+    }
+
+    // PUSH/POP pairs
+    std::vector<uint64_t> createStackLoop(uint32_t iterations) {
+        return {
+            makeInstruction(Opcode::MOV, AddressingMode::IMMEDIATE, 1, 0, iterations),  // 0x00: counter
+            makeInstruction(Opcode::PUSH, AddressingMode::REGISTER, 1, 0, 0),           // 0x08: loop
+            makeInstruction(Opcode::PUSH, AddressingMode::REGISTER, 0, 0, 0),
+            makeInstruction(Opcode::POP, AddressingMode::REGISTER, 2, 0, 0),
+            makeInstruction(Opcode::POP, AddressingMode::REGISTER, 3, 0, 0),
+            makeInstruction(Opcode::LOOP, AddressingMode::IMMEDIATE, 1, 0, 0x08),
+            makeInstruction(Opcode::HLT, AddressingMode::REGISTER, 0, 0, 0)
+        };
+    }
+
+    // CALL/RET to a leaf function
+    std::vector<uint64_t> createCallLoop(uint32_t iterations) {
+        return {
+            makeInstruction(Opcode::MOV, AddressingMode::IMMEDIATE, 1, 0, iterations),  // 0x00: counter
+            makeInstruction(Opcode::CALL, AddressingMode::IMMEDIATE, 0, 0, 0x20),       // 0x08: loop
+            makeInstruction(Opcode::LOOP, AddressingMode::IMMEDIATE, 1, 0, 0x08),
+            makeInstruction(Opcode::HLT, AddressingMode::REGISTER, 0, 0, 0),
+            makeInstruction(Opcode::ADD, AddressingMode::IMMEDIATE, 0, 0, 1),           // 0x20: leaf
+            makeInstruction(Opcode::RET, AddressingMode::REGISTER, 0, 0, 0)
+        };
+    }
+
+    std::vector<Workload> getWorkloads() {
+        std::vector<Workload> workloads = {
+            {"alu_loop", "Register ALU operations in a LOOP", createAluLoop},
+            {"memory_loop", "STORE/LOAD stream through the HEAP segment", createMemoryLoop},
+            {"stack_loop", "PUSH/POP pairs", createStackLoop},
+            {"call_loop", "CALL/RET to a leaf function", createCallLoop}
+        };
+        for (const auto& program : vm::getWorkloadCorpus()) {
+            workloads.push_back({program.name, program.description, program.generator, true});
+        }
+        return workloads;
+    }
+
+    double ElapsedNs(std::chrono::steady_clock::time_point start) {
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+
+    WorkloadResult RunWorkload(const Workload& workload, const BenchConfig& config) {
+        WorkloadResult result;
+        result.name = workload.name;
+
+        vm::VirtualMachine machine(BENCH_MEMORY_SIZE);
+        std::vector<uint64_t> program = workload.generator(workload.selfChecking ? config.scale
+                                                                                 : config.iterations);
+
+        std::vector<double> nsPerInstruction;
+        std::vector<double> mips;
+        std::vector<double> bandwidth;
+
+        for (int trial = 0; trial < config.warmup + config.trials; ++trial) {
+            machine.Reset();
+            if (!machine.LoadProgram(program)) {
+                result.valid = false;
+                return result;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            machine.Run();
+            double elapsed = ElapsedNs(start);
+
+            uint64_t instructions = machine.GetCounter(vm::CounterType::INSTRUCTIONS);
+            uint64_t memoryOps = machine.GetCounter(vm::CounterType::LOADS) +
+                                 machine.GetCounter(vm::CounterType::STORES);
+            if (machine.GetCounter(vm::CounterType::FAULTS) != 0 || instructions == 0) {
+                result.valid = false;
+            }
+            if (workload.selfChecking &&
+                machine.GetCPU().GetRegister(vm::WORKLOAD_STATUS_REGISTER) != vm::WORKLOAD_PASS) {
+                result.valid = false;
+            }
+
+            if (trial < config.warmup) {
+                continue;
+            }
+
+            result.instructions = instructions;
+            result.memoryOps = memoryOps;
+            nsPerInstruction.push_back(elapsed / static_cast<double>(instructions));
+            mips.push_back(static_cast<double>(instructions) * 1000.0 / elapsed);
+            bandwidth.push_back(static_cast<double>(memoryOps * 8) * 1000.0 / elapsed);
+        }
+
+        result.nsPerInstruction = ComputeStats(nsPerInstruction);
+        result.mips = ComputeStats(mips, true);
+        result.bandwidth = ComputeStats(bandwidth, true);
+        return result;
+    }
+
+    Stats MeasureCreateLatency(int trials) {
+        std::vector<double> samples;
+        for (int i = 0; i < trials; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            vm::VirtualMachine machine(BENCH_MEMORY_SIZE);
+            samples.push_back(ElapsedNs(start));
+        }
+        return ComputeStats(samples);
+    }
+
+    Stats MeasureResetLatency(int trials) {
+        vm::VirtualMachine machine(BENCH_MEMORY_SIZE);
+        std::vector<double> samples;
+        for (int i = 0; i < trials; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            machine.Reset();
+            samples.push_back(ElapsedNs(start));
+        }
+        return ComputeStats(samples);
+    }
+
+    void WriteStats(std::ostream& out, const Stats& stats) {
+        out << "{\"median\": " << stats.median << ", \"p99\": " << stats.p99
+            << ", \"min\": " << stats.min << ", \"max\": " << stats.max << "}";
+    }
+
+    bool WriteJson(const std::string& filename, const BenchConfig& config,
+                   const std::vector<WorkloadResult>& results,
+                   const Stats& createLatency, const Stats& resetLatency) {
+        std::ofstream out(filename);
+        if (!out.is_open()) {
+            std::cerr << "Error: Cannot create JSON report: " << filename << std::endl;
+            return false;
+        }
+
+        out << std::fixed << std::setprecision(3);
+        out << "{\n";
+        out << "  \"format\": \"vm_bench/1\",\n";
+        out << "  \"timestamp\": " << static_cast<uint64_t>(std::time(nullptr)) << ",\n";
+        out << "  \"config\": {\"warmup\": " << config.warmup << ", \"trials\": " << config.trials
+            << ", \"iterations\": " << config.iterations << ", \"scale\": " << config.scale
+            << ", \"memory_size\": " << BENCH_MEMORY_SIZE << "},\n";
+        out << "  \"vm_create_ns\": "; WriteStats(out, createLatency); out << ",\n";
+        out << "  \"vm_reset_ns\": "; WriteStats(out, resetLatency); out << ",\n";
+        out << "  \"workloads\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            out << "    {\"name\": \"" << r.name << "\", \"valid\": " << (r.valid ? "true" : "false")
+                << ", \"instructions\": " << r.instructions
+                << ", \"memory_ops\": " << r.memoryOps << ",\n";
+            out << "     \"ns_per_instruction\": "; WriteStats(out, r.nsPerInstruction); out << ",\n";
+            out << "     \"mips\": "; WriteStats(out, r.mips); out << ",\n";
+            out << "     \"memory_bandwidth_mb_s\": "; WriteStats(out, r.bandwidth);
+            out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n";
+        out << "}\n";
+        return out.good();
+    }
+
+    void printUsage(const char* programName) {
+        std::cout << "Usage: " << programName << " [OPTIONS]" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "  --trials <n>       Measured trials per workload (default 10)" << std::endl;
+        std::cout << "  --warmup <n>       Unmeasured warmup runs per workload (default 2)" << std::endl;
+        std::cout << "  --iterations <n>   Loop iterations per workload run (default 1000000)" << std::endl;
+        std::cout << "  --scale <n>        Scale factor of the self-checking corpus workloads (default 1)" << std::endl;
+        std::cout << "  --filter <name>    Only run workloads whose name contains <name>" << std::endl;
+        std::cout << "  --json <file>      Write machine-readable results to <file>" << std::endl;
+        std::cout << "  --list             List workloads" << std::endl;
+        std::cout << "  -h, --help         Show this help message" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        auto requireValue = [&](const char* option) -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << option << " option requires a value" << std::endl;
+                printUsage(argv[0]);
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (strcmp(argv[i], "--trials") == 0) {
+            config.trials = std::max(1, std::atoi(requireValue("--trials")));
+        } else if (strcmp(argv[i], "--warmup") == 0) {
+            config.warmup = std::max(0, std::atoi(requireValue("--warmup")));
+        } else if (strcmp(argv[i], "--iterations") == 0) {
+            config.iterations = static_cast<uint32_t>(std::max(1L, std::atol(requireValue("--iterations"))));
+        } else if (strcmp(argv[i], "--scale") == 0) {
+            config.scale = static_cast<uint32_t>(std::max(1L, std::atol(requireValue("--scale"))));
+        } else if (strcmp(argv[i], "--filter") == 0) {
+            config.filter = requireValue("--filter");
+        } else if (strcmp(argv[i], "--json") == 0) {
+            config.jsonFile = requireValue("--json");
+        } else if (strcmp(argv[i], "--list") == 0) {
+            for (const auto& workload : getWorkloads()) {
+                std::cout << std::left << std::setw(20) << workload.name << workload.description << std::endl;
+            }
+            return 0;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Error: Unknown option: " << argv[i] << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::cout << "=== VM Benchmark ===" << std::endl;
+    std::cout << "Warmup: " << config.warmup << "  Trials: " << config.trials
+              << "  Iterations: " << config.iterations << "  Scale: " << config.scale << std::endl;
+
+    Stats createLatency = MeasureCreateLatency(std::max(config.trials, 20));
+    Stats resetLatency = MeasureResetLatency(std::max(config.trials, 20));
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "\nVM create: median " << createLatency.median / 1000.0 << " us, p99 "
+              << createLatency.p99 / 1000.0 << " us" << std::endl;
+    std::cout << "VM reset:  median " << resetLatency.median / 1000.0 << " us, p99 "
+              << resetLatency.p99 / 1000.0 << " us" << std::endl;
+
+    std::cout << "\n" << std::left << std::setw(16) << "workload"
+              << std::right << std::setw(14) << "instructions"
+              << std::setw(12) << "MIPS med" << std::setw(12) << "MIPS p99"
+              << std::setw(12) << "ns/ins med" << std::setw(12) << "ns/ins p99"
+              << std::setw(12) << "MB/s med" << std::endl;
+
+    std::vector<WorkloadResult> results;
+    for (const auto& workload : getWorkloads()) {
+        if (!config.filter.empty() && workload.name.find(config.filter) == std::string::npos) {
+            continue;
+        }
+
+        WorkloadResult result = RunWorkload(workload, config);
+        std::cout << std::left << std::setw(16) << result.name
+                  << std::right << std::setw(14) << result.instructions
+                  << std::setprecision(2)
+                  << std::setw(12) << result.mips.median << std::setw(12) << result.mips.p99
+                  << std::setw(12) << result.nsPerInstruction.median
+                  << std::setw(12) << result.nsPerInstruction.p99
+                  << std::setw(12) << result.bandwidth.median
+                  << (result.valid ? "" : "  [INVALID]") << std::endl;
+        results.push_back(result);
+    }
+
+    if (!config.jsonFile.empty()) {
+        if (!WriteJson(config.jsonFile, config, results, createLatency, resetLatency)) {
+            return 1;
+        }
+        std::cout << "\nResults written to " << config.jsonFile << std::endl;
+    }
+
+    for (const auto& result : results) {
+        if (!result.valid) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -3,11 +3,20 @@
 //
 #include "src/vm/vm.h"
 #include "src/vm/firmware_loader.h"
+#include "src/common/instruction.h"
+#include "src/workloads/workloads.h"
+#include "src/profiler/sampling_profiler.h"
+#include "src/vm/batch_runner.h"
+#include "src/analysis/verifier.h"
 #include <iostream>
 #include <vector>
 #include <string>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <functional>
+#include <chrono>
+#include <iomanip>
 
 // Structure pour définir un programme
 struct TestProgram {
@@ -17,17 +26,7 @@ struct TestProgram {
     std::function<std::vector<uint64_t>()> generator;
 };
 
-// Utility function to create an instruction
-uint64_t makeInstruction(vm::Opcode opcode, vm::AddressingMode mode,
-                        uint8_t reg1, uint8_t reg2, uint32_t immediate) {
-    uint64_t instr = 0;
-    instr |= (static_cast<uint64_t>(opcode) << 56);
-    instr |= (static_cast<uint64_t>(mode) << 52);
-    instr |= (static_cast<uint64_t>(reg1) << 48);
-    instr |= (static_cast<uint64_t>(reg2) << 44);
-    instr |= static_cast<uint64_t>(immediate);
-    return instr;
-}
+using vm::makeInstruction;
 
 std::vector<uint64_t> createTestProgram() {
     // Simple test program
@@ -409,7 +408,7 @@ std::vector<TestProgram> getAdvancedTestPrograms() {
 
 // Générateur de suite de benchmarks
 std::vector<TestProgram> getBenchmarkPrograms() {
-    return {
+    std::vector<TestProgram> programs = {
         {"cpu_intensive", "CPU intensive operations test", "cpu_bench.vmfw", 
          []() { return createCPUBenchmark(); }},
         {"memory_bandwidth", "Memory bandwidth test", "mem_bench.vmfw",
@@ -417,15 +416,41 @@ std::vector<TestProgram> getBenchmarkPrograms() {
         {"stack_stress", "Stack operations stress test", "stack_bench.vmfw",
          []() { return createStackBenchmark(); }}
     };
+
+    // Self-checking workload corpus (R15 = 1 on success, needs 4 MB of RAM)
+    for (const auto& workload : vm::getWorkloadCorpus()) {
+        auto generator = workload.generator;
+        programs.push_back({workload.name, workload.description, workload.name + "_bench.vmfw",
+                            [generator]() { return generator(1); }});
+    }
+    return programs;
+}
+
+// Firmware file format used by the generators
+struct FirmwareOutput {
+    uint32_t version = 1;
+    bool compress = false;   // v2 only
+};
+
+// Write a generated program in the requested firmware format
+bool saveGeneratedFirmware(const std::string& filename, const std::vector<uint64_t>& instructions,
+                           const std::string& description, const FirmwareOutput& output) {
+    if (output.version == vm::FIRMWARE_VERSION_2) {
+        vm::FirmwareImage image;
+        image.code = instructions;
+        image.description = description;
+        return vm::FirmwareLoader::SaveFirmwareV2(filename, image, output.compress);
+    }
+    return vm::FirmwareLoader::SaveFirmware(filename, instructions, description);
 }
 
-void generateSingleProgram(const TestProgram& program) {
+void generateSingleProgram(const TestProgram& program, const FirmwareOutput& output) {
     std::cout << "\nGenerating: " << program.name << std::endl;
     std::cout << "Description: " << program.description << std::endl;
     
     std::vector<uint64_t> instructions = program.generator();
     
-    if (vm::FirmwareLoader::SaveFirmware(program.filename, instructions, program.description)) {
+    if (saveGeneratedFirmware(program.filename, instructions, program.description, output)) {
         std::cout << "✓ Generated: " << program.filename 
                   << " (" << instructions.size() << " instructions)" << std::endl;
         
@@ -436,7 +461,7 @@ void generateSingleProgram(const TestProgram& program) {
     }
 }
 
-void generateAdvancedTestFirmware() {
+void generateAdvancedTestFirmware(const FirmwareOutput& output) {
     std::cout << "=== Educational Virtual Machine - Advanced Test Firmware Generation ===" << std::endl;
     
     auto programs = getAdvancedTestPrograms();
@@ -462,26 +487,26 @@ void generateAdvancedTestFirmware() {
         // Générer tous les programmes
         std::cout << "\nGenerating all test programs..." << std::endl;
         for (const auto& program : programs) {
-            generateSingleProgram(program);
+            generateSingleProgram(program, output);
         }
         std::cout << "\nAll programs generated successfully!" << std::endl;
     } else if (choice >= 1 && choice <= static_cast<int>(programs.size())) {
         // Générer un programme spécifique
         const auto& program = programs[choice - 1];
-        generateSingleProgram(program);
+        generateSingleProgram(program, output);
     } else {
         std::cerr << "Invalid choice!" << std::endl;
     }
 }
 
-void generateBenchmarkSuite() {
+void generateBenchmarkSuite(const FirmwareOutput& output) {
     std::cout << "=== Educational Virtual Machine - Benchmark Suite Generation ===" << std::endl;
     
     auto benchmarks = getBenchmarkPrograms();
     
     std::cout << "\nGenerating benchmark programs..." << std::endl;
     for (const auto& benchmark : benchmarks) {
-        generateSingleProgram(benchmark);
+        generateSingleProgram(benchmark, output);
     }
     std::cout << "\nBenchmark suite generated successfully!" << std::endl;
 }
@@ -489,9 +514,148 @@ void generateBenchmarkSuite() {
 void listAvailableFirmware() {
     std::cout << "=== Available Firmware Files ===" << std::endl;
     std::cout << "Scanning current directory for .vmfw files..." << std::endl;
-    // Note: Cette fonction nécessiterait l'utilisation de filesystem pour scanner le répertoire
-    // Pour l'instant, on affiche juste un message informatif
-    std::cout << "Use 'ls *.vmfw' or 'dir *.vmfw' to list firmware files in your system." << std::endl;
+
+    auto files = vm::BatchRunner::DiscoverFirmware(".");
+    for (const auto& file : files) {
+        std::cout << "  " << file;
+        if (!vm::FirmwareLoader::IsValidFirmware(file)) {
+            std::cout << " (invalid)";
+        }
+        std::cout << std::endl;
+    }
+    std::cout << files.size() << " firmware file(s) found." << std::endl;
+}
+
+// Contents of a JSON string literal: quotes, backslashes and control characters escaped
+std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (unsigned char c : text) {
+        switch (c) {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char code[8];
+                    snprintf(code, sizeof(code), "\\u%04x", c);
+                    escaped += code;
+                } else {
+                    escaped += static_cast<char>(c);
+                }
+        }
+    }
+    return escaped;
+}
+
+// Static checks only: print the verifier report without running the firmware
+bool verifyFirmware(const std::string& filename) {
+    vm::FirmwareImage image;
+    if (!vm::FirmwareLoader::LoadFirmwareImage(filename, image, false)) {
+        std::cerr << "Error: Cannot load firmware " << filename << std::endl;
+        return false;
+    }
+
+    vm::VerificationReport report = vm::FirmwareVerifier::Verify(image.code, image.codeAddress);
+    std::cout << "=== Verification Report ===" << std::endl;
+    std::cout << "Firmware: " << filename << std::endl;
+    std::cout << "Instructions: " << report.instructionCount << std::endl;
+    std::cout << "Basic blocks: " << report.blocks.size() << " (" << report.verifiedBlocks << " verified)" << std::endl;
+    for (const auto& issue : report.issues) {
+        std::cout << "  0x" << std::hex << std::setw(8) << std::setfill('0') << issue.address
+                  << std::dec << std::setfill(' ') << ": " << issue.message << std::endl;
+    }
+    std::cout << "Result: " << (report.IsValid() ? "OK" : "FAILED") << std::endl;
+    return report.IsValid();
+}
+
+// Run every firmware found in a directory (or listed in a file) on all cores
+bool runBatch(const std::string& path, size_t jobs, uint64_t instructionLimit, bool jsonReport,
+              const std::string& translationCacheDir) {
+    auto files = vm::BatchRunner::DiscoverFirmware(path);
+    if (files.empty()) {
+        std::cerr << "Error: No firmware found in " << path << std::endl;
+        return false;
+    }
+
+    vm::BatchRunner runner(jobs);
+    runner.SetTranslationCacheDirectory(translationCacheDir);
+    runner.SetInstructionLimit(instructionLimit);
+    auto start = std::chrono::steady_clock::now();
+    auto results = runner.Run(files);
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    size_t passed = 0;
+    size_t faulted = 0;
+    size_t timedOut = 0;
+    size_t loadErrors = 0;
+    uint64_t totalInstructions = 0;
+    double cpuMs = 0.0;
+    for (const auto& result : results) {
+        if (!result.loaded) {
+            ++loadErrors;
+        } else if (result.halted) {
+            ++passed;
+        } else if (result.timedOut) {
+            ++timedOut;
+        } else {
+            ++faulted;
+        }
+        totalInstructions += result.instructions;
+        cpuMs += result.wallNs / 1e6;
+    }
+
+    if (jsonReport) {
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "{\n";
+        std::cout << "  \"threads\": " << runner.GetThreadCount() << ",\n";
+        std::cout << "  \"files\": " << results.size() << ", \"halted\": " << passed
+                  << ", \"faulted\": " << faulted << ", \"timed_out\": " << timedOut
+                  << ", \"load_errors\": " << loadErrors << ",\n";
+        std::cout << "  \"instruction_limit\": " << instructionLimit << ",\n";
+        std::cout << "  \"instructions\": " << totalInstructions << ",\n";
+        std::cout << "  \"wall_time_ms\": " << wallMs << ", \"cpu_time_ms\": " << cpuMs << ",\n";
+        std::cout << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            std::cout << "    {\"file\": \"" << jsonEscape(r.filename) << "\", \"loaded\": " << (r.loaded ? "true" : "false")
+                      << ", \"halted\": " << (r.halted ? "true" : "false")
+                      << ", \"timed_out\": " << (r.timedOut ? "true" : "false")
+                      << ", \"faults\": " << r.faults << ", \"instructions\": " << r.instructions
+                      << ", \"time_ms\": " << r.wallNs / 1e6 << ", \"error\": \"" << jsonEscape(r.error) << "\""
+                      << ", \"registers\": [";
+            for (size_t reg = 0; reg < vm::REGISTER_COUNT; ++reg) {
+                std::cout << (reg ? ", " : "") << r.registers[reg];
+            }
+            std::cout << "]}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        std::cout << "  ]\n";
+        std::cout << "}" << std::endl;
+    } else {
+        std::cout << "=== Batch Report ===" << std::endl;
+        std::cout << std::left << std::setw(40) << "firmware" << std::setw(8) << "state"
+                  << std::right << std::setw(14) << "instructions" << std::setw(12) << "time ms"
+                  << std::setw(20) << "R0" << std::endl;
+        for (const auto& r : results) {
+            const char* state = !r.loaded ? "LOADERR" : r.halted ? "HALT" : r.timedOut ? "TIMEOUT" : "FAULT";
+            std::cout << std::left << std::setw(40) << r.filename << std::setw(8) << state
+                      << std::right << std::dec << std::setw(14) << r.instructions
+                      << std::fixed << std::setprecision(3) << std::setw(12) << r.wallNs / 1e6
+                      << std::setw(20) << r.registers[0];
+            if (!r.error.empty()) {
+                std::cout << "  " << r.error;
+            }
+            std::cout << std::endl;
+        }
+        std::cout << "\nFiles: " << results.size() << "  halted: " << passed << "  faulted: " << faulted
+                  << "  timed out: " << timedOut << "  load errors: " << loadErrors << std::endl;
+        std::cout << "Threads: " << runner.GetThreadCount() << "  wall: " << std::setprecision(1) << wallMs
+                  << " ms  cpu: " << cpuMs << " ms  instructions: " << totalInstructions << std::endl;
+    }
+
+    return faulted == 0 && timedOut == 0 && loadErrors == 0;
 }
 
 void runDemo() {
@@ -524,39 +688,144 @@ void runDemo() {
     }
 }
 
-void runFirmware(const std::string& filename) {
+void runFirmware(const std::string& filename, const std::string& profileFile, vm::ClockMode clockMode,
+                 const std::string& translationCacheDir) {
     std::cout << "=== Educational Virtual Machine - Firmware Mode ===" << std::endl;
     std::cout << "Loading firmware: " << filename << std::endl;
 
-    // Create VM with 1MB of RAM
-    vm::VirtualMachine vm(1024 * 1024);
+    // Create VM with 4MB of RAM so the DATA, HEAP and STACK segments all exist
+    vm::VirtualMachine vm(4 * 1024 * 1024);
     vm.EnableDebugger(true);
     vm.EnableStepByStep(true); // Enable step-by-step mode
+    vm.SetClockMode(clockMode);
+    vm.SetTranslationCacheDirectory(translationCacheDir);
 
-    // Load firmware
-    std::vector<uint64_t> instructions;
-    if (!vm::FirmwareLoader::LoadFirmware(filename, instructions)) {
+    // Map the firmware into guest memory and execute it
+    if (!vm.LoadFirmware(filename)) {
         std::cerr << "Error: Failed to load firmware file: " << filename << std::endl;
         return;
     }
 
-    // Load and execute firmware
-    if (vm.LoadProgram(instructions)) {
-        std::cout << "\nInitial state:" << std::endl;
-        vm.PrintState();
+    std::cout << "\nInitial state:" << std::endl;
+    vm.PrintState();
 
-        std::cout << "\nExecuting firmware..." << std::endl;
-        vm.Run();
+    std::cout << "\nExecuting firmware..." << std::endl;
+    vm::SamplingProfiler profiler;
+    if (!profileFile.empty() && !profiler.Start(vm.GetCPU())) {
+        std::cerr << "Warning: Sampling profiler could not be started" << std::endl;
+    }
 
-        std::cout << "\nFinal state:" << std::endl;
-        vm.PrintState();
+    vm.Run();
 
-        std::cout << "\nMemory dump (stack):" << std::endl;
-        vm.DumpMemory(vm.GetMemory().GetSize() - 0x100, 128);
+    if (profiler.IsActive()) {
+        profiler.Stop();
+        if (profiler.WriteHistogram(profileFile)) {
+            std::cout << "\nProfile written to " << profileFile << " ("
+                      << std::dec << profiler.GetSampleCount() << " samples)" << std::endl;
+        }
+    }
+
+    std::cout << "\nFinal state:" << std::endl;
+    vm.PrintState();
+
+    std::cout << "\nMemory dump (stack):" << std::endl;
+    vm.DumpMemory(vm.GetMemory().GetSize() - 0x100, 128);
+}
+
+// Headless run: full speed, no tracing, timing report at exit
+bool runHeadless(const std::string& filename, const std::string& profileFile,
+                 vm::ClockMode clockMode, bool jsonReport, const std::string& translationCacheDir) {
+    vm::VirtualMachine vm(4 * 1024 * 1024);
+    vm.SetClockMode(clockMode);
+    vm.SetTranslationCacheDirectory(translationCacheDir);
+    if (jsonReport) {
+        // stdout carries the report only; guest output goes to stderr
+        vm.GetCPU().GetConsole().SetOutputStream(std::cerr);
+    }
+
+    auto loadStart = std::chrono::steady_clock::now();
+    if (!vm.LoadFirmware(filename)) {
+        std::cerr << "Error: Failed to load firmware file: " << filename << ": " << vm.GetLastError() << std::endl;
+        return false;
+    }
+    double loadNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - loadStart).count());
+    const char* translationCache = translationCacheDir.empty() ? "off"
+                                 : vm.WasTranslationCacheHit() ? "hit" : "miss";
+
+    vm::SamplingProfiler profiler;
+    if (!profileFile.empty() && !profiler.Start(vm.GetCPU())) {
+        std::cerr << "Warning: Sampling profiler could not be started" << std::endl;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    vm.Run();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (profiler.IsActive()) {
+        profiler.Stop();
+        profiler.WriteHistogram(profileFile);
+    }
+
+    const vm::CPU& cpu = vm.GetCPU();
+    const vm::DecodeCache& cache = cpu.GetDecodeCache();
+    double wallNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    uint64_t retired = vm.GetCounter(vm::CounterType::INSTRUCTIONS);
+    double mips = wallNs > 0 ? static_cast<double>(retired) * 1000.0 / wallNs : 0.0;
+    uint64_t touched = vm.GetMemory().GetTouchedBytes();
+    const std::string& error = vm.GetLastError();
+
+    if (jsonReport) {
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "{\n";
+        std::cout << "  \"firmware\": \"" << jsonEscape(filename) << "\",\n";
+        std::cout << "  \"load_time_ns\": " << std::dec << static_cast<uint64_t>(loadNs) << ",\n";
+        std::cout << "  \"translation_cache\": \"" << translationCache << "\",\n";
+        std::cout << "  \"verified_blocks\": " << cache.CountBlocks(vm::DECODED_VERIFIED_BLOCK) << ",\n";
+        std::cout << "  \"blocks\": " << cache.CountBlocks(vm::DECODED_BLOCK_START) << ",\n";
+        std::cout << "  \"wall_time_ns\": " << std::dec << static_cast<uint64_t>(wallNs) << ",\n";
+        std::cout << "  \"instructions\": " << retired << ",\n";
+        std::cout << "  \"mips\": " << mips << ",\n";
+        std::cout << "  \"cycles\": " << vm.GetCounter(vm::CounterType::CYCLES) << ",\n";
+        std::cout << "  \"loads\": " << vm.GetCounter(vm::CounterType::LOADS) << ",\n";
+        std::cout << "  \"stores\": " << vm.GetCounter(vm::CounterType::STORES) << ",\n";
+        std::cout << "  \"branches\": " << vm.GetCounter(vm::CounterType::BRANCHES) << ",\n";
+        std::cout << "  \"calls\": " << vm.GetCounter(vm::CounterType::CALLS) << ",\n";
+        std::cout << "  \"faults\": " << vm.GetCounter(vm::CounterType::FAULTS) << ",\n";
+        std::cout << "  \"memory_touched_bytes\": " << touched << ",\n";
+        std::cout << "  \"error\": \"" << jsonEscape(error) << "\",\n";
+        std::cout << "  \"registers\": [";
+        for (size_t i = 0; i < vm::REGISTER_COUNT; ++i) {
+            std::cout << (i ? ", " : "") << cpu.GetRegister(static_cast<uint8_t>(i));
+        }
+        std::cout << "],\n";
+        std::cout << "  \"pc\": " << cpu.GetPC() << ",\n";
+        std::cout << "  \"sp\": " << cpu.GetSP() << ",\n";
+        std::cout << "  \"flags\": " << cpu.GetFlags() << "\n";
+        std::cout << "}" << std::endl;
+    } else {
+        std::cout << "=== Run Report ===" << std::endl;
+        std::cout << "Firmware: " << filename << std::endl;
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "Load time: " << loadNs / 1e6 << " ms (translation cache: " << translationCache << ")" << std::endl;
+        std::cout << "Verified blocks: " << cache.CountBlocks(vm::DECODED_VERIFIED_BLOCK) << "/"
+                  << cache.CountBlocks(vm::DECODED_BLOCK_START) << std::endl;
+        std::cout << "Wall time: " << wallNs / 1e6 << " ms" << std::endl;
+        std::cout << "Instructions retired: " << std::dec << retired << std::endl;
+        std::cout << std::setprecision(2) << "MIPS: " << mips << std::endl;
+        std::cout << "Cycles: " << vm.GetCounter(vm::CounterType::CYCLES) << std::endl;
+        std::cout << "Faults: " << vm.GetCounter(vm::CounterType::FAULTS) << std::endl;
+        std::cout << "Guest memory touched: " << touched << " bytes" << std::endl;
+        if (!error.empty()) {
+            std::cout << "Error: " << error << std::endl;
+        }
+        vm.DumpRegisters();
     }
+
+    return error.empty() && vm.GetCounter(vm::CounterType::FAULTS) == 0;
 }
 
-void generateTestFirmware() {
+void generateTestFirmware(const FirmwareOutput& output) {
     std::cout << "=== Educational Virtual Machine - Basic Test Firmware Generation ===" << std::endl;
     
     const std::string filename = "firmware.vmfw";
@@ -564,7 +833,7 @@ void generateTestFirmware() {
     
     std::vector<uint64_t> program = createTestProgram();
     
-    if (vm::FirmwareLoader::SaveFirmware(filename, program, description)) {
+    if (saveGeneratedFirmware(filename, program, description, output)) {
         std::cout << "\nBasic test firmware generated successfully!" << std::endl;
         std::cout << "You can now run it with: " << std::endl;
         std::cout << "  ./vm -f " << filename << std::endl;
@@ -582,10 +851,22 @@ void printUsage(const char* programName) {
     std::cout << "Options:" << std::endl;
     std::cout << "  -d              Run demo mode (default)" << std::endl;
     std::cout << "  -f <filename>   Load and execute firmware file" << std::endl;
+    std::cout << "  --run <file>    Execute firmware at full speed without tracing, print a run report" << std::endl;
+    std::cout << "  --verify <file> Statically check firmware code (opcodes, jump targets) without running it" << std::endl;
+    std::cout << "  --quiet         Make -f run headless (same as --run)" << std::endl;
+    std::cout << "  --json          Print the --run / --batch report as JSON" << std::endl;
+    std::cout << "  --batch <path>  Run every .vmfw under a directory (or listed in a file) in parallel" << std::endl;
+    std::cout << "  --jobs <n>      Worker threads for --batch (default: one per core)" << std::endl;
+    std::cout << "  --max-instructions <n>  Stop a --batch image after n instructions (default: 10 billion, 0: no limit)" << std::endl;
     std::cout << "  -t              Generate basic test firmware file" << std::endl;
     std::cout << "  -T              Generate advanced test firmware (interactive)" << std::endl;
     std::cout << "  --benchmark     Generate benchmark suite" << std::endl;
+    std::cout << "  --fw-v2         Write generated firmware in the sectioned v2 format" << std::endl;
+    std::cout << "  --compress      Like --fw-v2, with a compressed code section" << std::endl;
     std::cout << "  --list-fw       List all available firmware in current directory" << std::endl;
+    std::cout << "  --profile <out> Sample the guest PC while running firmware, write histogram to <out>" << std::endl;
+    std::cout << "  --tcache <dir>  Keep decoded code in <dir>, reused by later runs of the same firmware" << std::endl;
+    std::cout << "  --virtual-clock Derive guest time from retired cycles (reproducible runs)" << std::endl;
     std::cout << "  -h, --help      Show this help message" << std::endl;
     std::cout << std::endl;
     std::cout << "Examples:" << std::endl;
@@ -593,13 +874,23 @@ void printUsage(const char* programName) {
     std::cout << "  " << programName << " -T                 # Interactive firmware generator" << std::endl;
     std::cout << "  " << programName << " -f fibonacci.vmfw  # Run Fibonacci calculator" << std::endl;
     std::cout << "  " << programName << " --benchmark        # Generate performance tests" << std::endl;
+    std::cout << "  " << programName << " --run quicksort_bench.vmfw --json  # Headless run with JSON report" << std::endl;
 }
 
 int main(int argc, char* argv[]) {
     // Default mode is demo
-    enum Mode { DEMO, FIRMWARE, GENERATE_TEST, GENERATE_ADVANCED, GENERATE_BENCHMARK, LIST_FIRMWARE };
+    enum Mode { DEMO, FIRMWARE, RUN, VERIFY, BATCH, GENERATE_TEST, GENERATE_ADVANCED, GENERATE_BENCHMARK, LIST_FIRMWARE };
     Mode mode = DEMO;
     std::string firmwareFile;
+    std::string profileFile;
+    std::string translationCacheDir;
+    vm::ClockMode clockMode = vm::ClockMode::HOST;
+    bool quiet = false;
+    bool jsonReport = false;
+    std::string batchPath;
+    size_t jobs = 0;
+    uint64_t instructionLimit = vm::BatchRunner::DEFAULT_INSTRUCTION_LIMIT;
+    FirmwareOutput output;
 
     // Parse command line arguments
     for (int i = 1; i < argc; ++i) {
@@ -615,14 +906,91 @@ int main(int argc, char* argv[]) {
                 printUsage(argv[0]);
                 return 1;
             }
+        } else if (strcmp(argv[i], "--run") == 0) {
+            if (i + 1 < argc) {
+                firmwareFile = argv[i + 1];
+                mode = RUN;
+                ++i; // Skip the filename argument
+            } else {
+                std::cerr << "Error: --run option requires a filename" << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            if (i + 1 < argc) {
+                firmwareFile = argv[i + 1];
+                mode = VERIFY;
+                ++i; // Skip the filename argument
+            } else {
+                std::cerr << "Error: --verify option requires a filename" << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            if (i + 1 < argc) {
+                batchPath = argv[i + 1];
+                mode = BATCH;
+                ++i; // Skip the path argument
+            } else {
+                std::cerr << "Error: --batch option requires a directory or list file" << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--jobs") == 0) {
+            if (i + 1 < argc) {
+                jobs = static_cast<size_t>(std::max(0, atoi(argv[i + 1])));
+                ++i; // Skip the count argument
+            } else {
+                std::cerr << "Error: --jobs option requires a number" << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--max-instructions") == 0) {
+            if (i + 1 < argc) {
+                instructionLimit = strtoull(argv[i + 1], nullptr, 0);
+                ++i; // Skip the count argument
+            } else {
+                std::cerr << "Error: --max-instructions option requires a number" << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            jsonReport = true;
         } else if (strcmp(argv[i], "-t") == 0) {
             mode = GENERATE_TEST;
         } else if (strcmp(argv[i], "-T") == 0) {
             mode = GENERATE_ADVANCED;
         } else if (strcmp(argv[i], "--benchmark") == 0) {
             mode = GENERATE_BENCHMARK;
+        } else if (strcmp(argv[i], "--fw-v2") == 0) {
+            output.version = vm::FIRMWARE_VERSION_2;
+        } else if (strcmp(argv[i], "--compress") == 0) {
+            output.version = vm::FIRMWARE_VERSION_2;
+            output.compress = true;
         } else if (strcmp(argv[i], "--list-fw") == 0) {
             mode = LIST_FIRMWARE;
+        } else if (strcmp(argv[i], "--virtual-clock") == 0) {
+            clockMode = vm::ClockMode::VIRTUAL;
+        } else if (strcmp(argv[i], "--tcache") == 0) {
+            if (i + 1 < argc) {
+                translationCacheDir = argv[i + 1];
+                ++i; // Skip the directory argument
+            } else {
+                std::cerr << "Error: --tcache option requires a directory" << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            if (i + 1 < argc) {
+                profileFile = argv[i + 1];
+                ++i; // Skip the filename argument
+            } else {
+                std::cerr << "Error: --profile option requires a filename" << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
         } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             printUsage(argv[0]);
             return 0;
@@ -633,22 +1001,41 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (mode == FIRMWARE && quiet) {
+        mode = RUN;
+    }
+
     try {
         switch (mode) {
             case DEMO:
                 runDemo();
                 break;
             case FIRMWARE:
-                runFirmware(firmwareFile);
+                runFirmware(firmwareFile, profileFile, clockMode, translationCacheDir);
+                break;
+            case VERIFY:
+                if (!verifyFirmware(firmwareFile)) {
+                    return 1;
+                }
+                break;
+            case BATCH:
+                if (!runBatch(batchPath, jobs, instructionLimit, jsonReport, translationCacheDir)) {
+                    return 1;
+                }
+                break;
+            case RUN:
+                if (!runHeadless(firmwareFile, profileFile, clockMode, jsonReport, translationCacheDir)) {
+                    return 1;
+                }
                 break;
             case GENERATE_TEST:
-                generateTestFirmware();
+                generateTestFirmware(output);
                 break;
             case GENERATE_ADVANCED:
-                generateAdvancedTestFirmware();
+                generateAdvancedTestFirmware(output);
                 break;
             case GENERATE_BENCHMARK:
-                generateBenchmarkSuite();
+                generateBenchmarkSuite(output);
                 break;
             case LIST_FIRMWARE:
                 listAvailableFirmware();
@@ -0,0 +1,322 @@
+// src/analysis/cfg.cpp
+#include "cfg.h"
+#include "instruction_effects.h"
+#include <common/instruction.h>
+#include <cpu/cpu.h>
+#include <algorithm>
+
+namespace vm {
+    ControlFlowGraph::ControlFlowGraph() : mBase(0) {
+    }
+
+    void ControlFlowGraph::Build(const uint64_t* code, size_t count, uint64_t base, uint64_t entryPoint) {
+        mInstructions.clear();
+        mLiterals.clear();
+        mBlocks.clear();
+        mBlockOf.clear();
+        mEntries.clear();
+        mIdom.clear();
+        mReversePostorder.clear();
+        mLoops.clear();
+        mBase = base;
+
+        if (count == 0) {
+            return;
+        }
+
+        FindBlocks(code, count);
+
+        size_t entry = TargetIndex(entryPoint);
+        mEntries.push_back(mBlockOf[entry != NO_BLOCK ? entry : 0]);
+        LinkBlocks();
+        ComputeOrder();
+        ComputeDominators();
+        FindLoops();
+    }
+
+    size_t ControlFlowGraph::TargetIndex(uint64_t address) const {
+        uint64_t offset = address - mBase;
+        if (address < mBase || offset % sizeof(uint64_t) != 0 || offset / sizeof(uint64_t) >= mInstructions.size() ||
+            mLiterals[offset / sizeof(uint64_t)]) {
+            return NO_BLOCK;
+        }
+        return static_cast<size_t>(offset / sizeof(uint64_t));
+    }
+
+    void ControlFlowGraph::FindBlocks(const uint64_t* code, size_t count) {
+        mInstructions.resize(count);
+        mLiterals.assign(count, 0);
+        for (size_t i = 0; i < count; ++i) {
+            mInstructions[i] = decodeInstruction(code[i]);
+            if (InstructionWords(mInstructions[i].opcode) == 2 && i + 1 < count) {
+                mLiterals[++i] = 1;     // Left as a NOP in the MOVW's block
+            }
+        }
+
+        std::vector<uint8_t> leader(count + 1, 0);
+        leader[0] = 1;
+        for (size_t i = 0; i < count; ++i) {
+            const Instruction& instr = mInstructions[i];
+            if (HasDirectTarget(instr)) {
+                size_t target = TargetIndex(instr);
+                if (target != NO_BLOCK) {
+                    leader[target] = 1;
+                }
+            }
+            if (IsControlTransfer(instr.opcode) || !IsValidOpcode(instr.opcode)) {
+                leader[i + 1] = 1;
+            }
+        }
+
+        mBlockOf.resize(count);
+        for (size_t start = 0; start < count;) {
+            size_t end = start + 1;
+            while (end < count && !leader[end]) {
+                ++end;
+            }
+
+            BasicBlock block;
+            block.start = start;
+            block.length = end - start;
+            std::fill(mBlockOf.begin() + start, mBlockOf.begin() + end, mBlocks.size());
+            mBlocks.push_back(block);
+            start = end;
+        }
+    }
+
+    void ControlFlowGraph::LinkBlocks() {
+        for (size_t b = 0; b < mBlocks.size(); ++b) {
+            BasicBlock& block = mBlocks[b];
+            const Instruction& last = mInstructions[block.Last()];
+            bool fallsThrough = true;
+
+            if (!IsValidOpcode(last.opcode) || last.opcode == Opcode::RET || last.opcode == Opcode::HLT) {
+                block.exits = true;
+                fallsThrough = false;
+            } else if (last.opcode == Opcode::CALL) {
+                size_t target = HasDirectTarget(last) ? TargetIndex(last) : NO_BLOCK;
+                if (target != NO_BLOCK) {
+                    size_t callee = mBlockOf[target];
+                    if (std::find(mEntries.begin(), mEntries.end(), callee) == mEntries.end()) {
+                        mEntries.push_back(callee);
+                    }
+                }
+            } else if (last.opcode == Opcode::JMP || IsConditionalBranch(last.opcode)) {
+                size_t target = HasDirectTarget(last) ? TargetIndex(last) : NO_BLOCK;
+                if (target != NO_BLOCK) {
+                    block.successors.push_back(mBlockOf[target]);
+                } else {
+                    block.exits = true;
+                }
+                fallsThrough = last.opcode != Opcode::JMP;
+            }
+
+            if (fallsThrough) {
+                if (block.End() < mInstructions.size()) {
+                    size_t next = b + 1;
+                    if (std::find(block.successors.begin(), block.successors.end(), next) == block.successors.end()) {
+                        block.successors.push_back(next);
+                    }
+                } else {
+                    block.exits = true;     // Runs off the end of the image
+                }
+            }
+        }
+
+        for (size_t b = 0; b < mBlocks.size(); ++b) {
+            for (size_t successor : mBlocks[b].successors) {
+                mBlocks[successor].predecessors.push_back(b);
+            }
+        }
+    }
+
+    void ControlFlowGraph::ComputeOrder() {
+        // Iterative depth-first search from every entry, recording postorder
+        std::vector<size_t> postorder;
+        std::vector<std::pair<size_t, size_t>> stack;   // Block, next successor to visit
+
+        for (size_t entry : mEntries) {
+            if (mBlocks[entry].reachable) {
+                continue;
+            }
+            mBlocks[entry].reachable = true;
+            stack.push_back({entry, 0});
+
+            while (!stack.empty()) {
+                size_t block = stack.back().first;
+                size_t next = stack.back().second;
+                const auto& successors = mBlocks[block].successors;
+                if (next < successors.size()) {
+                    size_t successor = successors[next];
+                    ++stack.back().second;
+                    if (!mBlocks[successor].reachable) {
+                        mBlocks[successor].reachable = true;
+                        stack.push_back({successor, 0});
+                    }
+                } else {
+                    postorder.push_back(block);
+                    stack.pop_back();
+                }
+            }
+        }
+
+        mReversePostorder.assign(postorder.rbegin(), postorder.rend());
+    }
+
+    void ControlFlowGraph::ComputeDominators() {
+        // Cooper, Harvey & Kennedy, "A Simple, Fast Dominance Algorithm", with a virtual
+        // root above all entries so that CALL targets get their own dominator trees
+        size_t count = mBlocks.size();
+        size_t root = count;
+        std::vector<size_t> order(count + 1, 0);    // Postorder number, root highest
+        for (size_t i = 0; i < mReversePostorder.size(); ++i) {
+            order[mReversePostorder[i]] = mReversePostorder.size() - 1 - i;
+        }
+        order[root] = mReversePostorder.size();
+
+        std::vector<size_t> idom(count + 1, NO_BLOCK);
+        idom[root] = root;
+        for (size_t entry : mEntries) {
+            idom[entry] = root;
+        }
+
+        auto intersect = [&](size_t a, size_t b) {
+            while (a != b) {
+                while (order[a] < order[b]) {
+                    a = idom[a];
+                }
+                while (order[b] < order[a]) {
+                    b = idom[b];
+                }
+            }
+            return a;
+        };
+
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (size_t block : mReversePostorder) {
+                if (idom[block] == root) {
+                    continue;
+                }
+
+                size_t newIdom = NO_BLOCK;
+                for (size_t predecessor : mBlocks[block].predecessors) {
+                    if (idom[predecessor] == NO_BLOCK) {
+                        continue;   // Not processed yet, or unreachable
+                    }
+                    newIdom = newIdom == NO_BLOCK ? predecessor : intersect(predecessor, newIdom);
+                }
+                if (newIdom != idom[block]) {
+                    idom[block] = newIdom;
+                    changed = true;
+                }
+            }
+        }
+
+        mIdom.assign(count, NO_BLOCK);
+        for (size_t b = 0; b < count; ++b) {
+            if (idom[b] != root) {
+                mIdom[b] = idom[b];
+            }
+        }
+    }
+
+    bool ControlFlowGraph::Dominates(size_t a, size_t b) const {
+        if (!mBlocks[a].reachable || !mBlocks[b].reachable) {
+            return false;
+        }
+        for (size_t block = b; block != NO_BLOCK; block = mIdom[block]) {
+            if (block == a) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void ControlFlowGraph::FindLoops() {
+        for (size_t header : mReversePostorder) {
+            Loop loop;
+            loop.header = header;
+            for (size_t predecessor : mBlocks[header].predecessors) {
+                if (Dominates(header, predecessor)) {
+                    loop.latches.push_back(predecessor);
+                }
+            }
+            if (loop.latches.empty()) {
+                continue;
+            }
+
+            // Walk backwards from the latches; the header stops the walk
+            std::vector<uint8_t> inLoop(mBlocks.size(), 0);
+            inLoop[header] = 1;
+            std::vector<size_t> work;
+            for (size_t latch : loop.latches) {
+                if (!inLoop[latch]) {
+                    inLoop[latch] = 1;
+                    work.push_back(latch);
+                }
+            }
+            while (!work.empty()) {
+                size_t block = work.back();
+                work.pop_back();
+                for (size_t predecessor : mBlocks[block].predecessors) {
+                    if (!inLoop[predecessor] && mBlocks[predecessor].reachable) {
+                        inLoop[predecessor] = 1;
+                        work.push_back(predecessor);
+                    }
+                }
+            }
+            for (size_t b = 0; b < mBlocks.size(); ++b) {
+                if (inLoop[b]) {
+                    loop.blocks.push_back(b);
+                }
+            }
+
+            loop.countedLoop = true;
+            for (size_t i = 0; i < loop.latches.size(); ++i) {
+                const Instruction& last = mInstructions[mBlocks[loop.latches[i]].Last()];
+                if (last.opcode != Opcode::LOOP || (i > 0 && last.reg1 != loop.counterRegister)) {
+                    loop.countedLoop = false;
+                    break;
+                }
+                loop.counterRegister = last.reg1;
+            }
+            if (!loop.countedLoop) {
+                loop.counterRegister = 0;
+            }
+
+            mLoops.push_back(std::move(loop));
+        }
+
+        // Nesting: the parent is the smallest other loop containing the header
+        for (size_t i = 0; i < mLoops.size(); ++i) {
+            for (size_t j = 0; j < mLoops.size(); ++j) {
+                const Loop& outer = mLoops[j];
+                if (i == j || outer.blocks.size() <= mLoops[i].blocks.size() ||
+                    !std::binary_search(outer.blocks.begin(), outer.blocks.end(), mLoops[i].header)) {
+                    continue;
+                }
+                if (mLoops[i].parent == NO_BLOCK || outer.blocks.size() < mLoops[mLoops[i].parent].blocks.size()) {
+                    mLoops[i].parent = j;
+                }
+            }
+        }
+        for (auto& loop : mLoops) {
+            for (size_t parent = loop.parent; parent != NO_BLOCK; parent = mLoops[parent].parent) {
+                ++loop.depth;
+            }
+        }
+    }
+
+    const Loop* ControlFlowGraph::GetInnermostLoop(size_t block) const {
+        const Loop* innermost = nullptr;
+        for (const auto& loop : mLoops) {
+            if (std::binary_search(loop.blocks.begin(), loop.blocks.end(), block) &&
+                (!innermost || loop.depth > innermost->depth)) {
+                innermost = &loop;
+            }
+        }
+        return innermost;
+    }
+}
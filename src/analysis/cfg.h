@@ -0,0 +1,89 @@
+// src/analysis/cfg.h
+#ifndef VM_CFG_H
+#define VM_CFG_H
+
+#include <common/instruction.h>
+#include <vector>
+
+namespace vm {
+    constexpr size_t NO_BLOCK = static_cast<size_t>(-1);
+
+    // Instruction indices are relative to the start of the code; addresses are
+    // base + index * 8, as laid out by LoadProgram/LoadFirmware. The constant word of a
+    // MOVW keeps its index but is seen as a NOP that cannot be jumped to.
+    struct BasicBlock {
+        size_t start = 0;                   // First instruction index
+        size_t length = 0;
+        std::vector<size_t> successors;     // Block indices (branch target first, then fall-through)
+        std::vector<size_t> predecessors;
+        bool exits = false;                 // Control may leave the analysed code (RET, HLT, fault, indirect jump)
+        bool reachable = false;             // From the entry block or a CALL target
+
+        size_t End() const { return start + length; }
+        size_t Last() const { return start + length - 1; }
+    };
+
+    // Natural loop: a header plus every block that reaches a back edge to it without
+    // passing through the header. Back edges sharing a header form one loop.
+    struct Loop {
+        size_t header = 0;                  // Block index
+        std::vector<size_t> blocks;         // Sorted, includes the header
+        std::vector<size_t> latches;        // Blocks with a back edge to the header
+        size_t parent = NO_BLOCK;           // Innermost enclosing loop (index into GetLoops())
+        size_t depth = 1;
+        bool countedLoop = false;           // Every back edge is a LOOP instruction
+        uint8_t counterRegister = 0;        // LOOP register when countedLoop
+    };
+
+    // Control-flow graph of a code image. CALL is treated as falling through to the
+    // return site; its target is recorded as an additional entry point.
+    class ControlFlowGraph {
+    private:
+        std::vector<Instruction> mInstructions;
+        std::vector<uint8_t> mLiterals;         // MOVW constant words
+        std::vector<BasicBlock> mBlocks;
+        std::vector<size_t> mBlockOf;           // Instruction index -> block index
+        std::vector<size_t> mEntries;           // Entry block, then CALL targets
+        std::vector<size_t> mIdom;              // Immediate dominator per block, NO_BLOCK for roots/unreachable
+        std::vector<size_t> mReversePostorder;  // Reachable blocks
+        std::vector<Loop> mLoops;
+        uint64_t mBase;
+
+        void FindBlocks(const uint64_t* code, size_t count);
+        void LinkBlocks();
+        void ComputeOrder();
+        void ComputeDominators();
+        void FindLoops();
+
+    public:
+        ControlFlowGraph();
+
+        void Build(const uint64_t* code, size_t count, uint64_t base = 0, uint64_t entryPoint = 0);
+        void Build(const std::vector<uint64_t>& code, uint64_t base = 0, uint64_t entryPoint = 0) {
+            Build(code.data(), code.size(), base, entryPoint);
+        }
+
+        // Instruction index of a direct target address, or NO_BLOCK if it is
+        // misaligned, outside the image or the constant of a MOVW
+        size_t TargetIndex(uint64_t address) const;
+        size_t TargetIndex(const Instruction& instr) const { return TargetIndex(immediateValue(instr)); }
+
+        bool Dominates(size_t a, size_t b) const;
+        const Loop* GetInnermostLoop(size_t block) const;
+
+        uint64_t GetBase() const { return mBase; }
+        uint64_t GetAddress(size_t index) const { return mBase + index * sizeof(uint64_t); }
+        size_t GetInstructionCount() const { return mInstructions.size(); }
+        const Instruction& GetInstruction(size_t index) const { return mInstructions[index]; }
+        bool IsLiteral(size_t index) const { return mLiterals[index] != 0; }
+        const std::vector<Instruction>& GetInstructions() const { return mInstructions; }
+        const std::vector<BasicBlock>& GetBlocks() const { return mBlocks; }
+        size_t GetBlockOf(size_t index) const { return mBlockOf[index]; }
+        const std::vector<size_t>& GetEntries() const { return mEntries; }
+        size_t GetImmediateDominator(size_t block) const { return mIdom[block]; }
+        const std::vector<size_t>& GetReversePostorder() const { return mReversePostorder; }
+        const std::vector<Loop>& GetLoops() const { return mLoops; }
+    };
+}
+
+#endif // VM_CFG_H
@@ -0,0 +1,427 @@
+// src/analysis/instruction_effects.cpp
+#include "instruction_effects.h"
+#include <common/instruction.h>
+#include <common/vector.h>
+
+namespace vm {
+    namespace {
+        inline RegisterMask Bit(uint8_t reg) {
+            return static_cast<RegisterMask>(1u << reg);
+        }
+
+        // Registers and memory read by CPU::GetOperandValue for the given operand
+        void AddOperandRead(InstructionEffects& effects, const Instruction& instr, bool isSecondOperand) {
+            uint8_t reg = isSecondOperand ? instr.reg2 : instr.reg1;
+            switch (instr.mode) {
+                case AddressingMode::REGISTER:
+                    effects.regUses |= Bit(reg);
+                    break;
+                case AddressingMode::MEMORY:
+                    effects.readsMemory = true;
+                    effects.mayFault = true;
+                    break;
+                case AddressingMode::REGISTER_INDIRECT:
+                    effects.regUses |= Bit(reg);
+                    effects.readsMemory = true;
+                    effects.mayFault = true;
+                    break;
+                case AddressingMode::BASE_INDEX:
+                    effects.regUses |= Bit(indexRegister(instr));
+                    [[fallthrough]];
+                case AddressingMode::BASE_DISP:
+                    effects.regUses |= Bit(reg);
+                    effects.readsMemory = true;
+                    effects.mayFault = true;
+                    break;
+                case AddressingMode::REGISTER3:
+                    effects.regUses |= Bit(isSecondOperand ? thirdRegister(instr) : instr.reg1);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // Destination written by CPU::SetOperandValue (first operand)
+        void AddOperandWrite(InstructionEffects& effects, const Instruction& instr) {
+            switch (instr.mode) {
+                case AddressingMode::REGISTER:
+                case AddressingMode::IMMEDIATE:
+                    effects.regDefs |= Bit(instr.reg1);
+                    break;
+                case AddressingMode::MEMORY:
+                    effects.writesMemory = true;
+                    effects.mayFault = true;
+                    break;
+                case AddressingMode::REGISTER_INDIRECT:
+                    effects.regUses |= Bit(instr.reg1);
+                    effects.writesMemory = true;
+                    effects.mayFault = true;
+                    break;
+                case AddressingMode::BASE_INDEX:
+                    effects.regUses |= Bit(indexRegister(instr));
+                    [[fallthrough]];
+                case AddressingMode::BASE_DISP:
+                    effects.regUses |= Bit(instr.reg1);
+                    effects.writesMemory = true;
+                    effects.mayFault = true;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        FlagMask ConditionFlags(Opcode opcode) {
+            switch (opcode) {
+                case Opcode::JZ:
+                case Opcode::JNZ:
+                case Opcode::JEQ:
+                case Opcode::JNE:
+                    return FLAG_MASK_ZERO;
+                case Opcode::JC:
+                case Opcode::JNC:
+                    return FLAG_MASK_CARRY;
+                case Opcode::JL:
+                case Opcode::JGE:
+                    return FLAG_MASK_NEGATIVE | FLAG_MASK_OF;
+                case Opcode::JLE:
+                case Opcode::JG:
+                    return FLAG_MASK_ZERO | FLAG_MASK_NEGATIVE | FLAG_MASK_OF;
+                default:
+                    return 0;
+            }
+        }
+    }
+
+    InstructionEffects GetInstructionEffects(const Instruction& instr) {
+        InstructionEffects effects;
+
+        switch (instr.opcode) {
+            case Opcode::MOV:
+                AddOperandRead(effects, instr, true);
+                AddOperandWrite(effects, instr);
+                break;
+
+            case Opcode::LOAD:
+                AddOperandRead(effects, instr, true);
+                effects.regDefs |= Bit(instr.reg1);
+                effects.readsMemory = true;
+                effects.mayFault = true;
+                break;
+
+            case Opcode::STORE:
+                AddOperandRead(effects, instr, false);
+                effects.regUses |= Bit(instr.reg2);
+                effects.writesMemory = true;
+                effects.mayFault = true;
+                break;
+
+            case Opcode::PUSH:
+                AddOperandRead(effects, instr, false);
+                effects.writesMemory = true;
+                effects.usesStack = true;
+                effects.mayFault = true;
+                break;
+
+            case Opcode::POP:
+                effects.regDefs |= Bit(instr.reg1);
+                effects.readsMemory = true;
+                effects.usesStack = true;
+                effects.mayFault = true;
+                break;
+
+            case Opcode::MOVW:
+                effects.regDefs |= Bit(instr.reg1);
+                break;
+
+            case Opcode::ADD:
+            case Opcode::SUB:
+            case Opcode::MUL:
+            case Opcode::AND:
+            case Opcode::OR:
+            case Opcode::XOR:
+            case Opcode::SHL:
+            case Opcode::SHR:
+                effects.regUses |= Bit(aluSource(instr));
+                AddOperandRead(effects, instr, true);
+                effects.regDefs |= Bit(instr.reg1);
+                effects.flagDefs = ALL_FLAGS;
+                break;
+
+            case Opcode::MULH:
+            case Opcode::UMULH:
+            case Opcode::ROL:
+            case Opcode::ROR:
+            case Opcode::PEXT:
+            case Opcode::PDEP:
+            case Opcode::CRC32:
+            case Opcode::HASH:
+                effects.regUses |= Bit(instr.reg1);
+                AddOperandRead(effects, instr, true);
+                effects.regDefs |= Bit(instr.reg1);
+                effects.flagDefs = ALL_FLAGS;
+                break;
+
+            case Opcode::ADC:
+            case Opcode::SBB:
+                effects.regUses |= Bit(instr.reg1);
+                AddOperandRead(effects, instr, true);
+                effects.regDefs |= Bit(instr.reg1);
+                effects.flagUses = FLAG_MASK_CARRY;
+                effects.flagDefs = ALL_FLAGS;
+                break;
+
+            case Opcode::DIVMOD:
+                effects.regUses |= Bit(instr.reg1) | Bit(thirdRegister(instr));
+                effects.regDefs |= Bit(instr.reg1) | Bit(instr.reg2);
+                effects.flagDefs = ALL_FLAGS;
+                effects.mayFault = true;
+                break;
+
+            case Opcode::DIV:
+            case Opcode::MOD:
+            case Opcode::IDIV:
+            case Opcode::IMOD:
+                effects.regUses |= Bit(instr.reg1);
+                AddOperandRead(effects, instr, true);
+                effects.regDefs |= Bit(instr.reg1);
+                effects.flagDefs = ALL_FLAGS;
+                effects.mayFault = true;
+                break;
+
+            case Opcode::POPCNT:
+            case Opcode::CLZ:
+            case Opcode::CTZ:
+                AddOperandRead(effects, instr, true);
+                effects.regDefs |= Bit(instr.reg1);
+                effects.flagDefs = ALL_FLAGS;
+                break;
+
+            case Opcode::CMP:
+                effects.regUses |= Bit(instr.reg1);
+                AddOperandRead(effects, instr, true);
+                effects.flagDefs = ALL_FLAGS;
+                break;
+
+            case Opcode::INC:
+            case Opcode::DEC:
+            case Opcode::NOT:
+            case Opcode::BSWAP:
+                effects.regUses |= Bit(instr.reg1);
+                effects.regDefs |= Bit(instr.reg1);
+                effects.flagDefs = ALL_FLAGS;
+                break;
+
+            case Opcode::SWAP:
+                effects.regUses |= Bit(instr.reg1) | Bit(instr.reg2);
+                effects.regDefs |= Bit(instr.reg1) | Bit(instr.reg2);
+                effects.flagDefs = ALL_FLAGS;
+                break;
+
+            case Opcode::JMP:
+            case Opcode::JZ:
+            case Opcode::JNZ:
+            case Opcode::JEQ:
+            case Opcode::JNE:
+            case Opcode::JC:
+            case Opcode::JNC:
+            case Opcode::JL:
+            case Opcode::JLE:
+            case Opcode::JG:
+            case Opcode::JGE:
+                AddOperandRead(effects, instr, false);
+                effects.flagUses = ConditionFlags(instr.opcode);
+                if (!HasDirectTarget(instr)) {
+                    // Unknown destination: whatever runs next may read anything
+                    effects.regUses = ALL_REGISTERS;
+                    effects.flagUses = ALL_FLAGS;
+                }
+                break;
+
+            case Opcode::LOOP:
+                effects.regUses |= Bit(instr.reg1);
+                AddOperandRead(effects, instr, false);
+                effects.regDefs |= Bit(instr.reg1);
+                effects.flagDefs = ALL_FLAGS;
+                if (!HasDirectTarget(instr)) {
+                    effects.regUses = ALL_REGISTERS;
+                }
+                break;
+
+            case Opcode::CALL:
+            case Opcode::RET:
+                // The callee (or caller) is analysed separately and may read any register or flag
+                AddOperandRead(effects, instr, false);
+                effects.regUses = ALL_REGISTERS;
+                effects.flagUses = ALL_FLAGS;
+                effects.readsMemory = instr.opcode == Opcode::RET;
+                effects.writesMemory = instr.opcode == Opcode::CALL;
+                effects.usesStack = true;
+                effects.mayFault = true;
+                break;
+
+            case Opcode::HLT:
+                // Final register and flag values are part of the run result
+                effects.regUses = ALL_REGISTERS;
+                effects.flagUses = ALL_FLAGS;
+                effects.hasSideEffects = true;
+                break;
+
+            case Opcode::IN:
+                AddOperandRead(effects, instr, true);
+                effects.regDefs |= Bit(instr.reg1);
+                effects.flagDefs = ALL_FLAGS;
+                effects.hasSideEffects = true;
+                break;
+
+            case Opcode::OUT:
+                effects.regUses |= Bit(instr.reg1);
+                effects.hasSideEffects = true;
+                break;
+
+            case Opcode::PRINT:
+                AddOperandRead(effects, instr, false);
+                effects.hasSideEffects = true;
+                break;
+
+            case Opcode::RDCNT:
+                AddOperandRead(effects, instr, true);
+                effects.regDefs |= Bit(instr.reg1);
+                effects.hasSideEffects = true;
+                break;
+
+            case Opcode::HCALL:
+                // Native code reads and writes any register and guest memory
+                AddOperandRead(effects, instr, false);
+                effects.regUses = ALL_REGISTERS;
+                effects.regDefs = ALL_REGISTERS;
+                effects.readsMemory = true;
+                effects.writesMemory = true;
+                effects.mayFault = true;
+                effects.hasSideEffects = true;
+                break;
+
+            case Opcode::BCOPY:
+            case Opcode::BFILL:
+            case Opcode::BCMP:
+            case Opcode::CRC32M: {
+                RegisterMask operands = Bit(instr.reg1) | Bit(instr.reg2) | Bit(thirdRegister(instr));
+                effects.regUses |= operands;
+                effects.regDefs |= instr.opcode == Opcode::BFILL ? Bit(instr.reg1) | Bit(thirdRegister(instr)) : operands;
+                effects.flagDefs = instr.opcode == Opcode::BCMP ? ALL_FLAGS : 0;
+                effects.readsMemory = instr.opcode != Opcode::BFILL;
+                effects.writesMemory = instr.opcode == Opcode::BCOPY || instr.opcode == Opcode::BFILL;
+                effects.mayFault = true;
+                break;
+            }
+
+            case Opcode::VLOAD:
+            case Opcode::VSTORE:
+            case Opcode::VBCAST:
+            case Opcode::VEXTRACT:
+            case Opcode::VINSERT:
+            case Opcode::VADD:
+            case Opcode::VSUB:
+            case Opcode::VMUL:
+            case Opcode::VAND:
+            case Opcode::VOR:
+            case Opcode::VXOR:
+            case Opcode::VSHL:
+            case Opcode::VSHR:
+            case Opcode::VCMPEQ:
+            case Opcode::VCMPGT:
+            case Opcode::VPERM:
+            case Opcode::VMASK:
+            case Opcode::VREDSUM:
+            case Opcode::VREDMIN:
+            case Opcode::VREDMAX:
+                // Only general registers are tracked: vector results count as side effects
+                switch (GetVectorForm(instr.opcode)) {
+                    case VectorForm::LOAD:
+                        effects.regUses |= Bit(instr.reg2);
+                        effects.readsMemory = true;
+                        effects.mayFault = true;
+                        break;
+                    case VectorForm::STORE:
+                        effects.regUses |= Bit(instr.reg1);
+                        effects.writesMemory = true;
+                        effects.mayFault = true;
+                        break;
+                    case VectorForm::BROADCAST:
+                    case VectorForm::INSERT:
+                        effects.regUses |= Bit(instr.reg2);
+                        break;
+                    case VectorForm::EXTRACT:
+                        effects.regDefs |= Bit(instr.reg1);
+                        break;
+                    case VectorForm::REDUCE:
+                        effects.regDefs |= Bit(instr.reg1);
+                        effects.flagDefs = ALL_FLAGS;
+                        break;
+                    default:
+                        break;
+                }
+                effects.hasSideEffects = GetVectorForm(instr.opcode) != VectorForm::EXTRACT &&
+                                         GetVectorForm(instr.opcode) != VectorForm::REDUCE;
+                break;
+
+            case Opcode::NOP:
+                break;
+
+            default:
+                // Invalid opcode: the CPU halts with a fault
+                effects.regUses = ALL_REGISTERS;
+                effects.flagUses = ALL_FLAGS;
+                effects.mayFault = true;
+                effects.hasSideEffects = true;
+                break;
+        }
+        return effects;
+    }
+
+    bool IsConditionalBranch(Opcode opcode) {
+        return ConditionFlags(opcode) != 0 || opcode == Opcode::LOOP;
+    }
+
+    bool IsControlTransfer(Opcode opcode) {
+        return opcode == Opcode::JMP || opcode == Opcode::CALL || opcode == Opcode::RET ||
+               opcode == Opcode::HLT || IsConditionalBranch(opcode);
+    }
+
+    bool HasDirectTarget(const Instruction& instr) {
+        return instr.mode == AddressingMode::IMMEDIATE &&
+               (instr.opcode == Opcode::JMP || instr.opcode == Opcode::CALL || IsConditionalBranch(instr.opcode));
+    }
+
+    bool ReadsCounters(Opcode opcode) {
+        return opcode == Opcode::RDCNT || opcode == Opcode::IN;
+    }
+
+    bool IsBlockOperation(Opcode opcode) {
+        return opcode == Opcode::BCOPY || opcode == Opcode::BFILL || opcode == Opcode::BCMP ||
+               opcode == Opcode::CRC32M;
+    }
+
+    bool TakesThreeRegisters(Opcode opcode) {
+        return IsBlockOperation(opcode) || opcode == Opcode::DIVMOD;
+    }
+
+    bool HasThreeOperandForm(Opcode opcode) {
+        switch (opcode) {
+            case Opcode::ADD:
+            case Opcode::SUB:
+            case Opcode::MUL:
+            case Opcode::AND:
+            case Opcode::OR:
+            case Opcode::XOR:
+            case Opcode::SHL:
+            case Opcode::SHR:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    size_t InstructionWords(Opcode opcode) {
+        return opcode == Opcode::MOVW ? 2 : 1;
+    }
+}
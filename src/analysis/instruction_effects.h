@@ -0,0 +1,48 @@
+// src/analysis/instruction_effects.h
+#ifndef VM_INSTRUCTION_EFFECTS_H
+#define VM_INSTRUCTION_EFFECTS_H
+
+#include <common/types.h>
+
+namespace vm {
+    // Register sets: bit n stands for Rn
+    using RegisterMask = uint16_t;
+    // Flag sets: bit n stands for FlagType n (ZERO, CARRY, NEGATIVE, OF)
+    using FlagMask = uint8_t;
+
+    constexpr RegisterMask ALL_REGISTERS = 0xFFFF;
+    constexpr FlagMask FLAG_MASK_ZERO = 1 << static_cast<uint8_t>(FlagType::ZERO);
+    constexpr FlagMask FLAG_MASK_CARRY = 1 << static_cast<uint8_t>(FlagType::CARRY);
+    constexpr FlagMask FLAG_MASK_NEGATIVE = 1 << static_cast<uint8_t>(FlagType::NEGATIVE);
+    constexpr FlagMask FLAG_MASK_OF = 1 << static_cast<uint8_t>(FlagType::OF);
+    constexpr FlagMask ALL_FLAGS = FLAG_MASK_ZERO | FLAG_MASK_CARRY | FLAG_MASK_NEGATIVE | FLAG_MASK_OF;
+
+    // What an instruction reads and writes, as executed by the CPU. Instructions that leave
+    // the analysed code (CALL, RET, HLT, indirect jumps, faults) are given conservative
+    // effects: everything they could expose to other code counts as used.
+    struct InstructionEffects {
+        RegisterMask regUses = 0;
+        RegisterMask regDefs = 0;
+        FlagMask flagUses = 0;
+        FlagMask flagDefs = 0;
+        bool readsMemory = false;
+        bool writesMemory = false;
+        bool usesStack = false;         // PUSH, POP, CALL, RET
+        bool mayFault = false;          // DIV/MOD by zero, memory access, invalid opcode
+        bool hasSideEffects = false;    // Observable outside registers and memory (I/O, HLT)
+    };
+
+    InstructionEffects GetInstructionEffects(const Instruction& instr);
+
+    // Opcode classification shared by the verifier and the CFG builder
+    bool IsConditionalBranch(Opcode opcode);    // Jcc and LOOP
+    bool IsControlTransfer(Opcode opcode);      // Ends a basic block
+    bool HasDirectTarget(const Instruction& instr);
+    bool ReadsCounters(Opcode opcode);          // RDCNT, IN (cycle counter ports)
+    bool IsBlockOperation(Opcode opcode);       // BCOPY, BFILL, BCMP, CRC32M (three registers, may re-execute)
+    bool TakesThreeRegisters(Opcode opcode);    // Block operations and DIVMOD (third register in the immediate)
+    bool HasThreeOperandForm(Opcode opcode);    // ADD/SUB/MUL/AND/OR/XOR/SHL/SHR, REGISTER3 mode
+    size_t InstructionWords(Opcode opcode);     // 2 for MOVW (64-bit constant in the next word), else 1
+}
+
+#endif // VM_INSTRUCTION_EFFECTS_H
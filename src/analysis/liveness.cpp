@@ -0,0 +1,71 @@
+// src/analysis/liveness.cpp
+#include "liveness.h"
+
+namespace vm {
+    void LivenessAnalysis::Compute(const ControlFlowGraph& cfg) {
+        const auto& blocks = cfg.GetBlocks();
+        size_t count = cfg.GetInstructionCount();
+
+        mEffects.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            mEffects[i] = GetInstructionEffects(cfg.GetInstruction(i));
+        }
+
+        // Block summaries: used before defined (gen) and defined (kill)
+        std::vector<RegisterMask> regGen(blocks.size(), 0);
+        std::vector<RegisterMask> regKill(blocks.size(), 0);
+        std::vector<FlagMask> flagGen(blocks.size(), 0);
+        std::vector<FlagMask> flagKill(blocks.size(), 0);
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            for (size_t i = blocks[b].start; i < blocks[b].End(); ++i) {
+                const InstructionEffects& effects = mEffects[i];
+                regGen[b] |= effects.regUses & ~regKill[b];
+                regKill[b] |= effects.regDefs;
+                flagGen[b] |= effects.flagUses & ~flagKill[b];
+                flagKill[b] |= effects.flagDefs;
+            }
+        }
+
+        mLiveIn.assign(blocks.size(), 0);
+        mLiveOut.assign(blocks.size(), 0);
+        mFlagsIn.assign(blocks.size(), 0);
+        mFlagsOut.assign(blocks.size(), 0);
+
+        // Round-robin to a fixed point, last block first so most edges are seen in order
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (size_t b = blocks.size(); b-- > 0;) {
+                RegisterMask out = blocks[b].exits ? ALL_REGISTERS : 0;
+                FlagMask flagsOut = blocks[b].exits ? ALL_FLAGS : 0;
+                for (size_t successor : blocks[b].successors) {
+                    out |= mLiveIn[successor];
+                    flagsOut |= mFlagsIn[successor];
+                }
+
+                RegisterMask in = regGen[b] | (out & ~regKill[b]);
+                FlagMask flagsIn = flagGen[b] | (flagsOut & ~flagKill[b]);
+                if (in != mLiveIn[b] || out != mLiveOut[b] || flagsIn != mFlagsIn[b] || flagsOut != mFlagsOut[b]) {
+                    mLiveIn[b] = in;
+                    mLiveOut[b] = out;
+                    mFlagsIn[b] = flagsIn;
+                    mFlagsOut[b] = flagsOut;
+                    changed = true;
+                }
+            }
+        }
+
+        mLiveAfter.assign(count, 0);
+        mFlagsAfter.assign(count, 0);
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            RegisterMask live = mLiveOut[b];
+            FlagMask flags = mFlagsOut[b];
+            for (size_t i = blocks[b].End(); i-- > blocks[b].start;) {
+                mLiveAfter[i] = live;
+                mFlagsAfter[i] = flags;
+                live = (live & ~mEffects[i].regDefs) | mEffects[i].regUses;
+                flags = (flags & ~mEffects[i].flagDefs) | mEffects[i].flagUses;
+            }
+        }
+    }
+}
@@ -0,0 +1,47 @@
+// src/analysis/liveness.h
+#ifndef VM_LIVENESS_H
+#define VM_LIVENESS_H
+
+#include "cfg.h"
+#include "instruction_effects.h"
+#include <vector>
+
+namespace vm {
+    // Backward register and flag liveness over a ControlFlowGraph. Everything is
+    // live where control leaves the analysed code, since the caller, the callee or
+    // the final run report may read it.
+    class LivenessAnalysis {
+    private:
+        std::vector<RegisterMask> mLiveIn;          // Per block
+        std::vector<RegisterMask> mLiveOut;
+        std::vector<FlagMask> mFlagsIn;
+        std::vector<FlagMask> mFlagsOut;
+        std::vector<RegisterMask> mLiveAfter;       // Per instruction
+        std::vector<FlagMask> mFlagsAfter;
+        std::vector<InstructionEffects> mEffects;   // Per instruction
+
+    public:
+        void Compute(const ControlFlowGraph& cfg);
+
+        RegisterMask GetLiveIn(size_t block) const { return mLiveIn[block]; }
+        RegisterMask GetLiveOut(size_t block) const { return mLiveOut[block]; }
+        FlagMask GetFlagsLiveIn(size_t block) const { return mFlagsIn[block]; }
+        FlagMask GetFlagsLiveOut(size_t block) const { return mFlagsOut[block]; }
+
+        // Live right after the instruction at the given index executes
+        RegisterMask GetLiveAfter(size_t index) const { return mLiveAfter[index]; }
+        FlagMask GetFlagsLiveAfter(size_t index) const { return mFlagsAfter[index]; }
+        const InstructionEffects& GetEffects(size_t index) const { return mEffects[index]; }
+
+        // The instruction sets flags that nothing reads before they are overwritten
+        bool IsFlagUpdateDead(size_t index) const {
+            return mEffects[index].flagDefs != 0 && (mEffects[index].flagDefs & mFlagsAfter[index]) == 0;
+        }
+        // The instruction writes registers that nothing reads before they are overwritten
+        bool IsRegisterWriteDead(size_t index) const {
+            return mEffects[index].regDefs != 0 && (mEffects[index].regDefs & mLiveAfter[index]) == 0;
+        }
+    };
+}
+
+#endif // VM_LIVENESS_H
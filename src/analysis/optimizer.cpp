@@ -0,0 +1,501 @@
+// src/analysis/optimizer.cpp
+#include "optimizer.h"
+#include "cfg.h"
+#include "liveness.h"
+#include <common/bits.h>
+#include <common/instruction.h>
+#include <cpu/checksum_unit.h>
+#include <cpu/cpu.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <numeric>
+
+namespace vm {
+    namespace {
+        constexpr size_t kMaxPasses = 32;
+        constexpr size_t kMaxThreadHops = 16;
+        constexpr uint64_t kMaxImmediate = 0xFFFFFFFFULL;
+
+        inline uint64_t Encode(const Instruction& instr) {
+            return makeInstruction(instr.opcode, instr.mode, instr.reg1, instr.reg2, instr.immediate) |
+                   static_cast<uint64_t>(instr.extension) << 32;
+        }
+
+        // Replace the immediate field (a jump target), keeping the rest of the word as it was
+        inline uint64_t WithImmediate(uint64_t raw, uint64_t immediate) {
+            return (raw & ~kMaxImmediate) | (immediate & kMaxImmediate);
+        }
+
+        inline Instruction MakeMove(uint8_t destination, uint8_t source, AddressingMode mode, uint64_t immediate) {
+            Instruction instr;
+            instr.opcode = Opcode::MOV;
+            instr.mode = mode;
+            instr.reg1 = destination;
+            instr.reg2 = source;
+            setImmediateValue(instr, immediate);
+            return instr;
+        }
+
+        // Same results as the CPU's Execute* handlers (flags aside)
+        bool Evaluate(Opcode opcode, uint64_t a, uint64_t b, uint64_t& result) {
+            switch (opcode) {
+                case Opcode::ADD: result = a + b; return true;
+                case Opcode::SUB: result = a - b; return true;
+                case Opcode::MUL: result = a * b; return true;
+                case Opcode::MULH:
+                    result = static_cast<uint64_t>((static_cast<__int128>(static_cast<int64_t>(a)) *
+                                                    static_cast<int64_t>(b)) >> 64);
+                    return true;
+                case Opcode::UMULH: result = static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64); return true;
+                case Opcode::AND: result = a & b; return true;
+                case Opcode::OR:  result = a | b; return true;
+                case Opcode::XOR: result = a ^ b; return true;
+                case Opcode::SHL: result = a << (b & 0x3F); return true;
+                case Opcode::SHR: result = a >> (b & 0x3F); return true;
+                case Opcode::ROL: result = std::rotl(a, static_cast<int>(b & 0x3F)); return true;
+                case Opcode::ROR: result = std::rotr(a, static_cast<int>(b & 0x3F)); return true;
+                case Opcode::PEXT: result = bitExtract(a, b); return true;
+                case Opcode::PDEP: result = bitDeposit(a, b); return true;
+                case Opcode::CRC32: result = ChecksumUnit::Crc32cWord(static_cast<uint32_t>(a), b); return true;
+                case Opcode::HASH: result = ChecksumUnit::Hash(a, b); return true;
+                case Opcode::INC: result = a + 1; return true;
+                case Opcode::DEC: result = a - 1; return true;
+                case Opcode::NOT: result = ~a; return true;
+                case Opcode::BSWAP: result = __builtin_bswap64(a); return true;
+                default: return false;
+            }
+        }
+
+        bool IsBinaryAlu(Opcode opcode) {
+            switch (opcode) {
+                case Opcode::ADD:
+                case Opcode::SUB:
+                case Opcode::MUL:
+                case Opcode::MULH:
+                case Opcode::UMULH:
+                case Opcode::AND:
+                case Opcode::OR:
+                case Opcode::XOR:
+                case Opcode::SHL:
+                case Opcode::SHR:
+                case Opcode::ROL:
+                case Opcode::ROR:
+                case Opcode::PEXT:
+                case Opcode::PDEP:
+                case Opcode::CRC32:
+                case Opcode::HASH:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        bool IsIndirectTransfer(const Instruction& instr) {
+            bool targeted = instr.opcode == Opcode::JMP || instr.opcode == Opcode::CALL ||
+                            IsConditionalBranch(instr.opcode);
+            return targeted && !HasDirectTarget(instr);
+        }
+
+        // Register contents known at a point in a basic block
+        struct KnownValues {
+            std::array<bool, REGISTER_COUNT> known{};
+            std::array<uint64_t, REGISTER_COUNT> value{};
+
+            bool Holds(uint8_t reg, uint64_t constant) const { return known[reg] && value[reg] == constant; }
+            void Set(uint8_t reg, uint64_t constant) { known[reg] = true; value[reg] = constant; }
+            void Forget(RegisterMask registers) {
+                for (size_t reg = 0; reg < REGISTER_COUNT; ++reg) {
+                    if (registers & (1u << reg)) {
+                        known[reg] = false;
+                    }
+                }
+            }
+        };
+    }
+
+    PeepholeOptimizer::PeepholeOptimizer() : mBase(0), mOriginalCount(0), mRelocatable(true) {
+    }
+
+    OptimizerStats PeepholeOptimizer::Optimize(std::vector<uint64_t>& code, uint64_t base, uint64_t& entryPoint) {
+        OptimizerStats stats;
+        mBase = base;
+        mOriginalCount = code.size();
+        mRelocation.resize(code.size() + 1);
+        std::iota(mRelocation.begin(), mRelocation.end(), size_t(0));
+
+        mRelocatable = true;
+        std::vector<uint8_t> constants(code.size(), 0);     // MOVW constant words
+        std::vector<uint64_t> targets;
+        for (size_t i = 0; i < code.size(); ++i) {
+            Instruction instr = decodeInstruction(code[i]);
+            if (IsIndirectTransfer(instr)) {
+                mRelocatable = false;
+            } else if (HasDirectTarget(instr)) {
+                targets.push_back(immediateValue(instr));
+            }
+            if (InstructionWords(instr.opcode) == 2 && i + 1 < code.size()) {
+                constants[++i] = 1;
+            }
+        }
+        stats.relocatable = mRelocatable;
+        stats.instructionsBefore = code.size();
+        stats.instructionsAfter = code.size();
+
+        // A jump into the constant of a MOVW runs it as an instruction, which the analyses do not model
+        for (uint64_t target : targets) {
+            uint64_t offset = target - base;
+            if (target >= base && offset % sizeof(uint64_t) == 0 && offset / sizeof(uint64_t) < code.size() &&
+                constants[offset / sizeof(uint64_t)]) {
+                return stats;
+            }
+        }
+
+        std::vector<uint8_t> remove;
+        while (stats.passes < kMaxPasses && !code.empty()) {
+            remove.assign(code.size(), 0);
+            bool changed = Simplify(code, entryPoint, remove, stats);
+            if (!changed) {
+                // Liveness is recomputed on the simplified code before anything is deleted
+                changed = RemoveDeadCode(code, entryPoint, remove, stats);
+            }
+            if (!changed) {
+                break;
+            }
+            Compact(code, entryPoint, remove);
+            ++stats.passes;
+        }
+
+        stats.instructionsAfter = code.size();
+        return stats;
+    }
+
+    bool PeepholeOptimizer::Simplify(std::vector<uint64_t>& code, uint64_t entryPoint, std::vector<uint8_t>& remove,
+                                     OptimizerStats& stats) {
+        ControlFlowGraph cfg;
+        cfg.Build(code, mBase, entryPoint);
+        LivenessAnalysis liveness;
+        liveness.Compute(cfg);
+
+        bool changed = false;
+        auto drop = [&](size_t index) {
+            if (mRelocatable || cfg.GetInstruction(index).opcode != Opcode::NOP) {
+                remove[index] = 1;
+                changed = true;
+            }
+        };
+
+        // Jump threading: skip over unconditional jumps, drop jumps to the next instruction
+        for (size_t i = 0; i < code.size(); ++i) {
+            const Instruction& instr = cfg.GetInstruction(i);
+            size_t target = HasDirectTarget(instr) ? cfg.TargetIndex(instr) : NO_BLOCK;
+            if (target == NO_BLOCK) {
+                continue;
+            }
+
+            size_t final = target;
+            std::vector<size_t> visited{i, target};
+            while (visited.size() < kMaxThreadHops) {
+                const Instruction& next = cfg.GetInstruction(final);
+                size_t nextTarget = next.opcode == Opcode::JMP && HasDirectTarget(next) ? cfg.TargetIndex(next) : NO_BLOCK;
+                if (nextTarget == NO_BLOCK || std::find(visited.begin(), visited.end(), nextTarget) != visited.end()) {
+                    break;
+                }
+                final = nextTarget;
+                visited.push_back(final);
+            }
+
+            if (final != target) {
+                code[i] = WithImmediate(code[i], cfg.GetAddress(final));
+                ++stats.jumpsThreaded;
+                changed = true;
+            } else if (target == i + 1 && instr.opcode != Opcode::CALL && instr.opcode != Opcode::LOOP) {
+                drop(i);
+                ++stats.jumpsThreaded;
+            }
+        }
+
+        std::vector<Instruction> current(cfg.GetInstructions());
+        for (const auto& block : cfg.GetBlocks()) {
+            KnownValues values;
+            size_t previous = NO_BLOCK;     // Last instruction kept in this block
+
+            for (size_t i = block.start; i < block.End(); ++i) {
+                if (remove[i] || IsControlTransfer(current[i].opcode)) {
+                    continue;
+                }
+
+                Instruction& instr = current[i];
+                FlagMask flagsAfter = liveness.GetFlagsLiveAfter(i);
+                bool modified = false;
+
+                if (instr.opcode == Opcode::MOV && instr.mode == AddressingMode::REGISTER) {
+                    if (instr.reg1 == instr.reg2 ||
+                        (values.known[instr.reg2] && values.Holds(instr.reg1, values.value[instr.reg2]))) {
+                        drop(i);
+                        ++stats.movesRemoved;
+                        continue;
+                    }
+                    if (values.known[instr.reg2] && fitsImmediate(values.value[instr.reg2])) {
+                        instr = MakeMove(instr.reg1, 0, AddressingMode::IMMEDIATE, values.value[instr.reg2]);
+                        ++stats.constantsFolded;
+                        modified = true;
+                    } else {
+                        values.known[instr.reg1] = values.known[instr.reg2];
+                        values.value[instr.reg1] = values.value[instr.reg2];
+                    }
+                }
+
+                if (instr.opcode == Opcode::MOV && instr.mode == AddressingMode::IMMEDIATE) {
+                    if (values.Holds(instr.reg1, immediateValue(instr))) {
+                        drop(i);
+                        ++stats.movesRemoved;
+                        continue;
+                    }
+                    values.Set(instr.reg1, immediateValue(instr));
+                } else if (instr.opcode == Opcode::MOVW && i + 1 < code.size() && cfg.IsLiteral(i + 1)) {
+                    // The constant word always goes with its MOVW
+                    uint64_t constant = code[i + 1];
+                    if (values.Holds(instr.reg1, constant)) {
+                        remove[i] = remove[i + 1] = 1;
+                        changed = true;
+                        ++stats.movesRemoved;
+                        continue;
+                    }
+                    if (mRelocatable && fitsImmediate(constant)) {
+                        instr = MakeMove(instr.reg1, 0, AddressingMode::IMMEDIATE, constant);
+                        remove[i + 1] = 1;
+                        ++stats.constantsFolded;
+                        modified = true;
+                    }
+                    values.Set(instr.reg1, constant);
+                } else if (IsBinaryAlu(instr.opcode)) {
+                    const Instruction* before = previous != NO_BLOCK ? &current[previous] : nullptr;
+
+                    if (instr.mode == AddressingMode::REGISTER && values.known[instr.reg2] &&
+                        fitsImmediate(values.value[instr.reg2])) {
+                        setImmediateValue(instr, values.value[instr.reg2]);
+                        instr.mode = AddressingMode::IMMEDIATE;
+                        instr.reg2 = 0;
+                        ++stats.constantsFolded;
+                        modified = true;
+                    } else if (instr.mode == AddressingMode::REGISTER && HasThreeOperandForm(instr.opcode) && before &&
+                               before->opcode == Opcode::MOV && before->mode == AddressingMode::REGISTER &&
+                               before->reg1 == instr.reg1) {
+                        // MOV d, a; OP d, b  ->  OP d, a, b (where b was d, it held a)
+                        uint8_t second = instr.reg2 == instr.reg1 ? before->reg2 : instr.reg2;
+                        instr.mode = AddressingMode::REGISTER3;
+                        instr.reg2 = before->reg2;
+                        setImmediateValue(instr, second);
+                        drop(previous);
+                        ++stats.movesMerged;
+                        modified = true;
+                    }
+
+                    uint64_t result = 0;
+                    if (instr.mode == AddressingMode::REGISTER3) {
+                        uint8_t second = thirdRegister(instr);
+                        if (values.known[instr.reg2] && values.known[second] &&
+                            Evaluate(instr.opcode, values.value[instr.reg2], values.value[second], result)) {
+                            if (flagsAfter == 0 && fitsImmediate(result)) {
+                                instr = MakeMove(instr.reg1, 0, AddressingMode::IMMEDIATE, result);
+                                ++stats.constantsFolded;
+                                modified = true;
+                            }
+                            values.Set(instr.reg1, result);
+                        } else {
+                            values.known[instr.reg1] = false;
+                        }
+                    } else if (instr.mode != AddressingMode::IMMEDIATE) {
+                        values.known[instr.reg1] = false;
+                    } else if (values.known[instr.reg1] &&
+                               Evaluate(instr.opcode, values.value[instr.reg1], immediateValue(instr), result)) {
+                        // Fully known: a MOV gives the same register, but leaves the flags alone
+                        if (flagsAfter == 0 && fitsImmediate(result)) {
+                            instr = MakeMove(instr.reg1, 0, AddressingMode::IMMEDIATE, result);
+                            ++stats.constantsFolded;
+                            modified = true;
+                        }
+                        values.Set(instr.reg1, result);
+                    } else {
+                        uint64_t factor = immediateValue(instr);
+
+                        if (instr.opcode == Opcode::MUL && factor > 1 && (factor & (factor - 1)) == 0 &&
+                            (flagsAfter & (FLAG_MASK_CARRY | FLAG_MASK_OF)) == 0) {
+                            // Z and N depend only on the result; C and OF differ between MUL and SHL
+                            instr.opcode = Opcode::SHL;
+                            setImmediateValue(instr, std::countr_zero(factor));
+                            ++stats.strengthReduced;
+                            modified = true;
+                        } else if (instr.opcode == Opcode::MUL && factor == 1 && flagsAfter == 0) {
+                            drop(i);
+                            ++stats.strengthReduced;
+                            continue;
+                        } else if ((instr.opcode == Opcode::ADD || instr.opcode == Opcode::SUB) && before &&
+                                   before->opcode == instr.opcode && before->mode == AddressingMode::IMMEDIATE &&
+                                   before->reg1 == instr.reg1 && liveness.GetFlagsLiveAfter(previous) == 0 &&
+                                   (flagsAfter & FLAG_MASK_CARRY) == 0 &&
+                                   fitsImmediate(immediateValue(*before) + immediateValue(instr))) {
+                            // r += a; r += b  ->  r += a + b (only the carry of the merged step differs)
+                            setImmediateValue(instr, immediateValue(*before) + immediateValue(instr));
+                            drop(previous);
+                            ++stats.constantsFolded;
+                            modified = true;
+                        }
+                        values.known[instr.reg1] = false;
+                    }
+                } else if (instr.opcode == Opcode::INC || instr.opcode == Opcode::DEC || instr.opcode == Opcode::NOT ||
+                           instr.opcode == Opcode::BSWAP) {
+                    uint64_t result = 0;
+                    if (values.known[instr.reg1] && Evaluate(instr.opcode, values.value[instr.reg1], 0, result)) {
+                        if (flagsAfter == 0 && fitsImmediate(result)) {
+                            instr = MakeMove(instr.reg1, 0, AddressingMode::IMMEDIATE, result);
+                            ++stats.constantsFolded;
+                            modified = true;
+                        }
+                        values.Set(instr.reg1, result);
+                    } else {
+                        values.known[instr.reg1] = false;
+                    }
+                } else if (instr.opcode == Opcode::SWAP) {
+                    std::swap(values.known[instr.reg1], values.known[instr.reg2]);
+                    std::swap(values.value[instr.reg1], values.value[instr.reg2]);
+                } else if (instr.opcode == Opcode::PUSH &&
+                           (instr.mode == AddressingMode::REGISTER || instr.mode == AddressingMode::IMMEDIATE) &&
+                           i + 1 < block.End() && !remove[i + 1] && current[i + 1].opcode == Opcode::POP) {
+                    // PUSH x; POP r  ->  MOV r, x
+                    uint8_t destination = current[i + 1].reg1;
+                    drop(i + 1);
+                    ++stats.stackPairs;
+                    if (instr.mode == AddressingMode::REGISTER && instr.reg1 == destination) {
+                        drop(i);
+                        continue;
+                    }
+                    if (instr.mode == AddressingMode::REGISTER) {
+                        instr = MakeMove(destination, instr.reg1, AddressingMode::REGISTER, 0);
+                        values.known[destination] = values.known[instr.reg2];
+                        values.value[destination] = values.value[instr.reg2];
+                    } else {
+                        instr = MakeMove(destination, 0, AddressingMode::IMMEDIATE, immediateValue(instr));
+                        values.Set(destination, immediateValue(instr));
+                    }
+                    modified = true;
+                } else if (instr.opcode != Opcode::MOV || instr.mode != AddressingMode::REGISTER) {
+                    values.Forget(GetInstructionEffects(instr).regDefs);
+                }
+
+                if (modified) {
+                    code[i] = Encode(instr);
+                    changed = true;
+                }
+                previous = i;
+            }
+        }
+        return changed;
+    }
+
+    bool PeepholeOptimizer::RemoveDeadCode(const std::vector<uint64_t>& code, uint64_t entryPoint,
+                                           std::vector<uint8_t>& remove, OptimizerStats& stats) {
+        ControlFlowGraph cfg;
+        cfg.Build(code, mBase, entryPoint);
+        LivenessAnalysis liveness;
+        liveness.Compute(cfg);
+
+        bool changed = false;
+        for (const auto& block : cfg.GetBlocks()) {
+            if (!block.reachable && mRelocatable) {
+                std::fill(remove.begin() + block.start, remove.begin() + block.End(), 1);
+                stats.unreachableRemoved += block.length;
+                changed = true;
+                continue;
+            }
+
+            for (size_t i = block.start; i < block.End(); ++i) {
+                if (cfg.IsLiteral(i)) {
+                    continue;   // Removed with its MOVW
+                }
+                const Instruction& instr = cfg.GetInstruction(i);
+                const InstructionEffects& effects = liveness.GetEffects(i);
+                bool removable = IsValidOpcode(instr.opcode) && !IsControlTransfer(instr.opcode) &&
+                                 !effects.hasSideEffects && !effects.writesMemory && !effects.usesStack &&
+                                 !effects.mayFault && (effects.regDefs & liveness.GetLiveAfter(i)) == 0 &&
+                                 (effects.flagDefs & liveness.GetFlagsLiveAfter(i)) == 0;
+                if (removable && (mRelocatable || instr.opcode != Opcode::NOP)) {
+                    remove[i] = 1;
+                    if (i + 1 < code.size() && cfg.IsLiteral(i + 1)) {
+                        remove[i + 1] = 1;
+                    }
+                    ++stats.deadRemoved;
+                    changed = true;
+                }
+            }
+        }
+        return changed;
+    }
+
+    void PeepholeOptimizer::Compact(std::vector<uint64_t>& code, uint64_t& entryPoint,
+                                    const std::vector<uint8_t>& remove) {
+        if (!mRelocatable) {
+            // Targets may be computed at run time: keep every address where it is
+            for (size_t i = 0; i < code.size(); ++i) {
+                if (remove[i]) {
+                    code[i] = makeInstruction(Opcode::NOP, AddressingMode::REGISTER, 0, 0, 0);
+                }
+            }
+            return;
+        }
+
+        // newIndex[i]: where instruction i (or the first kept one after it) ends up
+        std::vector<size_t> newIndex(code.size() + 1);
+        size_t kept = 0;
+        for (size_t i = 0; i < code.size(); ++i) {
+            newIndex[i] = kept;
+            kept += !remove[i];
+        }
+        newIndex[code.size()] = kept;
+
+        auto relocate = [&](uint64_t address, uint64_t& relocated) {
+            uint64_t offset = address - mBase;
+            if (address < mBase || offset % sizeof(uint64_t) != 0 || offset / sizeof(uint64_t) > code.size()) {
+                return false;
+            }
+            relocated = mBase + newIndex[offset / sizeof(uint64_t)] * sizeof(uint64_t);
+            return true;
+        };
+
+        std::vector<uint64_t> compacted;
+        compacted.reserve(kept);
+        bool constant = false;      // code[i] is the constant word of a MOVW
+        for (size_t i = 0; i < code.size(); ++i) {
+            uint64_t word = code[i];
+            Instruction instr = decodeInstruction(word);
+            bool literal = constant;
+            constant = !literal && InstructionWords(instr.opcode) == 2;
+            if (remove[i]) {
+                continue;
+            }
+            uint64_t target;
+            if (!literal && HasDirectTarget(instr) && relocate(immediateValue(instr), target)) {
+                word = WithImmediate(word, target);
+            }
+            compacted.push_back(word);
+        }
+        code.swap(compacted);
+
+        uint64_t entry;
+        if (relocate(entryPoint, entry)) {
+            entryPoint = entry;
+        }
+        for (auto& index : mRelocation) {
+            index = newIndex[index];
+        }
+    }
+
+    uint64_t PeepholeOptimizer::Relocate(uint64_t address) const {
+        uint64_t offset = address - mBase;
+        if (address < mBase || offset % sizeof(uint64_t) != 0 || offset / sizeof(uint64_t) > mOriginalCount) {
+            return address;
+        }
+        return mBase + mRelocation[offset / sizeof(uint64_t)] * sizeof(uint64_t);
+    }
+}
@@ -0,0 +1,59 @@
+// src/analysis/optimizer.h
+#ifndef VM_OPTIMIZER_H
+#define VM_OPTIMIZER_H
+
+#include <common/types.h>
+#include <vector>
+
+namespace vm {
+    struct OptimizerStats {
+        size_t instructionsBefore = 0;
+        size_t instructionsAfter = 0;
+        size_t passes = 0;
+        size_t constantsFolded = 0;     // ALU results and register operands turned into immediates
+        size_t movesRemoved = 0;        // MOV r, r and MOVs of a value the register already holds
+        size_t movesMerged = 0;         // MOV d, a; OP d, b turned into the three-operand OP d, a, b
+        size_t stackPairs = 0;          // PUSH/POP pairs turned into a MOV or removed
+        size_t strengthReduced = 0;     // MUL by a power of two turned into SHL
+        size_t jumpsThreaded = 0;       // Targets moved past JMPs, jumps to the next instruction removed
+        size_t deadRemoved = 0;         // Results nothing reads (liveness)
+        size_t unreachableRemoved = 0;
+        bool relocatable = true;        // False when the code has indirect jumps/calls
+    };
+
+    // Semantics-preserving peephole optimizer over a code image loaded at base.
+    //
+    // Rounds alternate between local rewrites (constant folding, redundant MOVs, MOVs
+    // merged into three-operand ALU forms, PUSH/POP pairs, MUL strength reduction, jump
+    // threading) and dead/unreachable code
+    // removal driven by the ControlFlowGraph and LivenessAnalysis, until nothing changes.
+    // Final register and flag values stay those of the original program; stack slots
+    // written by removed PUSH/POP pairs and the performance counters do not.
+    //
+    // Removing instructions moves code, so direct jump/call targets and the entry point
+    // are relocated. Code with register-indirect jumps or calls may compute targets the
+    // optimizer cannot see: there, removed instructions become NOPs instead.
+    class PeepholeOptimizer {
+    private:
+        std::vector<size_t> mRelocation;    // Original instruction index -> current index
+        uint64_t mBase;
+        size_t mOriginalCount;
+        bool mRelocatable;
+
+        bool Simplify(std::vector<uint64_t>& code, uint64_t entryPoint, std::vector<uint8_t>& remove,
+                      OptimizerStats& stats);
+        bool RemoveDeadCode(const std::vector<uint64_t>& code, uint64_t entryPoint,
+                            std::vector<uint8_t>& remove, OptimizerStats& stats);
+        void Compact(std::vector<uint64_t>& code, uint64_t& entryPoint, const std::vector<uint8_t>& remove);
+
+    public:
+        PeepholeOptimizer();
+
+        OptimizerStats Optimize(std::vector<uint64_t>& code, uint64_t base, uint64_t& entryPoint);
+
+        // New address of an address in the original code (e.g. a symbol); others are unchanged
+        uint64_t Relocate(uint64_t address) const;
+    };
+}
+
+#endif // VM_OPTIMIZER_H
@@ -0,0 +1,57 @@
+// src/analysis/verifier.cpp
+#include "verifier.h"
+#include "cfg.h"
+#include "instruction_effects.h"
+#include <cpu/cpu.h>
+#include <sstream>
+
+namespace vm {
+    VerificationReport FirmwareVerifier::Verify(const uint64_t* code, size_t count, uint64_t base) {
+        VerificationReport report;
+        report.instructionCount = count;
+
+        ControlFlowGraph cfg;
+        cfg.Build(code, count, base, base);
+
+        std::vector<uint8_t> valid(count, 1);
+        for (size_t i = 0; i < count; ++i) {
+            const Instruction& instr = cfg.GetInstruction(i);
+            if (!IsValidOpcode(instr.opcode)) {
+                std::ostringstream message;
+                message << "invalid opcode 0x" << std::hex << static_cast<int>(instr.opcode);
+                report.issues.push_back({cfg.GetAddress(i), message.str()});
+                valid[i] = 0;
+            } else if (HasDirectTarget(instr) && cfg.TargetIndex(instr) == NO_BLOCK) {
+                std::ostringstream message;
+                message << OpcodeToString(instr.opcode) << " target 0x" << std::hex << immediateValue(instr)
+                        << " is outside the image, misaligned or inside a MOVW";
+                report.issues.push_back({cfg.GetAddress(i), message.str()});
+                valid[i] = 0;
+            } else if (InstructionWords(instr.opcode) == 2 && i + 1 == count) {
+                report.issues.push_back({cfg.GetAddress(i), "MOVW is missing its constant word"});
+                valid[i] = 0;
+            }
+        }
+
+        for (const auto& block : cfg.GetBlocks()) {
+            size_t start = block.start;
+            bool verified = true;
+            for (size_t i = block.start; i < block.End(); ++i) {
+                verified = verified && valid[i];
+                Opcode opcode = cfg.GetInstruction(i).opcode;
+                // MOVW steps over its constant, so it ends a run and the next one starts after the constant
+                size_t words = cfg.IsLiteral(i) ? 0 : InstructionWords(opcode);
+                if (ReadsCounters(opcode) || IsBlockOperation(opcode) || words == 2 || i + 1 == block.End()) {
+                    if (i + 1 > start) {
+                        report.blocks.push_back({start, i + 1 - start, verified});
+                        report.verifiedBlocks += verified;
+                    }
+                    start = i + words;
+                    verified = true;
+                }
+            }
+        }
+
+        return report;
+    }
+}
@@ -0,0 +1,50 @@
+// src/analysis/verifier.h
+#ifndef VM_VERIFIER_H
+#define VM_VERIFIER_H
+
+#include <common/types.h>
+#include <string>
+#include <vector>
+
+namespace vm {
+    struct VerifierIssue {
+        uint64_t address;
+        std::string message;
+    };
+
+    // Basic block in instruction indices relative to the start of the code
+    struct VerifiedBlock {
+        size_t start;
+        size_t length;
+        bool verified;       // Every instruction valid, direct targets in range and aligned
+    };
+
+    struct VerificationReport {
+        size_t instructionCount = 0;
+        size_t verifiedBlocks = 0;
+        std::vector<VerifiedBlock> blocks;
+        std::vector<VerifierIssue> issues;
+
+        bool IsValid() const { return issues.empty(); }
+    };
+
+    // Load-time static checks over a code image loaded at base.
+    //
+    // Blocks are the basic blocks of the ControlFlowGraph, further split after
+    // instructions that read the performance counters (RDCNT, IN) so that
+    // block-level counter updates stay exact, after the bulk memory
+    // instructions, which step the PC back onto themselves until they are done,
+    // and after MOVW, which steps over its constant word (part of no block).
+    // A block is verified when all of its opcodes are implemented and its direct
+    // target (if any) is an aligned address inside the image; verified blocks run
+    // without per-instruction fetch or opcode checks.
+    class FirmwareVerifier {
+    public:
+        static VerificationReport Verify(const uint64_t* code, size_t count, uint64_t base);
+        static VerificationReport Verify(const std::vector<uint64_t>& code, uint64_t base = 0) {
+            return Verify(code.data(), code.size(), base);
+        }
+    };
+}
+
+#endif // VM_VERIFIER_H
@@ -0,0 +1,144 @@
+// src/api/guest_runtime.cpp
+#include "guest_runtime.h"
+#include <common/instruction.h>
+#include <exception>
+
+namespace vm {
+    GuestRuntime::GuestRuntime(size_t memorySize)
+        : mMachine(memorySize), mEntryPoint(0), mReturnAddress(memorySize - sizeof(uint64_t)), mLoaded(false) {
+        GetConsole().SetMuted(true);
+    }
+
+    bool GuestRuntime::LoadImage(const void* data, size_t size) noexcept {
+        try {
+            mMachine.Reset();
+            mSymbols.clear();
+
+            MappedFirmware firmware;
+            if (!firmware.OpenMemory(data, size) || !firmware.VerifyChecksums()) {
+                mLastError = firmware.GetError();
+                return Finish(false);
+            }
+            if (!mMachine.LoadFirmware(firmware)) {
+                mLastError = mMachine.GetLastError();
+                return Finish(false);
+            }
+            mSymbols = firmware.GetSymbols();
+            mEntryPoint = firmware.GetEntryPoint();
+            return Finish(true);
+        } catch (const std::exception& e) {
+            mLastError = e.what();
+            return Finish(false);
+        }
+    }
+
+    bool GuestRuntime::LoadFile(const std::string& filename) noexcept {
+        try {
+            mMachine.Reset();
+            mSymbols.clear();
+
+            MappedFirmware firmware;
+            if (!firmware.Open(filename) || !firmware.VerifyChecksums()) {
+                mLastError = firmware.GetError();
+                return Finish(false);
+            }
+            if (!mMachine.LoadFirmware(firmware, filename)) {
+                mLastError = mMachine.GetLastError();
+                return Finish(false);
+            }
+            mSymbols = firmware.GetSymbols();
+            mEntryPoint = firmware.GetEntryPoint();
+            return Finish(true);
+        } catch (const std::exception& e) {
+            mLastError = e.what();
+            return Finish(false);
+        }
+    }
+
+    bool GuestRuntime::LoadCode(const uint64_t* code, size_t count, uint64_t address) noexcept {
+        try {
+            mMachine.Reset();
+            mSymbols.clear();
+            if (!code || !mMachine.LoadProgram(std::vector<uint64_t>(code, code + count), address)) {
+                mLastError = mMachine.GetLastError().empty() ? "Cannot load code" : mMachine.GetLastError();
+                return Finish(false);
+            }
+            mEntryPoint = address;
+            return Finish(true);
+        } catch (const std::exception& e) {
+            mLastError = e.what();
+            return Finish(false);
+        }
+    }
+
+    // Common tail of the Load* methods: plant the return stub
+    bool GuestRuntime::Finish(bool loaded) noexcept {
+        mLoaded = false;
+        if (!loaded) {
+            return false;
+        }
+
+        try {
+            mMachine.GetMemory().Write64(mReturnAddress, makeInstruction(Opcode::HLT, AddressingMode::REGISTER, 0, 0, 0));
+        } catch (const std::exception& e) {
+            mLastError = std::string("No writable stack slot for the return stub: ") + e.what();
+            return false;
+        }
+        mLastError.clear();
+        mLoaded = true;
+        return true;
+    }
+
+    CallResult GuestRuntime::Call(uint64_t address, const uint64_t* arguments, size_t count) noexcept {
+        CallResult result{CallStatus::OK, 0, 0};
+        if (!mLoaded) {
+            mLastError = "No image loaded";
+            result.status = CallStatus::NOT_LOADED;
+            return result;
+        }
+        if (count > REGISTER_COUNT || (count > 0 && !arguments)) {
+            mLastError = "Too many arguments";
+            result.status = CallStatus::BAD_ARGUMENTS;
+            return result;
+        }
+
+        CPU& cpu = mMachine.GetCPU();
+        uint64_t instructions = cpu.GetCounter(CounterType::INSTRUCTIONS);
+        uint64_t faults = cpu.GetCounter(CounterType::FAULTS);
+
+        try {
+            for (size_t i = 0; i < count; ++i) {
+                cpu.SetRegister(static_cast<uint8_t>(i), arguments[i]);
+            }
+            // Fresh stack below the stub, return address on top
+            uint64_t stackPointer = mReturnAddress - 2 * sizeof(uint64_t);
+            mMachine.GetMemory().Write64(stackPointer, mReturnAddress);
+            cpu.SetSP(stackPointer);
+            cpu.SetPC(address);
+            cpu.Run();
+        } catch (const std::exception& e) {
+            cpu.Halt();
+            mLastError = e.what();
+            result.status = CallStatus::FAULT;
+        }
+
+        result.value = cpu.GetRegister(0);
+        result.instructions = cpu.GetCounter(CounterType::INSTRUCTIONS) - instructions;
+        if (result.status == CallStatus::OK && cpu.GetPC() != mReturnAddress + sizeof(uint64_t)) {
+            bool faulted = cpu.GetCounter(CounterType::FAULTS) != faults;
+            result.status = faulted ? CallStatus::FAULT : CallStatus::HALTED;
+            mLastError = faulted ? "Guest fault" : "Guest halted before returning";
+        }
+        return result;
+    }
+
+    bool GuestRuntime::FindSymbol(std::string_view name, uint64_t& address) const noexcept {
+        for (const auto& symbol : mSymbols) {
+            if (symbol.name == name) {
+                address = symbol.address;
+                return true;
+            }
+        }
+        return false;
+    }
+}
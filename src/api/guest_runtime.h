@@ -0,0 +1,70 @@
+// src/api/guest_runtime.h
+#ifndef VM_GUEST_RUNTIME_H
+#define VM_GUEST_RUNTIME_H
+
+#include <common/types.h>
+#include <vm/firmware_format.h>
+#include <vm/vm.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vm {
+    // Outcome of GuestRuntime::Call (values shared with vm_status in vm_api.h)
+    enum class CallStatus : uint8_t {
+        OK = 0,             // The routine returned; the result is in R0
+        HALTED = 1,         // HLT before returning
+        FAULT = 2,          // Memory fault, division by zero or invalid instruction
+        NOT_LOADED = 3,     // No image loaded
+        BAD_ARGUMENTS = 4   // More arguments than registers
+    };
+
+    struct CallResult {
+        CallStatus status;
+        uint64_t value;         // R0 after the call
+        uint64_t instructions;  // Retired by this call
+    };
+
+    // Embedding interface: load an image once, then call guest routines as functions.
+    //
+    // Arguments go in R0..R(n-1) and the result comes back in R0. Call() pushes the
+    // address of a HLT word kept in the top stack slot as the return address, so the
+    // routine's RET stops the CPU without any per-instruction check. Registers, flags and
+    // memory persist from one call to the next. The console starts muted, and no method
+    // lets an exception escape.
+    class GuestRuntime {
+    private:
+        VirtualMachine mMachine;
+        std::vector<FirmwareSymbol> mSymbols;
+        uint64_t mEntryPoint;
+        uint64_t mReturnAddress;
+        bool mLoaded;
+        std::string mLastError;
+
+        bool Finish(bool loaded) noexcept;
+
+    public:
+        static constexpr size_t DEFAULT_MEMORY_SIZE = 4 * 1024 * 1024;
+
+        explicit GuestRuntime(size_t memorySize = DEFAULT_MEMORY_SIZE);
+
+        // Load a firmware image (any format) held in memory, or from a file
+        bool LoadImage(const void* data, size_t size) noexcept;
+        bool LoadFile(const std::string& filename) noexcept;
+        // Load raw instruction words
+        bool LoadCode(const uint64_t* code, size_t count, uint64_t address = 0) noexcept;
+
+        CallResult Call(uint64_t address, const uint64_t* arguments = nullptr, size_t count = 0) noexcept;
+
+        bool FindSymbol(std::string_view name, uint64_t& address) const noexcept;
+        uint64_t GetEntryPoint() const { return mEntryPoint; }
+        bool IsLoaded() const { return mLoaded; }
+        const std::string& GetLastError() const { return mLastError; }
+
+        VirtualMachine& GetMachine() { return mMachine; }
+        const VirtualMachine& GetMachine() const { return mMachine; }
+        Console& GetConsole() { return mMachine.GetCPU().GetConsole(); }
+    };
+}
+
+#endif // VM_GUEST_RUNTIME_H
@@ -0,0 +1,178 @@
+// src/api/vm_api.cpp
+#include "vm_api.h"
+#include "guest_runtime.h"
+#include <exception>
+#include <new>
+#include <vector>
+
+namespace {
+    // C callbacks receive the frame as an opaque vm_host_frame
+    struct HostAdapter {
+        vm_host_fn function;
+        void* context;
+    };
+}
+
+struct vm_runtime {
+    vm::GuestRuntime runtime;
+    vm_output_fn output;
+    void* outputContext;
+    std::vector<HostAdapter> hosts;  // Indexed like the HCALL table
+
+    explicit vm_runtime(size_t memorySize) : runtime(memorySize), output(nullptr), outputContext(nullptr) {}
+};
+
+namespace {
+    vm::HostCallFrame& ToFrame(vm_host_frame* frame) {
+        return *reinterpret_cast<vm::HostCallFrame*>(frame);
+    }
+
+    void ForwardOutput(void* context, vm::ConsoleChannel channel, uint64_t value) {
+        vm_runtime* runtime = static_cast<vm_runtime*>(context);
+        runtime->output(runtime->outputContext, static_cast<vm_channel>(channel), value);
+    }
+
+    void ForwardHostCall(void* context, vm::HostCallFrame& frame) {
+        const HostAdapter* adapter = static_cast<const HostAdapter*>(context);
+        adapter->function(adapter->context, reinterpret_cast<vm_host_frame*>(&frame));
+    }
+}
+
+extern "C" {
+    vm_runtime* vm_runtime_create(size_t memory_size) {
+        try {
+            return new vm_runtime(memory_size ? memory_size : vm::GuestRuntime::DEFAULT_MEMORY_SIZE);
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+    void vm_runtime_destroy(vm_runtime* runtime) {
+        delete runtime;
+    }
+
+    vm_status vm_runtime_load_image(vm_runtime* runtime, const void* data, size_t size) {
+        if (!runtime || !data) {
+            return VM_BAD_ARGUMENTS;
+        }
+        return runtime->runtime.LoadImage(data, size) ? VM_OK : VM_LOAD_FAILED;
+    }
+
+    vm_status vm_runtime_load_file(vm_runtime* runtime, const char* path) {
+        if (!runtime || !path) {
+            return VM_BAD_ARGUMENTS;
+        }
+        try {
+            return runtime->runtime.LoadFile(path) ? VM_OK : VM_LOAD_FAILED;
+        } catch (const std::bad_alloc&) {
+            return VM_OUT_OF_MEMORY;
+        }
+    }
+
+    vm_status vm_runtime_call(vm_runtime* runtime, uint64_t address, const uint64_t* args, size_t arg_count,
+                              uint64_t* result) {
+        if (!runtime) {
+            return VM_BAD_ARGUMENTS;
+        }
+        vm::CallResult call = runtime->runtime.Call(address, args, arg_count);
+        if (result) {
+            *result = call.value;
+        }
+        return static_cast<vm_status>(call.status);
+    }
+
+    int vm_runtime_find_symbol(const vm_runtime* runtime, const char* name, uint64_t* address) {
+        uint64_t value = 0;
+        if (!runtime || !name || !runtime->runtime.FindSymbol(name, value)) {
+            return 0;
+        }
+        if (address) {
+            *address = value;
+        }
+        return 1;
+    }
+
+    uint64_t vm_runtime_entry_point(const vm_runtime* runtime) {
+        return runtime ? runtime->runtime.GetEntryPoint() : 0;
+    }
+
+    uint64_t vm_runtime_get_register(const vm_runtime* runtime, unsigned index) {
+        if (!runtime || index >= vm::REGISTER_COUNT) {
+            return 0;
+        }
+        return runtime->runtime.GetMachine().GetCPU().GetRegister(static_cast<uint8_t>(index));
+    }
+
+    void vm_runtime_set_output(vm_runtime* runtime, vm_output_fn output, void* context) {
+        if (!runtime) {
+            return;
+        }
+        runtime->output = output;
+        runtime->outputContext = context;
+        vm::Console& console = runtime->runtime.GetConsole();
+        console.SetHandlers(output ? ForwardOutput : nullptr, nullptr, runtime);
+        console.SetMuted(output == nullptr);
+    }
+
+    vm_status vm_runtime_register_host(vm_runtime* runtime, unsigned index, const char* name, vm_host_fn fn,
+                                       void* context) {
+        if (!runtime || index >= vm::HostCallTable::MAX_FUNCTIONS) {
+            return VM_BAD_ARGUMENTS;
+        }
+        try {
+            vm::VirtualMachine& machine = runtime->runtime.GetMachine();
+            if (!fn) {
+                machine.UnregisterHostFunction(index);
+                return VM_OK;
+            }
+            if (index >= runtime->hosts.size()) {
+                // Grown once up front: the table keeps pointers to the adapters
+                runtime->hosts.resize(vm::HostCallTable::MAX_FUNCTIONS);
+            }
+            runtime->hosts[index] = {fn, context};
+            machine.RegisterHostFunction(index, name ? name : "", ForwardHostCall, &runtime->hosts[index]);
+            return VM_OK;
+        } catch (const std::bad_alloc&) {
+            return VM_OUT_OF_MEMORY;
+        }
+    }
+
+    uint64_t vm_host_get_register(const vm_host_frame* frame, unsigned index) {
+        if (!frame || index >= vm::REGISTER_COUNT) {
+            return 0;
+        }
+        return reinterpret_cast<const vm::HostCallFrame*>(frame)->GetRegister(static_cast<uint8_t>(index));
+    }
+
+    void vm_host_set_register(vm_host_frame* frame, unsigned index, uint64_t value) {
+        if (frame && index < vm::REGISTER_COUNT) {
+            ToFrame(frame).SetRegister(static_cast<uint8_t>(index), value);
+        }
+    }
+
+    void* vm_host_memory(vm_host_frame* frame, uint64_t address, size_t size, int writable) {
+        if (!frame) {
+            return nullptr;
+        }
+        vm::HostCallFrame& hostFrame = ToFrame(frame);
+        try {
+            if (writable) {
+                return hostFrame.Write(address, size);
+            }
+            return const_cast<uint8_t*>(hostFrame.Read(address, size));
+        } catch (const std::exception& e) {
+            hostFrame.Fault(e.what());
+            return nullptr;
+        }
+    }
+
+    void vm_host_fault(vm_host_frame* frame, const char* message) {
+        if (frame) {
+            ToFrame(frame).Fault(message ? message : "");
+        }
+    }
+
+    const char* vm_runtime_last_error(const vm_runtime* runtime) {
+        return runtime ? runtime->runtime.GetLastError().c_str() : "";
+    }
+}
@@ -0,0 +1,82 @@
+/* src/api/vm_api.h */
+#ifndef VM_API_H
+#define VM_API_H
+
+/*
+ * C interface of libvm. A vm_runtime owns one virtual machine; load an image into it,
+ * then call guest routines with up to 16 arguments in R0..R15, the result coming back
+ * in R0. Calls on one runtime must not overlap; separate runtimes are independent.
+ * Nothing is printed and no C++ exception crosses this interface.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct vm_runtime vm_runtime;
+
+typedef enum vm_status {
+    VM_OK = 0,
+    VM_HALTED = 1,          /* The routine executed HLT instead of returning */
+    VM_FAULT = 2,           /* Memory fault, division by zero or invalid instruction */
+    VM_NOT_LOADED = 3,
+    VM_BAD_ARGUMENTS = 4,
+    VM_LOAD_FAILED = 5,
+    VM_OUT_OF_MEMORY = 6
+} vm_status;
+
+typedef enum vm_channel {
+    VM_CHANNEL_PRINT = 0,   /* PRINT */
+    VM_CHANNEL_SCREEN = 1,  /* OUT port 0 */
+    VM_CHANNEL_SERIAL = 2   /* OUT port 1 */
+} vm_channel;
+
+typedef void (*vm_output_fn)(void* context, vm_channel channel, uint64_t value);
+
+/* Host function reached by HCALL <index>: arguments in R0..R15, result in R0 */
+typedef struct vm_host_frame vm_host_frame;
+typedef void (*vm_host_fn)(void* context, vm_host_frame* frame);
+
+/* memory_size 0 selects the default (4 MiB). Returns NULL when out of memory. */
+vm_runtime* vm_runtime_create(size_t memory_size);
+void vm_runtime_destroy(vm_runtime* runtime);
+
+/* Load a .vmfw image (v1, v2 or compressed v2) from memory or from a file */
+vm_status vm_runtime_load_image(vm_runtime* runtime, const void* data, size_t size);
+vm_status vm_runtime_load_file(vm_runtime* runtime, const char* path);
+
+/* Call the routine at address; result may be NULL */
+vm_status vm_runtime_call(vm_runtime* runtime, uint64_t address, const uint64_t* args, size_t arg_count,
+                          uint64_t* result);
+
+/* Address of a symbol from the image's symbol table; returns 0 if there is none */
+int vm_runtime_find_symbol(const vm_runtime* runtime, const char* name, uint64_t* address);
+uint64_t vm_runtime_entry_point(const vm_runtime* runtime);
+uint64_t vm_runtime_get_register(const vm_runtime* runtime, unsigned index);
+
+/* Receive PRINT/OUT values; NULL mutes the console again (the default) */
+void vm_runtime_set_output(vm_runtime* runtime, vm_output_fn output, void* context);
+
+/* Register fn as HCALL <index> (index < 4096); registrations survive reloads. fn NULL unregisters. */
+vm_status vm_runtime_register_host(vm_runtime* runtime, unsigned index, const char* name, vm_host_fn fn,
+                                   void* context);
+
+/* Inside a host function: registers, and guest memory [address, address + size) as a pointer.
+ * vm_host_memory returns NULL (and fails the HCALL) if the range is not accessible. */
+uint64_t vm_host_get_register(const vm_host_frame* frame, unsigned index);
+void vm_host_set_register(vm_host_frame* frame, unsigned index, uint64_t value);
+void* vm_host_memory(vm_host_frame* frame, uint64_t address, size_t size, int writable);
+/* Make the HCALL fail: the call returns VM_FAULT with this message */
+void vm_host_fault(vm_host_frame* frame, const char* message);
+
+/* Message for the last failed load or call, "" if none */
+const char* vm_runtime_last_error(const vm_runtime* runtime);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VM_API_H */
@@ -0,0 +1,999 @@
+// src/asm/assembler.cpp
+#include "assembler.h"
+#include <analysis/instruction_effects.h>
+#include <common/instruction.h>
+#include <common/vector.h>
+#include <cpu/cpu.h>
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+namespace vm {
+    namespace {
+        constexpr uint64_t kImmediateMask = 0xFFFFFFFFULL;
+        constexpr uint64_t kWideImmediateMask = (uint64_t(1) << IMMEDIATE_BITS) - 1;     // IMMEDIATE mode
+
+        inline bool IsIdentifierStart(char c) {
+            return std::isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+        }
+
+        inline bool IsIdentifierChar(char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+        }
+
+        // Two's complement values down to -2^(bits-1) are accepted as well
+        inline bool FitsBits(uint64_t value, unsigned bits) {
+            uint64_t limit = (uint64_t(1) << bits) - 1;
+            return value <= limit || value >= ~(limit >> 1);
+        }
+
+        bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+            if (a.size() != b.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < a.size(); ++i) {
+                if (std::toupper(static_cast<unsigned char>(a[i])) != std::toupper(static_cast<unsigned char>(b[i]))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // FNV-1a, good enough for identifiers and cheap on short names
+        uint32_t HashName(std::string_view name) {
+            uint32_t hash = 2166136261U;
+            for (char c : name) {
+                hash = (hash ^ static_cast<uint8_t>(c)) * 16777619U;
+            }
+            return hash;
+        }
+
+        bool ParseRegister(std::string_view name, uint8_t& reg) {
+            if (name.size() < 2 || name.size() > 3 || (name[0] != 'R' && name[0] != 'r')) {
+                return false;
+            }
+            unsigned value = 0;
+            for (size_t i = 1; i < name.size(); ++i) {
+                if (!std::isdigit(static_cast<unsigned char>(name[i]))) {
+                    return false;
+                }
+                value = value * 10 + static_cast<unsigned>(name[i] - '0');
+            }
+            if (value >= REGISTER_COUNT) {
+                return false;
+            }
+            reg = static_cast<uint8_t>(value);
+            return true;
+        }
+
+        bool ParseVectorRegister(std::string_view name, uint8_t& reg) {
+            if (name.size() < 2 || name.size() > 3 || (name[0] != 'V' && name[0] != 'v')) {
+                return false;
+            }
+            unsigned value = 0;
+            for (size_t i = 1; i < name.size(); ++i) {
+                if (!std::isdigit(static_cast<unsigned char>(name[i]))) {
+                    return false;
+                }
+                value = value * 10 + static_cast<unsigned>(name[i] - '0');
+            }
+            if (value >= VECTOR_REGISTER_COUNT) {
+                return false;
+            }
+            reg = static_cast<uint8_t>(value);
+            return true;
+        }
+
+        // Element size suffix of a vector mnemonic ("32" in VADD.32) as a size code
+        bool ParseElementSize(std::string_view suffix, unsigned& sizeCode) {
+            static const char* const kSizes[] = {"8", "16", "32", "64"};
+            for (unsigned code = 0; code < 4; ++code) {
+                if (suffix == kSizes[code]) {
+                    sizeCode = code;
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    bool LookupMnemonic(std::string_view mnemonic, Opcode& opcode) {
+        // Built once from OpcodeToString, so new opcodes are picked up automatically
+        static const std::unordered_map<std::string, Opcode> table = [] {
+            std::unordered_map<std::string, Opcode> mnemonics;
+            for (int value = 0; value < 256; ++value) {
+                Opcode candidate = static_cast<Opcode>(value);
+                if (IsValidOpcode(candidate)) {
+                    mnemonics.emplace(OpcodeToString(candidate), candidate);
+                }
+            }
+            return mnemonics;
+        }();
+
+        char upper[16];
+        if (mnemonic.size() >= sizeof(upper)) {
+            return false;
+        }
+        for (size_t i = 0; i < mnemonic.size(); ++i) {
+            upper[i] = static_cast<char>(std::toupper(static_cast<unsigned char>(mnemonic[i])));
+        }
+        auto it = table.find(std::string(upper, mnemonic.size()));
+        if (it == table.end()) {
+            return false;
+        }
+        opcode = it->second;
+        return true;
+    }
+
+    // Position within one source line
+    class Assembler::Cursor {
+    private:
+        std::string_view mText;
+        size_t mPosition;
+
+    public:
+        explicit Cursor(std::string_view text) : mText(text), mPosition(0) {}
+
+        void SkipSpace() {
+            while (mPosition < mText.size() && (mText[mPosition] == ' ' || mText[mPosition] == '\t' ||
+                                                mText[mPosition] == '\r')) {
+                ++mPosition;
+            }
+        }
+
+        bool AtEnd() {
+            SkipSpace();
+            return mPosition >= mText.size();
+        }
+
+        char Peek() {
+            SkipSpace();
+            return mPosition < mText.size() ? mText[mPosition] : '\0';
+        }
+
+        // Next character without skipping spaces first
+        char Raw() const { return mPosition < mText.size() ? mText[mPosition] : '\0'; }
+        void Advance() { ++mPosition; }
+
+        bool Accept(char c) {
+            if (Peek() != c) {
+                return false;
+            }
+            ++mPosition;
+            return true;
+        }
+
+        std::string_view Identifier() {
+            SkipSpace();
+            size_t start = mPosition;
+            if (mPosition < mText.size() && IsIdentifierStart(mText[mPosition])) {
+                while (mPosition < mText.size() && IsIdentifierChar(mText[mPosition])) {
+                    ++mPosition;
+                }
+            }
+            return mText.substr(start, mPosition - start);
+        }
+
+        bool Number(uint64_t& value) {
+            SkipSpace();
+            unsigned base = 10;
+            if (mPosition + 1 < mText.size() && mText[mPosition] == '0') {
+                char prefix = static_cast<char>(std::tolower(static_cast<unsigned char>(mText[mPosition + 1])));
+                if (prefix == 'x' || prefix == 'b' || prefix == 'o') {
+                    base = prefix == 'x' ? 16 : prefix == 'b' ? 2 : 8;
+                    mPosition += 2;
+                }
+            }
+
+            size_t start = mPosition;
+            value = 0;
+            while (mPosition < mText.size()) {
+                char c = static_cast<char>(std::tolower(static_cast<unsigned char>(mText[mPosition])));
+                unsigned digit;
+                if (c >= '0' && c <= '9') {
+                    digit = static_cast<unsigned>(c - '0');
+                } else if (c >= 'a' && c <= 'f') {
+                    digit = static_cast<unsigned>(c - 'a' + 10);
+                } else if (c == '_') {
+                    ++mPosition;
+                    continue;
+                } else {
+                    break;
+                }
+                if (digit >= base || value > (UINT64_MAX - digit) / base) {
+                    return false;
+                }
+                value = value * base + digit;
+                ++mPosition;
+            }
+            return mPosition > start && !IsIdentifierChar(Raw());
+        }
+
+        void SkipToEnd() { mPosition = mText.size(); }
+        size_t GetPosition() const { return mPosition; }
+        void SetPosition(size_t position) { mPosition = position; }
+    };
+
+    Assembler::Assembler() : mSection(Section::CODE), mLine(0), mCodePlaced(false), mDataPlaced(false) {
+    }
+
+    void Assembler::Reset() {
+        mImage = FirmwareImage();
+        mSymbols.clear();
+        mSymbolSlots.clear();
+        mFixups.clear();
+        mErrors.clear();
+        mSection = Section::CODE;
+        mLine = 0;
+        mCodePlaced = false;
+        mDataPlaced = false;
+        mEntry = Expression();
+    }
+
+    bool Assembler::AssembleFile(const std::string& filename) {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            Reset();
+            mSourceName = filename;
+            Error(0, "cannot open file");
+            return false;
+        }
+
+        std::string source(static_cast<size_t>(file.tellg()), '\0');
+        file.seekg(0);
+        file.read(source.data(), static_cast<std::streamsize>(source.size()));
+        return Assemble(std::move(source), filename);
+    }
+
+    bool Assembler::Assemble(std::string source, const std::string& sourceName) {
+        Reset();
+        mSource = std::move(source);
+        mSourceName = sourceName;
+        mImage.code.reserve(mSource.size() / 16);
+
+        std::string_view text(mSource);
+        size_t start = 0;
+        while (start < text.size()) {
+            size_t end = text.find('\n', start);
+            if (end == std::string_view::npos) {
+                end = text.size();
+            }
+            ++mLine;
+            AssembleLine(text.substr(start, end - start));
+            start = end + 1;
+        }
+
+        ResolveFixups();
+        std::stable_sort(mErrors.begin(), mErrors.end(),
+                         [](const AssemblerError& a, const AssemblerError& b) { return a.line < b.line; });
+
+        mImage.symbols.reserve(mSymbols.size());
+        for (const auto& symbol : mSymbols) {
+            if (symbol.label) {
+                mImage.symbols.push_back({std::string(symbol.name), symbol.value});
+            }
+        }
+        // Labels usually arrive in address order already
+        auto byAddress = [](const FirmwareSymbol& a, const FirmwareSymbol& b) { return a.address < b.address; };
+        if (!std::is_sorted(mImage.symbols.begin(), mImage.symbols.end(), byAddress)) {
+            std::stable_sort(mImage.symbols.begin(), mImage.symbols.end(), byAddress);
+        }
+        return mErrors.empty();
+    }
+
+    void Assembler::AssembleLine(std::string_view line) {
+        // Strip the comment (';' or "//"), ignoring separators inside quotes
+        char quote = '\0';
+        for (size_t i = 0; i < line.size(); ++i) {
+            char c = line[i];
+            if (quote) {
+                if (c == '\\') {
+                    ++i;
+                } else if (c == quote) {
+                    quote = '\0';
+                }
+            } else if (c == '"' || c == '\'') {
+                quote = c;
+            } else if (c == ';' || (c == '/' && i + 1 < line.size() && line[i + 1] == '/')) {
+                line = line.substr(0, i);
+                break;
+            }
+        }
+
+        Cursor cursor(line);
+        while (!cursor.AtEnd()) {
+            std::string_view name = cursor.Identifier();
+            if (name.empty()) {
+                Error(std::string("unexpected character '") + cursor.Peek() + "'");
+                return;
+            }
+
+            if (cursor.Raw() == ':') {
+                // Label, possibly followed by a statement on the same line
+                cursor.Advance();
+                uint64_t address = mSection == Section::CODE ? mImage.codeAddress + mImage.code.size() * sizeof(uint64_t)
+                                                             : mImage.dataAddress + mImage.data.size();
+                (mSection == Section::CODE ? mCodePlaced : mDataPlaced) = true;
+                DefineSymbol(name, address, true);
+                continue;
+            }
+
+            size_t errors = mErrors.size();
+            if (cursor.Accept('=')) {
+                Expression value;
+                if (ParseExpression(cursor, value)) {
+                    if (!value.symbol.empty()) {
+                        Error("constant '" + std::string(name) + "' uses undefined symbol '" + std::string(value.symbol) + "'");
+                    } else {
+                        DefineSymbol(name, value.value, false);
+                    }
+                }
+            } else if (name[0] == '.') {
+                AssembleDirective(name, cursor);
+            } else {
+                // Vector mnemonics carry the element size: VADD.32
+                size_t dot = name.find('.');
+                std::string_view suffix = dot == std::string_view::npos ? std::string_view() : name.substr(dot + 1);
+                Opcode opcode;
+                if (!LookupMnemonic(name.substr(0, dot), opcode) ||
+                    (dot != std::string_view::npos && GetVectorForm(opcode) == VectorForm::NONE)) {
+                    Error("unknown instruction '" + std::string(name) + "'");
+                    return;
+                }
+                if (GetVectorForm(opcode) != VectorForm::NONE) {
+                    AssembleVector(opcode, suffix, cursor);
+                } else {
+                    AssembleInstruction(opcode, cursor);
+                }
+            }
+
+            if (mErrors.size() == errors && !cursor.AtEnd()) {
+                Error("unexpected text after statement");
+            }
+            return;
+        }
+    }
+
+    const Assembler::Symbol* Assembler::FindSymbol(std::string_view name) const {
+        if (mSymbolSlots.empty()) {
+            return nullptr;
+        }
+        uint32_t hash = HashName(name);
+        size_t mask = mSymbolSlots.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            const SymbolSlot& slot = mSymbolSlots[i];
+            if (slot.index == 0) {
+                return nullptr;
+            }
+            if (slot.hash == hash && mSymbols[slot.index - 1].name == name) {
+                return &mSymbols[slot.index - 1];
+            }
+        }
+    }
+
+    void Assembler::DefineSymbol(std::string_view name, uint64_t value, bool label) {
+        if (const Symbol* existing = FindSymbol(name)) {
+            Error("symbol '" + std::string(name) + "' already defined on line " + std::to_string(existing->line));
+            return;
+        }
+
+        // Grow at half load; slots keep their hash, so rehashing never touches the names
+        if ((mSymbols.size() + 1) * 2 > mSymbolSlots.size()) {
+            std::vector<SymbolSlot> slots(std::max<size_t>(1024, mSymbolSlots.size() * 2), SymbolSlot{0, 0});
+            size_t mask = slots.size() - 1;
+            for (const SymbolSlot& slot : mSymbolSlots) {
+                if (slot.index != 0) {
+                    size_t i = slot.hash & mask;
+                    while (slots[i].index != 0) {
+                        i = (i + 1) & mask;
+                    }
+                    slots[i] = slot;
+                }
+            }
+            mSymbolSlots.swap(slots);
+        }
+
+        uint32_t hash = HashName(name);
+        size_t mask = mSymbolSlots.size() - 1;
+        size_t i = hash & mask;
+        while (mSymbolSlots[i].index != 0) {
+            i = (i + 1) & mask;
+        }
+        mSymbols.push_back({name, value, mLine, label});
+        mSymbolSlots[i] = {hash, static_cast<uint32_t>(mSymbols.size())};
+    }
+
+    bool Assembler::ParseExpression(Cursor& cursor, Expression& expression) {
+        expression = Expression();
+        expression.line = mLine;
+
+        bool negative = cursor.Accept('-');
+        if (!negative) {
+            cursor.Accept('+');
+        }
+
+        for (;;) {
+            uint64_t term = 0;
+            char c = cursor.Peek();
+
+            if (std::isdigit(static_cast<unsigned char>(c))) {
+                if (!cursor.Number(term)) {
+                    Error("invalid number");
+                    return false;
+                }
+            } else if (c == '\'') {
+                cursor.Advance();
+                std::string text;
+                if (cursor.Raw() == '\\') {
+                    cursor.SetPosition(cursor.GetPosition() - 1);
+                    // Reuse the string escape rules for 'x' literals
+                    if (!ParseString(cursor, text) || text.size() != 1) {
+                        Error("invalid character literal");
+                        return false;
+                    }
+                } else {
+                    text.assign(1, cursor.Raw());
+                    cursor.Advance();
+                    if (cursor.Raw() != '\'') {
+                        Error("invalid character literal");
+                        return false;
+                    }
+                    cursor.Advance();
+                }
+                term = static_cast<uint8_t>(text[0]);
+            } else if (IsIdentifierStart(c)) {
+                std::string_view name = cursor.Identifier();
+                uint8_t reg;
+                if (ParseRegister(name, reg) || ParseVectorRegister(name, reg)) {
+                    Error("register " + std::string(name) + " used in an expression");
+                    return false;
+                }
+
+                if (const Symbol* symbol = FindSymbol(name)) {
+                    term = symbol->value;
+                } else if (negative || !expression.symbol.empty()) {
+                    Error("undefined symbol '" + std::string(name) + "' can only be added once");
+                    return false;
+                } else {
+                    expression.symbol = name;   // Resolved by a fixup
+                }
+            } else {
+                Error("expected a number or symbol");
+                return false;
+            }
+
+            expression.value = negative ? expression.value - term : expression.value + term;
+            if (cursor.Accept('+')) {
+                negative = false;
+            } else if (cursor.Accept('-')) {
+                negative = true;
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool Assembler::ParseString(Cursor& cursor, std::string& text) {
+        char quote = cursor.Peek();
+        if (quote != '"' && quote != '\'') {
+            Error("expected a string");
+            return false;
+        }
+        cursor.Advance();
+
+        for (;;) {
+            char c = cursor.Raw();
+            if (c == '\0') {
+                Error("unterminated string");
+                return false;
+            }
+            cursor.Advance();
+            if (c == quote) {
+                return true;
+            }
+            if (c != '\\') {
+                text.push_back(c);
+                continue;
+            }
+
+            char escape = cursor.Raw();
+            cursor.Advance();
+            switch (escape) {
+                case 'n': text.push_back('\n'); break;
+                case 't': text.push_back('\t'); break;
+                case 'r': text.push_back('\r'); break;
+                case '0': text.push_back('\0'); break;
+                case '\\': case '"': case '\'': text.push_back(escape); break;
+                case 'x': {
+                    int value = 0;
+                    for (int digit = 0; digit < 2; ++digit) {
+                        char h = static_cast<char>(std::tolower(static_cast<unsigned char>(cursor.Raw())));
+                        if (!std::isxdigit(static_cast<unsigned char>(h))) {
+                            Error("invalid \\x escape");
+                            return false;
+                        }
+                        value = value * 16 + (std::isdigit(static_cast<unsigned char>(h)) ? h - '0' : h - 'a' + 10);
+                        cursor.Advance();
+                    }
+                    text.push_back(static_cast<char>(value));
+                    break;
+                }
+                default:
+                    Error(std::string("unknown escape '\\") + escape + "'");
+                    return false;
+            }
+        }
+    }
+
+    bool Assembler::ParseOperand(Cursor& cursor, Operand& operand) {
+        operand.reg = 0;
+        operand.index = 0;
+        operand.scaleShift = 0;
+        operand.expression = Expression();
+        size_t start = cursor.GetPosition();
+
+        if (cursor.Accept('#')) {
+            operand.kind = OperandKind::IMMEDIATE;
+            return ParseExpression(cursor, operand.expression);
+        }
+
+        if (cursor.Accept('[')) {
+            size_t inner = cursor.GetPosition();
+            if (ParseRegister(cursor.Identifier(), operand.reg)) {
+                operand.kind = OperandKind::INDIRECT;
+                if (!ParseAddressOffset(cursor, operand)) {
+                    return false;
+                }
+            } else {
+                cursor.SetPosition(inner);
+                operand.kind = OperandKind::MEMORY;
+                if (!ParseExpression(cursor, operand.expression)) {
+                    return false;
+                }
+            }
+            if (!cursor.Accept(']')) {
+                Error("expected ']'");
+                return false;
+            }
+            return true;
+        }
+
+        std::string_view name = cursor.Identifier();
+        if (ParseRegister(name, operand.reg)) {
+            operand.kind = OperandKind::REGISTER;
+            return true;
+        }
+        if (ParseVectorRegister(name, operand.reg)) {
+            operand.kind = OperandKind::VECTOR;
+            return true;
+        }
+
+        // Bare value: JMP loop, CALL 0x40
+        cursor.SetPosition(start);
+        operand.kind = OperandKind::IMMEDIATE;
+        return ParseExpression(cursor, operand.expression);
+    }
+
+    // [Rn + disp], [Rn - disp], [Rn + Ri*scale + disp]: what follows the base register
+    bool Assembler::ParseAddressOffset(Cursor& cursor, Operand& operand) {
+        char sign = cursor.Peek();
+        if (sign != '+' && sign != '-') {
+            return true;
+        }
+
+        size_t offset = cursor.GetPosition();
+        if (cursor.Accept('+')) {
+            if (ParseRegister(cursor.Identifier(), operand.index)) {
+                operand.kind = OperandKind::BASE_INDEX;
+                if (cursor.Accept('*')) {
+                    uint64_t scale = 0;
+                    if (!cursor.Number(scale) || (scale != 1 && scale != 2 && scale != 4 && scale != 8)) {
+                        Error("index scale must be 1, 2, 4 or 8");
+                        return false;
+                    }
+                    operand.scaleShift = static_cast<uint8_t>(std::countr_zero(scale));
+                }
+                sign = cursor.Peek();
+                if (sign != '+' && sign != '-') {
+                    return true;
+                }
+            } else {
+                cursor.SetPosition(offset);
+            }
+        }
+
+        if (operand.kind == OperandKind::INDIRECT) {
+            operand.kind = OperandKind::BASE_DISP;
+        }
+        return ParseExpression(cursor, operand.expression);
+    }
+
+    void Assembler::AssembleInstruction(Opcode opcode, Cursor& cursor) {
+        if (mSection != Section::CODE) {
+            Error("instruction outside the code section");
+            return;
+        }
+
+        Operand operands[3];
+        size_t count = 0;
+        if (!cursor.AtEnd()) {
+            do {
+                if (count == 3) {
+                    Error("too many operands");
+                    return;
+                }
+                if (!ParseOperand(cursor, operands[count++])) {
+                    return;
+                }
+            } while (cursor.Accept(','));
+        }
+
+        // The operand forms select the addressing mode and fill reg1, reg2 and the immediate
+        AddressingMode mode = AddressingMode::REGISTER;
+        uint8_t reg1 = 0;
+        uint8_t reg2 = 0;
+        uint8_t reg3 = 0;
+        uint64_t extension = 0;
+        const Expression* immediate = nullptr;
+        bool valid = count == 3 ? TakesThreeRegisters(opcode) || HasThreeOperandForm(opcode) : !TakesThreeRegisters(opcode);
+
+        // [Rn + disp] and [Rn + Ri*scale + disp] carry the displacement as immediate
+        auto isBase = [](const Operand& operand) {
+            return operand.kind == OperandKind::BASE_DISP || operand.kind == OperandKind::BASE_INDEX;
+        };
+        auto useBase = [&](const Operand& operand) {
+            mode = operand.kind == OperandKind::BASE_DISP ? AddressingMode::BASE_DISP : AddressingMode::BASE_INDEX;
+            immediate = &operand.expression;
+            if (operand.kind == OperandKind::BASE_INDEX) {
+                extension = makeIndexExtension(operand.index, operand.scaleShift);
+            }
+        };
+
+        auto kindOf = [&](size_t index) { return operands[index].kind; };
+        if (count == 1) {
+            switch (kindOf(0)) {
+                case OperandKind::REGISTER: reg1 = operands[0].reg; break;
+                case OperandKind::IMMEDIATE: mode = AddressingMode::IMMEDIATE; immediate = &operands[0].expression; break;
+                case OperandKind::MEMORY: mode = AddressingMode::MEMORY; immediate = &operands[0].expression; break;
+                case OperandKind::INDIRECT: mode = AddressingMode::REGISTER_INDIRECT; reg1 = operands[0].reg; break;
+                case OperandKind::BASE_DISP:
+                case OperandKind::BASE_INDEX: useBase(operands[0]); reg1 = operands[0].reg; break;
+                case OperandKind::VECTOR: valid = false; break;
+            }
+        } else if (count == 2) {
+            const Operand& first = operands[0];
+            const Operand& second = operands[1];
+            if (first.kind == OperandKind::REGISTER || first.kind == OperandKind::INDIRECT || isBase(first)) {
+                reg1 = first.reg;
+                valid = valid && (!isBase(first) || second.kind == OperandKind::REGISTER);
+                switch (second.kind) {
+                    case OperandKind::REGISTER:
+                        mode = first.kind == OperandKind::INDIRECT ? AddressingMode::REGISTER_INDIRECT : AddressingMode::REGISTER;
+                        if (isBase(first)) {
+                            // STORE [R1 + 8], R2: the base is the first operand's register
+                            useBase(first);
+                        }
+                        reg2 = second.reg;
+                        break;
+                    case OperandKind::BASE_DISP:
+                    case OperandKind::BASE_INDEX:
+                        valid = valid && first.kind == OperandKind::REGISTER;
+                        useBase(second);
+                        reg2 = second.reg;
+                        break;
+                    case OperandKind::INDIRECT:
+                        valid = valid && first.kind == OperandKind::REGISTER;
+                        mode = AddressingMode::REGISTER_INDIRECT;
+                        reg2 = second.reg;
+                        break;
+                    case OperandKind::IMMEDIATE:
+                        valid = valid && first.kind == OperandKind::REGISTER;
+                        mode = AddressingMode::IMMEDIATE;
+                        immediate = &second.expression;
+                        break;
+                    case OperandKind::MEMORY:
+                        valid = valid && first.kind == OperandKind::REGISTER;
+                        mode = AddressingMode::MEMORY;
+                        immediate = &second.expression;
+                        break;
+                    case OperandKind::VECTOR:
+                        valid = false;
+                        break;
+                }
+            } else if (second.kind == OperandKind::REGISTER && first.kind != OperandKind::VECTOR) {
+                // STORE #address, R2 / STORE [address], R2: the value register goes in reg2
+                mode = first.kind == OperandKind::MEMORY ? AddressingMode::MEMORY : AddressingMode::IMMEDIATE;
+                reg2 = second.reg;
+                immediate = &first.expression;
+            } else {
+                valid = false;
+            }
+        } else if (count == 3) {
+            // BCOPY Rd, Rs, Rn / ADD Rd, Ra, Rb: the third register goes in the low bits of the immediate
+            for (const Operand& operand : operands) {
+                valid = valid && operand.kind == OperandKind::REGISTER;
+            }
+            if (HasThreeOperandForm(opcode)) {
+                mode = AddressingMode::REGISTER3;
+            }
+            reg1 = operands[0].reg;
+            reg2 = operands[1].reg;
+            reg3 = operands[2].reg;
+        }
+
+        if (opcode == Opcode::MOVW) {
+            valid = valid && count == 2 && operands[0].kind == OperandKind::REGISTER && mode == AddressingMode::IMMEDIATE;
+        }
+        if (!valid) {
+            Error(std::string("unsupported operands for ") + OpcodeToString(opcode));
+            return;
+        }
+
+        if (opcode == Opcode::MOVW) {
+            // MOVW Rd, #value: the whole 64-bit value is the next code word
+            mImage.code.push_back(makeInstruction(opcode, mode, reg1, 0, 0));
+            size_t position = mImage.code.size();
+            mImage.code.push_back(0);
+            if (immediate->symbol.empty()) {
+                Patch(FixupKind::CODE_WORD, position, immediate->value, mLine);
+            } else {
+                mFixups.push_back({FixupKind::CODE_WORD, position, *immediate});
+            }
+            return;
+        }
+
+        size_t index = mImage.code.size();
+        mImage.code.push_back(makeInstruction(opcode, mode, reg1, reg2, reg3) | extension);
+        if (immediate) {
+            if (immediate->symbol.empty()) {
+                Patch(FixupKind::IMMEDIATE, index, immediate->value, mLine);
+            } else {
+                mFixups.push_back({FixupKind::IMMEDIATE, index, *immediate});
+            }
+        }
+    }
+
+    void Assembler::AssembleVector(Opcode opcode, std::string_view suffix, Cursor& cursor) {
+        if (mSection != Section::CODE) {
+            Error("instruction outside the code section");
+            return;
+        }
+
+        unsigned sizeCode = 0;
+        if (HasElementSize(opcode) ? !ParseElementSize(suffix, sizeCode) : !suffix.empty()) {
+            Error(std::string(OpcodeToString(opcode)) +
+                  (HasElementSize(opcode) ? " needs an element size: .8, .16, .32 or .64" : " takes no element size"));
+            return;
+        }
+
+        // Operand shape of each form: V vector register, R general register, # constant 0-255
+        const char* shape = "";
+        switch (GetVectorForm(opcode)) {
+            case VectorForm::LOAD:      shape = "VR"; break;
+            case VectorForm::STORE:     shape = "RV"; break;
+            case VectorForm::BROADCAST: shape = "VR"; break;
+            case VectorForm::EXTRACT:   shape = "RV#"; break;
+            case VectorForm::INSERT:    shape = "VR#"; break;
+            case VectorForm::BINARY:    shape = "VVV"; break;
+            case VectorForm::SHIFT:     shape = "VV#"; break;
+            case VectorForm::REDUCE:    shape = "RV"; break;
+            case VectorForm::NONE:      break;
+        }
+
+        uint8_t registers[3] = {0, 0, 0};
+        uint64_t value = 0;
+        size_t count = std::strlen(shape);
+        for (size_t i = 0; i < count; ++i) {
+            Operand operand;
+            if ((i > 0 && !cursor.Accept(',')) || cursor.AtEnd()) {
+                Error(std::string(OpcodeToString(opcode)) + " expects " + std::to_string(count) + " operands");
+                return;
+            }
+            if (!ParseOperand(cursor, operand)) {
+                return;
+            }
+            bool matches = shape[i] == 'V' ? operand.kind == OperandKind::VECTOR
+                         : shape[i] == 'R' ? operand.kind == OperandKind::REGISTER
+                                           : operand.kind == OperandKind::IMMEDIATE;
+            if (!matches) {
+                Error(std::string("unsupported operands for ") + OpcodeToString(opcode));
+                return;
+            }
+            if (shape[i] == '#') {
+                if (!operand.expression.symbol.empty() || operand.expression.value > 0xFF) {
+                    Error("vector immediate must be a constant from 0 to 255");
+                    return;
+                }
+                value = operand.expression.value;
+            } else {
+                registers[i] = operand.reg;
+            }
+        }
+
+        uint8_t third = GetVectorForm(opcode) == VectorForm::BINARY ? registers[2] : 0;
+        mImage.code.push_back(makeInstruction(opcode, AddressingMode::REGISTER, registers[0], registers[1],
+                                              makeVectorImmediate(third, sizeCode, static_cast<uint8_t>(value))));
+    }
+
+    void Assembler::EmitData(Cursor& cursor, FixupKind kind) {
+        do {
+            Expression value;
+            if (!ParseExpression(cursor, value)) {
+                return;
+            }
+
+            size_t position;
+            if (kind == FixupKind::CODE_WORD) {
+                position = mImage.code.size();
+                mImage.code.push_back(0);
+            } else {
+                position = mImage.data.size();
+                mImage.data.resize(position + (kind == FixupKind::DATA_BYTE ? 1 : sizeof(uint64_t)), 0);
+                mDataPlaced = true;
+            }
+
+            if (value.symbol.empty()) {
+                Patch(kind, position, value.value, mLine);
+            } else {
+                mFixups.push_back({kind, position, value});
+            }
+        } while (cursor.Accept(','));
+    }
+
+    void Assembler::AssembleDirective(std::string_view name, Cursor& cursor) {
+        auto is = [&](const char* directive) { return EqualsIgnoreCase(name, directive); };
+        auto resolved = [&](Expression& value) {
+            if (!ParseExpression(cursor, value)) {
+                return false;
+            }
+            if (!value.symbol.empty()) {
+                Error(std::string(name) + " needs a value known at this point, '" + std::string(value.symbol) + "' is not");
+                return false;
+            }
+            return true;
+        };
+
+        if (is(".code") || is(".text")) {
+            mSection = Section::CODE;
+            Expression address;
+            if (!cursor.AtEnd() && resolved(address)) {
+                if ((mCodePlaced || !mImage.code.empty()) && address.value != mImage.codeAddress) {
+                    Error(".code address cannot change once code has been placed");
+                } else {
+                    mImage.codeAddress = address.value;
+                }
+            }
+        } else if (is(".data")) {
+            mSection = Section::DATA;
+            Expression address;
+            if (!cursor.AtEnd() && resolved(address)) {
+                if (mDataPlaced && address.value != mImage.dataAddress) {
+                    Error(".data address cannot change once data has been placed");
+                } else {
+                    mImage.dataAddress = address.value;
+                }
+            }
+        } else if (is(".entry")) {
+            ParseExpression(cursor, mEntry);
+        } else if (is(".description")) {
+            mImage.description.clear();
+            ParseString(cursor, mImage.description);
+        } else if (is(".equ") || is(".set")) {
+            std::string_view symbol = cursor.Identifier();
+            Expression value;
+            if (symbol.empty() || !cursor.Accept(',')) {
+                Error(std::string(name) + " expects NAME, value");
+            } else if (resolved(value)) {
+                DefineSymbol(symbol, value.value, false);
+            }
+        } else if (is(".word") || is(".quad")) {
+            EmitData(cursor, mSection == Section::CODE ? FixupKind::CODE_WORD : FixupKind::DATA_QUAD);
+        } else if (mSection == Section::CODE) {
+            Error(std::string(name) + " is only allowed in the data section");
+            cursor.SkipToEnd();
+        } else if (is(".byte")) {
+            EmitData(cursor, FixupKind::DATA_BYTE);
+        } else if (is(".ascii") || is(".asciz")) {
+            std::string text;
+            if (ParseString(cursor, text)) {
+                mImage.data.insert(mImage.data.end(), text.begin(), text.end());
+                if (is(".asciz")) {
+                    mImage.data.push_back(0);
+                }
+                mDataPlaced = true;
+            }
+        } else if (is(".zero") || is(".space")) {
+            Expression size;
+            if (resolved(size)) {
+                mImage.data.resize(mImage.data.size() + size.value, 0);
+                mDataPlaced = true;
+            }
+        } else if (is(".align")) {
+            Expression alignment;
+            if (resolved(alignment)) {
+                if (alignment.value == 0 || (alignment.value & (alignment.value - 1)) != 0) {
+                    Error(".align expects a power of two");
+                } else {
+                    uint64_t address = mImage.dataAddress + mImage.data.size();
+                    uint64_t padding = (alignment.value - address % alignment.value) % alignment.value;
+                    mImage.data.resize(mImage.data.size() + padding, 0);
+                }
+            }
+        } else {
+            Error("unknown directive '" + std::string(name) + "'");
+        }
+    }
+
+    bool Assembler::Patch(FixupKind kind, size_t position, uint64_t value, size_t line) {
+        switch (kind) {
+            case FixupKind::IMMEDIATE:
+                if (decodeInstruction(mImage.code[position]).mode == AddressingMode::IMMEDIATE) {
+                    // Sign-extended from bit 43 when executed; larger constants need MOVW
+                    if (!fitsImmediate(value)) {
+                        Error(line, "immediate value does not fit in 44 bits, use MOVW");
+                        return false;
+                    }
+                    mImage.code[position] = (mImage.code[position] & ~kWideImmediateMask) | (value & kWideImmediateMask);
+                    return true;
+                }
+                if (!FitsBits(value, 32)) {
+                    Error(line, "immediate value does not fit in 32 bits");
+                    return false;
+                }
+                mImage.code[position] = (mImage.code[position] & ~kImmediateMask) | (value & kImmediateMask);
+                return true;
+            case FixupKind::CODE_WORD:
+                mImage.code[position] = value;
+                return true;
+            case FixupKind::DATA_QUAD:
+                std::memcpy(mImage.data.data() + position, &value, sizeof(value));
+                return true;
+            case FixupKind::DATA_BYTE:
+                if (!FitsBits(value, 8)) {
+                    Error(line, ".byte value does not fit in 8 bits");
+                    return false;
+                }
+                mImage.data[position] = static_cast<uint8_t>(value);
+                return true;
+        }
+        return false;
+    }
+
+    void Assembler::ResolveFixups() {
+        auto resolve = [&](const Expression& expression, uint64_t& value) {
+            if (expression.symbol.empty()) {
+                value = expression.value;
+                return true;
+            }
+            const Symbol* symbol = FindSymbol(expression.symbol);
+            if (!symbol) {
+                Error(expression.line, "undefined symbol '" + std::string(expression.symbol) + "'");
+                return false;
+            }
+            value = symbol->value + expression.value;
+            return true;
+        };
+
+        for (const auto& fixup : mFixups) {
+            uint64_t value;
+            if (resolve(fixup.expression, value)) {
+                Patch(fixup.kind, fixup.position, value, fixup.expression.line);
+            }
+        }
+
+        // Without .entry, execution starts at the first instruction
+        uint64_t entry;
+        if (mEntry.line == 0) {
+            mImage.entryPoint = mImage.codeAddress;
+        } else if (resolve(mEntry, entry)) {
+            mImage.entryPoint = entry;
+        }
+    }
+
+    void Assembler::Error(size_t line, const std::string& message) {
+        mErrors.push_back({line, message});
+    }
+}
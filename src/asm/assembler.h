@@ -0,0 +1,118 @@
+// src/asm/assembler.h
+#ifndef VM_ASSEMBLER_H
+#define VM_ASSEMBLER_H
+
+#include <common/types.h>
+#include <vm/firmware_format.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vm {
+    struct AssemblerError {
+        size_t line;
+        std::string message;
+    };
+
+    // Single-pass assembler for the VM's text syntax (see "Assembler" in Readme.md).
+    //
+    // Statements are encoded as they are read; operands naming a symbol that is not
+    // defined yet are recorded as fixups and patched once the whole source has been
+    // seen. Symbol names are views into the source text, which the assembler owns,
+    // so a line costs no allocation beyond the emitted words.
+    class Assembler {
+    private:
+        enum class Section : uint8_t { CODE, DATA };
+        enum class FixupKind : uint8_t {
+            IMMEDIATE,      // Immediate field of a code word (44 bits in IMMEDIATE mode, else 32)
+            CODE_WORD,      // Whole 64-bit code word (.word in the code section)
+            DATA_QUAD,      // 8 data bytes
+            DATA_BYTE       // 1 data byte
+        };
+
+        struct Symbol {
+            std::string_view name;
+            uint64_t value;
+            size_t line;
+            bool label;     // Address of code or data (exported to the SYMBOLS section)
+        };
+
+        // Open-addressing slot of the symbol table; index is 1-based, 0 marks a free slot
+        struct SymbolSlot {
+            uint32_t hash;
+            uint32_t index;
+        };
+
+        // Value of an expression: resolved, or an undefined symbol plus an addend
+        struct Expression {
+            uint64_t value = 0;
+            std::string_view symbol;
+            size_t line = 0;
+        };
+
+        struct Fixup {
+            FixupKind kind;
+            size_t position;        // Code index or data offset
+            Expression expression;
+        };
+
+        enum class OperandKind : uint8_t { REGISTER, IMMEDIATE, MEMORY, INDIRECT, VECTOR, BASE_DISP, BASE_INDEX };
+        struct Operand {
+            OperandKind kind;
+            uint8_t reg;            // Register, or base register of [Rn ...]
+            uint8_t index;          // BASE_INDEX: index register and scale shift
+            uint8_t scaleShift;
+            Expression expression;  // Immediate, absolute address or displacement
+        };
+
+        class Cursor;
+
+        FirmwareImage mImage;
+        std::string mSource;
+        std::string mSourceName;
+        std::vector<Symbol> mSymbols;               // In definition order
+        std::vector<SymbolSlot> mSymbolSlots;       // Power-of-two sized, at most half full
+        std::vector<Fixup> mFixups;
+        std::vector<AssemblerError> mErrors;
+        Section mSection;
+        size_t mLine;
+        bool mCodePlaced;           // .code address can no longer move
+        bool mDataPlaced;           // .data address can no longer move
+        Expression mEntry;
+
+        void Reset();
+        void AssembleLine(std::string_view line);
+        void AssembleInstruction(Opcode opcode, Cursor& cursor);
+        void AssembleVector(Opcode opcode, std::string_view suffix, Cursor& cursor);
+        void AssembleDirective(std::string_view name, Cursor& cursor);
+        const Symbol* FindSymbol(std::string_view name) const;
+        void DefineSymbol(std::string_view name, uint64_t value, bool label);
+        bool ParseExpression(Cursor& cursor, Expression& expression);
+        bool ParseOperand(Cursor& cursor, Operand& operand);
+        bool ParseAddressOffset(Cursor& cursor, Operand& operand);
+        bool ParseString(Cursor& cursor, std::string& text);
+        void EmitData(Cursor& cursor, FixupKind kind);
+        bool Patch(FixupKind kind, size_t position, uint64_t value, size_t line);
+        void ResolveFixups();
+        void Error(const std::string& message) { Error(mLine, message); }
+        void Error(size_t line, const std::string& message);
+
+    public:
+        Assembler();
+
+        // Assemble source text; returns false if there were errors
+        bool Assemble(std::string source, const std::string& sourceName = "<input>");
+        bool AssembleFile(const std::string& filename);
+
+        const FirmwareImage& GetImage() const { return mImage; }
+        FirmwareImage& GetImage() { return mImage; }
+        const std::vector<AssemblerError>& GetErrors() const { return mErrors; }
+        const std::string& GetSourceName() const { return mSourceName; }
+        size_t GetLineCount() const { return mLine; }
+    };
+
+    // Opcode of a mnemonic as spelled by OpcodeToString (case-insensitive)
+    bool LookupMnemonic(std::string_view mnemonic, Opcode& opcode);
+}
+
+#endif // VM_ASSEMBLER_H
@@ -0,0 +1,705 @@
+// src/asm/disassembler.cpp
+#include "disassembler.h"
+#include <analysis/instruction_effects.h>
+#include <common/instruction.h>
+#include <common/vector.h>
+#include <cpu/cpu.h>
+#include <vm/firmware_codec.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace vm {
+    namespace {
+        constexpr size_t kFlushSize = 1 << 20;
+        constexpr size_t kCommentColumn = 40;
+        constexpr size_t kZeroRun = 16;      // Shortest run of data zeros printed as .zero
+
+        // Operand shapes that have a shorter spelling than "Ra, Rb"
+        bool TakesNoOperand(Opcode opcode) {
+            return opcode == Opcode::HLT || opcode == Opcode::NOP || opcode == Opcode::RET;
+        }
+
+        bool TakesOneOperand(Opcode opcode) {
+            switch (opcode) {
+                case Opcode::PUSH:
+                case Opcode::POP:
+                case Opcode::INC:
+                case Opcode::DEC:
+                case Opcode::NOT:
+                case Opcode::BSWAP:
+                case Opcode::JMP:
+                case Opcode::CALL:
+                case Opcode::PRINT:
+                case Opcode::HCALL:
+                    return true;
+                default:
+                    return IsConditionalBranch(opcode) && opcode != Opcode::LOOP;
+            }
+        }
+
+        void AppendHex(std::string& out, uint64_t value, int width = 0) {
+            char text[24];
+            std::snprintf(text, sizeof(text), "0x%0*" PRIx64, width, value);
+            out += text;
+        }
+
+        void AppendValue(std::string& out, uint64_t value) {
+            if (value < 10) {
+                out += static_cast<char>('0' + value);
+            } else {
+                AppendHex(out, value);
+            }
+        }
+
+        // IMMEDIATE operands are signed: -8 rather than 0xfffffffffffffff8
+        void AppendSigned(std::string& out, uint64_t value) {
+            if (static_cast<int64_t>(value) < 0) {
+                out += '-';
+                value = 0 - value;
+            }
+            AppendValue(out, value);
+        }
+
+        void AppendRegister(std::string& out, uint8_t reg) {
+            out += 'R';
+            out += std::to_string(reg);
+        }
+
+        // [R2 + 8], [R2 - 8], [R2 + R3*8 + 16]; a zero displacement is kept for BASE_DISP
+        // so that [R2 + 0] does not read back as REGISTER_INDIRECT
+        void AppendBaseAddress(std::string& out, const Instruction& instr, uint8_t base) {
+            out += '[';
+            AppendRegister(out, base);
+            if (instr.mode == AddressingMode::BASE_INDEX) {
+                out += " + ";
+                AppendRegister(out, indexRegister(instr));
+                if (indexScaleShift(instr) != 0) {
+                    out += '*';
+                    out += static_cast<char>('0' + (1 << indexScaleShift(instr)));
+                }
+            }
+            int64_t offset = displacement(instr);
+            if (offset != 0 || instr.mode == AddressingMode::BASE_DISP) {
+                out += offset < 0 ? " - " : " + ";
+                AppendValue(out, offset < 0 ? 0 - static_cast<uint64_t>(offset) : static_cast<uint64_t>(offset));
+            }
+            out += ']';
+        }
+
+        // VADD.32 V1, V2, V3 and the other vector forms; false when the word has fields
+        // the syntax cannot express
+        bool AppendVector(std::string& out, uint64_t word, const Instruction& instr) {
+            VectorForm form = GetVectorForm(instr.opcode);
+            bool hasValue = form == VectorForm::EXTRACT || form == VectorForm::INSERT || form == VectorForm::SHIFT;
+            unsigned sizeCode = HasElementSize(instr.opcode) ? vectorSizeCode(instr) : 0;
+            uint32_t canonical = makeVectorImmediate(form == VectorForm::BINARY ? thirdRegister(instr) : 0, sizeCode,
+                                                     hasValue ? vectorImmediate(instr) : 0);
+            if (instr.mode != AddressingMode::REGISTER || (word & 0x00000FFF00000000ULL) != 0 ||
+                instr.immediate != canonical) {
+                return false;
+            }
+
+            out += OpcodeToString(instr.opcode);
+            if (HasElementSize(instr.opcode)) {
+                out += '.';
+                out += std::to_string(8 << sizeCode);
+            }
+            auto append = [&](char kind, uint8_t reg) {
+                out += kind;
+                out += std::to_string(reg);
+            };
+            bool vectorFirst = form != VectorForm::STORE && form != VectorForm::EXTRACT && form != VectorForm::REDUCE;
+            bool vectorSecond = form != VectorForm::LOAD && form != VectorForm::BROADCAST && form != VectorForm::INSERT;
+            out += ' ';
+            append(vectorFirst ? 'V' : 'R', instr.reg1);
+            out += ", ";
+            append(vectorSecond ? 'V' : 'R', instr.reg2);
+            if (form == VectorForm::BINARY) {
+                out += ", ";
+                append('V', thirdRegister(instr));
+            } else if (hasValue) {
+                out += ", #";
+                out += std::to_string(vectorImmediate(instr));
+            }
+            return true;
+        }
+
+        void AppendQuoted(std::string& out, const std::string& text) {
+            out += '"';
+            for (unsigned char c : text) {
+                switch (c) {
+                    case '\n': out += "\\n"; break;
+                    case '\t': out += "\\t"; break;
+                    case '\r': out += "\\r"; break;
+                    case '\\': out += "\\\\"; break;
+                    case '"': out += "\\\""; break;
+                    default:
+                        if (c < 0x20 || c >= 0x7F) {
+                            char escape[8];
+                            std::snprintf(escape, sizeof(escape), "\\x%02x", c);
+                            out += escape;
+                        } else {
+                            out += static_cast<char>(c);
+                        }
+                }
+            }
+            out += '"';
+        }
+
+        void PadTo(std::string& out, size_t lineStart, size_t column) {
+            size_t length = out.size() - lineStart;
+            out.append(length < column ? column - length : 1, ' ');
+        }
+    }
+
+    Disassembler::Disassembler()
+        : mCode(nullptr), mCodeAddress(0), mInstructionCount(0), mProfileSamples(0) {
+    }
+
+    bool Disassembler::Open(const std::string& filename) {
+        mLabels.clear();
+        mCode = nullptr;
+        mFilename = filename;
+
+        if (!mFirmware.Open(filename) || !mFirmware.VerifyChecksums()) {
+            mError = mFirmware.GetError();
+            return false;
+        }
+
+        mCode = mFirmware.FindSection(SectionType::CODE);
+        mCodeAddress = mCode->mLoadAddress;
+        mInstructionCount = mCode->mMemorySize / sizeof(uint64_t);
+        return CollectLabels();
+    }
+
+    bool Disassembler::ForEachBlock(const BlockCallback& callback) {
+        const uint8_t* data = mFirmware.GetSectionData(*mCode);
+        std::vector<uint64_t> block(CODEC_BLOCK_INSTRUCTIONS);
+
+        if (mCode->mFlags & SECTION_FLAG_COMPRESSED) {
+            CodeDecompressor decompressor(data, mCode->mFileSize);
+            size_t first = 0;
+            while (size_t count = decompressor.NextBlock(block.data())) {
+                if (count > mInstructionCount - first) {
+                    break;
+                }
+                callback(block.data(), count, first);
+                first += count;
+            }
+            if (decompressor.HasError() || first != mInstructionCount) {
+                mError = decompressor.HasError() ? decompressor.GetError() : "Compressed code size mismatch";
+                return false;
+            }
+            return true;
+        }
+
+        // v1 code is not 8-byte aligned in the file, so words are copied out block by block
+        for (size_t first = 0; first < mInstructionCount; first += CODEC_BLOCK_INSTRUCTIONS) {
+            size_t count = std::min<size_t>(CODEC_BLOCK_INSTRUCTIONS, mInstructionCount - first);
+            std::memcpy(block.data(), data + first * sizeof(uint64_t), count * sizeof(uint64_t));
+            callback(block.data(), count, first);
+        }
+        return true;
+    }
+
+    bool Disassembler::CollectLabels() {
+        uint64_t codeEnd = mCodeAddress + mInstructionCount * sizeof(uint64_t);
+        auto inCode = [&](uint64_t address) {
+            return address >= mCodeAddress && address < codeEnd && (address - mCodeAddress) % sizeof(uint64_t) == 0;
+        };
+
+        // (address << 1) | isCall, so that a call target sorts after a jump to the same place
+        std::vector<uint64_t> targets;
+        bool constant = false;      // MOVW constant words are not instructions
+        bool ok = ForEachBlock([&](const uint64_t* words, size_t count, size_t) {
+            for (size_t i = 0; i < count; ++i) {
+                Instruction instr = decodeInstruction(words[i]);
+                if (constant) {
+                    constant = false;
+                    continue;
+                }
+                constant = InstructionWords(instr.opcode) == 2;
+                uint64_t target = immediateValue(instr);
+                if (IsValidOpcode(instr.opcode) && HasDirectTarget(instr) && inCode(target)) {
+                    targets.push_back((target << 1) | (instr.opcode == Opcode::CALL ? 1 : 0));
+                }
+            }
+        });
+        if (!ok) {
+            return false;
+        }
+        if (inCode(mFirmware.GetEntryPoint()) && mFirmware.GetEntryPoint() != mCodeAddress) {
+            targets.push_back(mFirmware.GetEntryPoint() << 1);
+        }
+        std::sort(targets.begin(), targets.end());
+
+        for (const auto& symbol : mFirmware.GetSymbols()) {
+            mLabels.push_back({symbol.address, symbol.name});
+        }
+        std::stable_sort(mLabels.begin(), mLabels.end(),
+                         [](const Label& a, const Label& b) { return a.address < b.address; });
+
+        size_t symbolCount = mLabels.size();
+        for (size_t i = 0; i < targets.size(); ++i) {
+            uint64_t address = targets[i] >> 1;
+            if (i + 1 < targets.size() && (targets[i + 1] >> 1) == address) {
+                continue;   // Keep the last entry for an address: the call if there is one
+            }
+            auto named = std::lower_bound(mLabels.begin(), mLabels.begin() + symbolCount, address,
+                                          [](const Label& label, uint64_t value) { return label.address < value; });
+            if (named != mLabels.begin() + symbolCount && named->address == address) {
+                continue;
+            }
+            char name[32];
+            std::snprintf(name, sizeof(name), "%s_%" PRIx64, (targets[i] & 1) ? "sub" : "loc", address);
+            mLabels.push_back({address, name});
+        }
+        std::stable_sort(mLabels.begin(), mLabels.end(),
+                         [](const Label& a, const Label& b) { return a.address < b.address; });
+        return true;
+    }
+
+    const Disassembler::Label* Disassembler::FindLabel(uint64_t address) const {
+        auto it = std::lower_bound(mLabels.begin(), mLabels.end(), address,
+                                   [](const Label& label, uint64_t value) { return label.address < value; });
+        return it != mLabels.end() && it->address == address ? &*it : nullptr;
+    }
+
+    bool Disassembler::LoadProfile(const std::string& filename) {
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            mError = "Cannot open profile file: " + filename;
+            return false;
+        }
+
+        mProfile.clear();
+        mProfileSamples = 0;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.compare(0, 3, "pc ") != 0) {
+                continue;
+            }
+            std::istringstream fields(line.substr(3));
+            std::string address;
+            uint64_t samples = 0;
+            if (!(fields >> address >> samples)) {
+                mError = "Malformed profile line: " + line;
+                return false;
+            }
+            mProfile.push_back({std::stoull(address, nullptr, 0), samples});
+            mProfileSamples += samples;
+        }
+
+        std::sort(mProfile.begin(), mProfile.end(),
+                  [](const ProfileEntry& a, const ProfileEntry& b) { return a.pc < b.pc; });
+        return true;
+    }
+
+    uint64_t Disassembler::GetSamples(uint64_t pc) const {
+        auto it = std::lower_bound(mProfile.begin(), mProfile.end(), pc,
+                                   [](const ProfileEntry& entry, uint64_t value) { return entry.pc < value; });
+        return it != mProfile.end() && it->pc == pc ? it->samples : 0;
+    }
+
+    void Disassembler::FormatInstruction(uint64_t word, std::string& out) const {
+        Instruction instr = decodeInstruction(word);
+        // Extension bits: index and scale of BASE_INDEX, the top of a 44-bit IMMEDIATE value
+        uint16_t extensionBits = instr.mode == AddressingMode::BASE_INDEX ? 0x3F
+                               : instr.mode == AddressingMode::IMMEDIATE ? 0xFFF : 0;
+        bool representable = IsValidOpcode(instr.opcode) && instr.opcode != Opcode::MOVW &&
+                             (instr.extension & ~extensionBits) == 0 &&
+                             (!TakesThreeRegisters(instr.opcode) || instr.mode == AddressingMode::REGISTER) &&
+                             (HasThreeOperandForm(instr.opcode) || instr.mode != AddressingMode::REGISTER3) &&
+                             static_cast<uint8_t>(instr.mode) <= static_cast<uint8_t>(AddressingMode::REGISTER3);
+        uint64_t value = instr.mode == AddressingMode::IMMEDIATE ? immediateValue(instr) : instr.immediate;
+
+        if (GetVectorForm(instr.opcode) != VectorForm::NONE) {
+            if (!AppendVector(out, word, instr)) {
+                out += ".word ";
+                AppendHex(out, word, 16);
+            }
+            return;
+        }
+
+        const char* mnemonic = OpcodeToString(instr.opcode);
+        bool single = TakesOneOperand(instr.opcode) || (TakesNoOperand(instr.opcode) && instr.reg1 != 0);
+        auto appendImmediate = [&](bool allowLabel) {
+            const Label* label = allowLabel && HasDirectTarget(instr) ? FindLabel(value) : nullptr;
+            if (label) {
+                out += label->name;
+            } else {
+                if (!allowLabel || !HasDirectTarget(instr)) {
+                    out += '#';
+                }
+                AppendSigned(out, value);
+            }
+        };
+
+        switch (representable ? instr.mode : AddressingMode::REGISTER) {
+            case AddressingMode::REGISTER:
+                if (!representable || instr.immediate > (TakesThreeRegisters(instr.opcode) ? 0xFu : 0u)) {
+                    break;
+                }
+                out += mnemonic;
+                if (TakesThreeRegisters(instr.opcode)) {
+                    out += ' ';
+                    AppendRegister(out, instr.reg1);
+                    out += ", ";
+                    AppendRegister(out, instr.reg2);
+                    out += ", ";
+                    AppendRegister(out, thirdRegister(instr));
+                    return;
+                }
+                if (TakesNoOperand(instr.opcode) && instr.reg1 == 0 && instr.reg2 == 0) {
+                    return;
+                }
+                out += ' ';
+                AppendRegister(out, instr.reg1);
+                if (!single || instr.reg2 != 0) {
+                    out += ", ";
+                    AppendRegister(out, instr.reg2);
+                }
+                return;
+
+            case AddressingMode::IMMEDIATE:
+            case AddressingMode::MEMORY: {
+                bool memory = instr.mode == AddressingMode::MEMORY;
+                if (instr.reg1 != 0 && instr.reg2 != 0) {
+                    break;      // No syntax sets both registers and the immediate
+                }
+                out += mnemonic;
+                out += ' ';
+                if (instr.reg2 != 0) {
+                    // STORE #address, R2 / STORE [address], R2
+                    out += memory ? "[" : "";
+                    out += memory ? "" : "#";
+                    AppendSigned(out, value);
+                    out += memory ? "], " : ", ";
+                    AppendRegister(out, instr.reg2);
+                    return;
+                }
+                if (instr.reg1 != 0 || !single) {
+                    AppendRegister(out, instr.reg1);
+                    out += ", ";
+                }
+                if (memory) {
+                    out += '[';
+                    AppendValue(out, instr.immediate);
+                    out += ']';
+                } else {
+                    // Bare operands are immediates too, which is how jump targets read best
+                    appendImmediate(true);
+                }
+                return;
+            }
+
+            case AddressingMode::REGISTER3:
+                if (instr.immediate > 0xF) {
+                    break;
+                }
+                out += mnemonic;
+                out += ' ';
+                AppendRegister(out, instr.reg1);
+                out += ", ";
+                AppendRegister(out, instr.reg2);
+                out += ", ";
+                AppendRegister(out, thirdRegister(instr));
+                return;
+
+            case AddressingMode::REGISTER_INDIRECT:
+                if (instr.immediate != 0) {
+                    break;
+                }
+                out += mnemonic;
+                out += ' ';
+                if (instr.reg2 == 0 && single) {
+                    out += '[';
+                    AppendRegister(out, instr.reg1);
+                    out += ']';
+                } else if (instr.opcode == Opcode::STORE) {
+                    out += '[';
+                    AppendRegister(out, instr.reg1);
+                    out += "], ";
+                    AppendRegister(out, instr.reg2);
+                } else {
+                    AppendRegister(out, instr.reg1);
+                    out += ", [";
+                    AppendRegister(out, instr.reg2);
+                    out += ']';
+                }
+                return;
+
+            case AddressingMode::BASE_DISP:
+            case AddressingMode::BASE_INDEX:
+                // Same operand placement as REGISTER_INDIRECT
+                out += mnemonic;
+                out += ' ';
+                if (instr.reg2 == 0 && single) {
+                    AppendBaseAddress(out, instr, instr.reg1);
+                } else if (instr.opcode == Opcode::STORE) {
+                    AppendBaseAddress(out, instr, instr.reg1);
+                    out += ", ";
+                    AppendRegister(out, instr.reg2);
+                } else {
+                    AppendRegister(out, instr.reg1);
+                    out += ", ";
+                    AppendBaseAddress(out, instr, instr.reg2);
+                }
+                return;
+
+            default:
+                break;
+        }
+
+        // Invalid opcode or mode, or fields the syntax cannot express: keep the raw word
+        out += ".word ";
+        AppendHex(out, word, 16);
+    }
+
+    bool Disassembler::Write(std::ostream& out, const DisassemblyOptions& options) {
+        if (!mCode) {
+            mError = "No firmware open";
+            return false;
+        }
+
+        std::string buffer;
+        buffer.reserve(kFlushSize + 4096);
+        auto flush = [&]() {
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
+        };
+
+        uint64_t codeEnd = mCodeAddress + mInstructionCount * sizeof(uint64_t);
+        const FirmwareSection* data = mFirmware.FindSection(SectionType::DATA);
+        uint64_t dataAddress = data ? data->mLoadAddress : 0;
+        uint64_t dataEnd = data ? dataAddress + data->mFileSize : 0;
+        auto placed = [&](uint64_t address) {
+            return (address >= mCodeAddress && address < codeEnd && (address - mCodeAddress) % sizeof(uint64_t) == 0) ||
+                   (address >= dataAddress && address < dataEnd);
+        };
+
+        buffer += "; " + mFilename + ": format v" + std::to_string(mFirmware.GetVersion()) + ", " +
+                  std::to_string(mInstructionCount) + " instructions";
+        if (mCode->mFlags & SECTION_FLAG_COMPRESSED) {
+            buffer += ", compressed";
+        }
+        buffer += '\n';
+        if (!mProfile.empty()) {
+            buffer += "; profile: " + std::to_string(mProfileSamples) + " samples\n";
+        }
+        for (const auto& segment : mFirmware.GetSegments()) {
+            buffer += "; segment " + segment.name + " base ";
+            AppendHex(buffer, segment.base);
+            buffer += " size ";
+            AppendHex(buffer, segment.size);
+            buffer += '\n';
+        }
+
+        std::string description = mFirmware.GetDescription();
+        if (!description.empty()) {
+            buffer += ".description ";
+            AppendQuoted(buffer, description);
+            buffer += '\n';
+        }
+
+        // Symbols that name neither an instruction nor a data byte survive as constants
+        for (const auto& label : mLabels) {
+            if (!placed(label.address)) {
+                buffer += label.name + " = ";
+                AppendHex(buffer, label.address);
+                buffer += '\n';
+            }
+        }
+
+        if (mCodeAddress != 0) {
+            buffer += ".code ";
+            AppendHex(buffer, mCodeAddress);
+            buffer += '\n';
+        }
+        uint64_t entry = mFirmware.GetEntryPoint();
+        if (entry != mCodeAddress) {
+            const Label* label = FindLabel(entry);
+            buffer += ".entry ";
+            if (label) {
+                buffer += label->name;
+            } else {
+                AppendHex(buffer, entry);
+            }
+            buffer += '\n';
+        }
+        buffer += '\n';
+
+        auto label = mLabels.begin();
+        auto sampled = mProfile.begin();
+        bool filtered = options.context > 0 && !mProfile.empty();
+        uint64_t reach = options.context * sizeof(uint64_t);
+        bool skipped = false;
+
+        // A MOVW line is left open until its constant word (possibly in the next block) arrives
+        bool constantNext = false;
+        size_t openLine = std::string::npos;
+        uint64_t openAddress = 0;
+        uint64_t openWord = 0;
+
+        auto endLine = [&](size_t lineStart, uint64_t address, uint64_t word, const uint64_t* constant) {
+            uint64_t samples = mProfile.empty() ? 0 : GetSamples(address);
+            if (options.showEncoding || samples) {
+                PadTo(buffer, lineStart, kCommentColumn);
+                buffer += ';';
+                if (options.showEncoding) {
+                    buffer += ' ';
+                    AppendHex(buffer, address, 8);
+                    char raw[40];
+                    std::snprintf(raw, sizeof(raw), "  %016" PRIx64, word);
+                    buffer += raw;
+                    if (constant) {
+                        std::snprintf(raw, sizeof(raw), " %016" PRIx64, *constant);
+                        buffer += raw;
+                    }
+                }
+                if (samples) {
+                    char hits[48];
+                    std::snprintf(hits, sizeof(hits), "  [%" PRIu64 " samples, %.2f%%]", samples,
+                                  100.0 * static_cast<double>(samples) / static_cast<double>(mProfileSamples));
+                    buffer += hits;
+                }
+            }
+            buffer += '\n';
+
+            if (buffer.size() >= kFlushSize) {
+                flush();
+            }
+        };
+
+        bool ok = ForEachBlock([&](const uint64_t* words, size_t count, size_t firstIndex) {
+            for (size_t i = 0; i < count; ++i) {
+                uint64_t address = mCodeAddress + (firstIndex + i) * sizeof(uint64_t);
+                bool constant = constantNext;
+                constantNext = false;
+                if (constant && openLine != std::string::npos) {
+                    AppendValue(buffer, words[i]);
+                    endLine(openLine, openAddress, openWord, &words[i]);
+                    openLine = std::string::npos;
+                    continue;
+                }
+
+                // MOVW Rd, #value in one line when it has the canonical form and nothing jumps to the constant
+                Instruction instr = decodeInstruction(words[i]);
+                bool wide = !constant && instr.opcode == Opcode::MOVW && address + sizeof(uint64_t) < codeEnd;
+                bool joined = wide && words[i] == makeInstruction(Opcode::MOVW, AddressingMode::IMMEDIATE, instr.reg1, 0, 0) &&
+                              !FindLabel(address + sizeof(uint64_t));
+                constantNext = wide;
+
+                while (label != mLabels.end() && label->address < address) {
+                    ++label;
+                }
+
+                if (filtered) {
+                    while (sampled != mProfile.end() && sampled->pc + reach < address) {
+                        ++sampled;
+                    }
+                    if (sampled == mProfile.end() || sampled->pc > address + reach) {
+                        if (!skipped) {
+                            buffer += "        ; ...\n";
+                            skipped = true;
+                        }
+                        continue;
+                    }
+                    skipped = false;
+                }
+
+                for (; label != mLabels.end() && label->address == address; ++label) {
+                    buffer += label->name;
+                    buffer += ":\n";
+                }
+
+                size_t lineStart = buffer.size();
+                buffer += "        ";
+                if (joined) {
+                    buffer += "MOVW ";
+                    AppendRegister(buffer, instr.reg1);
+                    buffer += ", #";
+                    openLine = lineStart;
+                    openAddress = address;
+                    openWord = words[i];
+                    continue;
+                }
+                if (constant) {
+                    // Data, not an instruction, even where it decodes as one
+                    buffer += ".word ";
+                    AppendHex(buffer, words[i], 16);
+                } else {
+                    FormatInstruction(words[i], buffer);
+                }
+                endLine(lineStart, address, words[i], nullptr);
+            }
+        });
+        if (!ok) {
+            flush();
+            return false;
+        }
+
+        if (data && data->mFileSize > 0) {
+            WriteData(buffer, out);
+        }
+        flush();
+        return out.good();
+    }
+
+    void Disassembler::WriteData(std::string& buffer, std::ostream& out) {
+        const FirmwareSection* data = mFirmware.FindSection(SectionType::DATA);
+        const uint8_t* bytes = mFirmware.GetSectionData(*data);
+        uint64_t base = data->mLoadAddress;
+        size_t size = data->mFileSize;
+
+        buffer += "\n.data ";
+        AppendHex(buffer, base);
+        buffer += '\n';
+
+        auto label = std::lower_bound(mLabels.begin(), mLabels.end(), base,
+                                      [](const Label& l, uint64_t value) { return l.address < value; });
+        size_t offset = 0;
+        while (offset < size) {
+            for (; label != mLabels.end() && label->address == base + offset; ++label) {
+                buffer += label->name;
+                buffer += ":\n";
+            }
+            // Directives never straddle a label
+            size_t limit = label != mLabels.end() && label->address < base + size ? label->address - base : size;
+
+            size_t zeros = 0;
+            while (offset + zeros < limit && bytes[offset + zeros] == 0) {
+                ++zeros;
+            }
+
+            buffer += "        ";
+            if (zeros >= kZeroRun) {
+                buffer += ".zero " + std::to_string(zeros);
+                offset += zeros;
+            } else if (limit - offset >= sizeof(uint64_t)) {
+                uint64_t value;
+                std::memcpy(&value, bytes + offset, sizeof(value));
+                buffer += ".quad ";
+                AppendHex(buffer, value, 16);
+                offset += sizeof(uint64_t);
+            } else {
+                buffer += ".byte ";
+                for (size_t i = offset; i < limit; ++i) {
+                    buffer += i == offset ? "" : ", ";
+                    AppendHex(buffer, bytes[i], 2);
+                }
+                offset = limit;
+            }
+            buffer += '\n';
+
+            if (buffer.size() >= kFlushSize) {
+                out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                buffer.clear();
+            }
+        }
+    }
+}
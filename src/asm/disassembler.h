@@ -0,0 +1,74 @@
+// src/asm/disassembler.h
+#ifndef VM_DISASSEMBLER_H
+#define VM_DISASSEMBLER_H
+
+#include <common/types.h>
+#include <vm/firmware_format.h>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace vm {
+    struct DisassemblyOptions {
+        bool showEncoding = true;   // Address and instruction word in a trailing comment
+        size_t context = 0;         // With a profile: only print instructions this close to a sampled one
+    };
+
+    // Streaming disassembler for firmware files.
+    //
+    // The image is memory-mapped and its code read one CODEC_BLOCK_INSTRUCTIONS block
+    // at a time (decompressed if needed), so memory use does not grow with the image.
+    // The first pass collects jump and call targets, the second prints; labels come from
+    // the SYMBOLS section, else loc_<address> / sub_<address>. The output is vmasm source
+    // and reassembles to the same code, data, entry point and symbols.
+    class Disassembler {
+    private:
+        struct Label {
+            uint64_t address;
+            std::string name;
+        };
+
+        struct ProfileEntry {
+            uint64_t pc;
+            uint64_t samples;
+        };
+
+        MappedFirmware mFirmware;
+        std::string mFilename;
+        const FirmwareSection* mCode;
+        uint64_t mCodeAddress;
+        size_t mInstructionCount;
+        std::vector<Label> mLabels;             // Sorted by address, symbols before generated names
+        std::vector<ProfileEntry> mProfile;     // Sorted by pc
+        uint64_t mProfileSamples;
+        std::string mError;
+
+        using BlockCallback = std::function<void(const uint64_t* words, size_t count, size_t firstIndex)>;
+        bool ForEachBlock(const BlockCallback& callback);
+        bool CollectLabels();
+        const Label* FindLabel(uint64_t address) const;
+        uint64_t GetSamples(uint64_t pc) const;
+        void WriteData(std::string& buffer, std::ostream& out);
+
+    public:
+        Disassembler();
+
+        bool Open(const std::string& filename);
+
+        // Read a histogram written by --profile ("pc <address> <samples> ..." lines)
+        bool LoadProfile(const std::string& filename);
+
+        bool Write(std::ostream& out, const DisassemblyOptions& options = DisassemblyOptions());
+
+        // Append the assembly text of one instruction word, naming known targets
+        void FormatInstruction(uint64_t word, std::string& out) const;
+
+        size_t GetInstructionCount() const { return mInstructionCount; }
+        size_t GetLabelCount() const { return mLabels.size(); }
+        uint64_t GetProfileSamples() const { return mProfileSamples; }
+        const std::string& GetError() const { return mError; }
+    };
+}
+
+#endif // VM_DISASSEMBLER_H
@@ -0,0 +1,35 @@
+// src/common/bits.h
+#ifndef VM_BITS_H
+#define VM_BITS_H
+
+#include <cstdint>
+
+namespace vm {
+    // Portable PEXT: the bits of value selected by mask, packed into the low bits
+    inline uint64_t bitExtract(uint64_t value, uint64_t mask) {
+        uint64_t result = 0;
+        for (uint64_t bit = 1; mask != 0; bit <<= 1) {
+            uint64_t lowest = mask & (0 - mask);
+            if (value & lowest) {
+                result |= bit;
+            }
+            mask ^= lowest;
+        }
+        return result;
+    }
+
+    // Portable PDEP: the low bits of value scattered to the positions set in mask
+    inline uint64_t bitDeposit(uint64_t value, uint64_t mask) {
+        uint64_t result = 0;
+        for (uint64_t bit = 1; mask != 0; bit <<= 1) {
+            uint64_t lowest = mask & (0 - mask);
+            if (value & bit) {
+                result |= lowest;
+            }
+            mask ^= lowest;
+        }
+        return result;
+    }
+}
+
+#endif // VM_BITS_H
@@ -0,0 +1,87 @@
+// src/common/instruction.h
+#ifndef VM_INSTRUCTION_H
+#define VM_INSTRUCTION_H
+
+#include <common/types.h>
+
+namespace vm {
+    // Encode an instruction word (see the format table in Readme.md)
+    inline uint64_t makeInstruction(Opcode opcode, AddressingMode mode,
+                                    uint8_t reg1, uint8_t reg2, uint32_t immediate) {
+        uint64_t instr = 0;
+        instr |= (static_cast<uint64_t>(opcode) << 56);
+        instr |= (static_cast<uint64_t>(mode) << 52);
+        instr |= (static_cast<uint64_t>(reg1) << 48);
+        instr |= (static_cast<uint64_t>(reg2) << 44);
+        instr |= static_cast<uint64_t>(immediate);
+        return instr;
+    }
+
+    // Third register of the three-register forms (BCOPY Rd, Rs, Rn, ADD Rd, Ra, Rb): low bits of the immediate
+    inline uint8_t thirdRegister(const Instruction& instr) {
+        return static_cast<uint8_t>(instr.immediate & 0xF);
+    }
+
+    // Value of an IMMEDIATE operand: the 32-bit immediate and the 12 extension bits above
+    // it, sign-extended from bit 43
+    constexpr unsigned IMMEDIATE_BITS = 44;
+
+    inline uint64_t immediateValue(const Instruction& instr) {
+        uint64_t raw = static_cast<uint64_t>(instr.extension) << 32 | instr.immediate;
+        return static_cast<uint64_t>(static_cast<int64_t>(raw << (64 - IMMEDIATE_BITS)) >> (64 - IMMEDIATE_BITS));
+    }
+
+    inline bool fitsImmediate(uint64_t value) {
+        int64_t signedValue = static_cast<int64_t>(value);
+        return signedValue >= -(int64_t(1) << (IMMEDIATE_BITS - 1)) && signedValue < (int64_t(1) << (IMMEDIATE_BITS - 1));
+    }
+
+    inline void setImmediateValue(Instruction& instr, uint64_t value) {
+        instr.immediate = static_cast<uint32_t>(value);
+        instr.extension = static_cast<uint16_t>((value >> 32) & 0xFFF);
+    }
+
+    // First source of ADD/SUB/MUL/AND/OR/XOR/SHL/SHR: reg2 in the REGISTER3 form, where
+    // reg1 is only the destination
+    inline uint8_t aluSource(const Instruction& instr) {
+        return instr.mode == AddressingMode::REGISTER3 ? instr.reg2 : instr.reg1;
+    }
+
+    // Index register and scale (1, 2, 4, 8 as a shift of 0-3) of a BASE_INDEX operand,
+    // to be OR-ed into an instruction word
+    inline uint64_t makeIndexExtension(uint8_t index, unsigned scaleShift) {
+        return static_cast<uint64_t>(index | (scaleShift << 4)) << 32;
+    }
+
+    inline uint8_t indexRegister(const Instruction& instr) {
+        return static_cast<uint8_t>(instr.extension & 0xF);
+    }
+
+    inline unsigned indexScaleShift(const Instruction& instr) {
+        return (instr.extension >> 4) & 0x3;
+    }
+
+    // Displacement of the BASE_DISP and BASE_INDEX modes
+    inline int32_t displacement(const Instruction& instr) {
+        return static_cast<int32_t>(instr.immediate);
+    }
+
+    // Modes whose operand is memory at a register-relative address
+    inline bool isBaseAddressing(AddressingMode mode) {
+        return mode == AddressingMode::BASE_DISP || mode == AddressingMode::BASE_INDEX;
+    }
+
+    // Split an instruction word into its fields (inverse of makeInstruction)
+    inline Instruction decodeInstruction(uint64_t raw) {
+        Instruction instr;
+        instr.opcode = static_cast<Opcode>((raw >> 56) & 0xFF);
+        instr.mode = static_cast<AddressingMode>((raw >> 52) & 0xF);
+        instr.reg1 = (raw >> 48) & 0xF;
+        instr.reg2 = (raw >> 44) & 0xF;
+        instr.immediate = raw & 0xFFFFFFFF;
+        instr.extension = (raw >> 32) & 0xFFF;
+        return instr;
+    }
+}
+
+#endif // VM_INSTRUCTION_H
@@ -6,9 +6,13 @@
 #define VM_TYPES_H
 
 #include <cstdint>
+#include <cstddef>
 #include <array>
 
 namespace vm {
+    // Interpreter version, part of the key of persistent translation caches
+    constexpr uint32_t VM_VERSION = 4;
+
     // Register sizes
     constexpr size_t REGISTER_COUNT = 16;
     constexpr size_t REGISTER_SIZE = 8; // 64 bits
@@ -38,6 +42,7 @@ namespace vm {
         PUSH = 0x04,
         POP = 0x05,
         HLT = 0x06,
+        MOVW = 0x07,    // MOVW Rd, #imm64: the constant is the next code word
 
         // Arithmetic instructions
         ADD = 0x10,
@@ -49,6 +54,13 @@ namespace vm {
         DEC = 0x16,
         CMP = 0x17,
         SWAP = 0x18,
+        MULH = 0x19,    // High 64 bits of the signed 128-bit product
+        UMULH = 0x1A,   // Same, unsigned
+        IDIV = 0x1B,    // Signed division (truncates toward zero)
+        IMOD = 0x1C,    // Signed remainder (sign of the dividend)
+        ADC = 0x1D,     // Add with carry in
+        SBB = 0x1E,     // Subtract with borrow in
+        DIVMOD = 0x1F,  // DIVMOD Rq, Rr, Rd: Rq = Rq / Rd, Rr = Rq % Rd (unsigned)
 
         // Logical instructions
         AND = 0x20,
@@ -58,6 +70,16 @@ namespace vm {
         SHL = 0x24,
         SHR = 0x25,
 
+        // Bit manipulation instructions
+        POPCNT = 0x26,  // Rd = number of set bits in the operand
+        CLZ = 0x27,     // Rd = leading zero bits of the operand (64 for zero)
+        CTZ = 0x28,     // Rd = trailing zero bits of the operand (64 for zero)
+        ROL = 0x29,
+        ROR = 0x2A,
+        BSWAP = 0x2B,   // Reverse the byte order of a register
+        PEXT = 0x2C,    // Gather the bits of Rd selected by the operand mask
+        PDEP = 0x2D,    // Scatter the low bits of Rd to the operand mask positions
+
         // Control instructions
         JMP = 0x30,
         JZ = 0x31,
@@ -81,15 +103,74 @@ namespace vm {
         IN = 0x40,
         OUT = 0x41,
         PRINT = 0x44,
+        RDCNT = 0x45,   // Read performance counter
+        HCALL = 0x46,   // Call a host-registered native function
+
+        // Bulk memory instructions (three registers, resumable)
+        BCOPY = 0x50,   // Copy Rn bytes from [Rs] to [Rd]
+        BFILL = 0x51,   // Fill Rn bytes at [Rd] with the low byte of Rv
+        BCMP = 0x52,    // Compare Rn bytes at [Ra] and [Rb]
+        CRC32M = 0x53,  // Fold Rn bytes at [Ra] into the CRC32C in Rc
+
+        // Checksum instructions
+        CRC32 = 0x58,   // Fold the 8 bytes of the operand into the CRC32C in Rd
+        HASH = 0x59,    // Mix the operand into the 64-bit hash in Rd
+
+        // Vector instructions (256-bit registers V0-V15, see common/vector.h)
+        VLOAD = 0x60,
+        VSTORE = 0x61,
+        VBCAST = 0x62,      // Broadcast a general register to every lane
+        VEXTRACT = 0x63,    // Lane to general register
+        VINSERT = 0x64,     // General register to lane
+        VADD = 0x68,
+        VSUB = 0x69,
+        VMUL = 0x6A,        // Low half of each lane product
+        VAND = 0x6B,
+        VOR = 0x6C,
+        VXOR = 0x6D,
+        VSHL = 0x6E,
+        VSHR = 0x6F,        // Logical
+        VCMPEQ = 0x70,      // Lanes all ones where equal, else zero
+        VCMPGT = 0x71,      // Same for signed greater-than
+        VPERM = 0x72,       // Vd[i] = Va[Vb[i] mod lanes]
+        VMASK = 0x78,       // Top bit of each lane to a general register bit mask
+        VREDSUM = 0x79,     // Horizontal sum / unsigned min / unsigned max
+        VREDMIN = 0x7A,
+        VREDMAX = 0x7B,
+
+    };
+
+    // Performance counters (RDCNT operand / host getters)
+    enum class CounterType : uint8_t {
+        INSTRUCTIONS = 0,   // Instructions retired
+        CYCLES = 1,         // Cycles according to the per-opcode cost table
+        LOADS = 2,          // Data memory reads
+        STORES = 3,         // Data memory writes
+        BRANCHES = 4,       // Taken jumps (JMP, Jcc, LOOP)
+        CALLS = 5,          // CALL instructions
+        FAULTS = 6          // Faults (bad opcode, division by zero, memory violation)
+    };
+    constexpr size_t COUNTER_COUNT = 7;
+
+    struct PerformanceCounters {
+        std::array<uint64_t, COUNTER_COUNT> values;
+
+        PerformanceCounters() { values.fill(0); }
 
+        uint64_t Get(CounterType type) const { return values[static_cast<uint8_t>(type)]; }
+        uint64_t& operator[](CounterType type) { return values[static_cast<uint8_t>(type)]; }
+        void Reset() { values.fill(0); }
     };
 
     // Addressing mode
     enum class AddressingMode : uint8_t {
         REGISTER = 0,
-        IMMEDIATE = 1,
+        IMMEDIATE = 1,      // Signed 44-bit value: the immediate plus bits 32-43
         MEMORY = 2,
-        REGISTER_INDIRECT = 3
+        REGISTER_INDIRECT = 3,
+        BASE_DISP = 4,      // [Rn + disp]: signed 32-bit displacement in the immediate
+        BASE_INDEX = 5,     // [Rn + Ri*scale + disp]: index and scale in immediate bits 32-37
+        REGISTER3 = 6       // ADD Rd, Ra, Rb: Rd = Ra op Rb, Rb in the low bits of the immediate
     };
 
     // Instruction structure
@@ -99,9 +180,10 @@ namespace vm {
         uint8_t reg1;
         uint8_t reg2;
         uint32_t immediate;
+        uint16_t extension;     // Immediate bits 32-43
 
         Instruction() : opcode(Opcode::NOP), mode(AddressingMode::REGISTER),
-                       reg1(0), reg2(0), immediate(0) {}
+                       reg1(0), reg2(0), immediate(0), extension(0) {}
     };
 }
 
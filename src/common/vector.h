@@ -0,0 +1,90 @@
+// src/common/vector.h
+#ifndef VM_VECTOR_H
+#define VM_VECTOR_H
+
+#include <common/types.h>
+#include <cstring>
+
+namespace vm {
+    // Vector extension: 16 registers V0-V15 of 256 bits, split into 8/16/32/64-bit lanes.
+    //
+    // Vector instructions use the REGISTER mode word. reg1 and reg2 name the first two
+    // operands (vector or general registers depending on the form) and the immediate
+    // packs the rest:
+    //   bits 0-3   third register (Vb), read with thirdRegister() as for BCOPY
+    //   bits 4-5   element size: 0 = 8, 1 = 16, 2 = 32, 3 = 64 bits
+    //   bits 8-15  small immediate (shift count, lane index)
+    constexpr size_t VECTOR_REGISTER_COUNT = 16;
+    constexpr size_t VECTOR_BYTES = 32;
+
+    struct alignas(32) VectorRegister {
+        uint8_t bytes[VECTOR_BYTES];
+
+        template <typename T>
+        T Lane(size_t index) const {
+            T value;
+            std::memcpy(&value, bytes + index * sizeof(T), sizeof(T));
+            return value;
+        }
+
+        template <typename T>
+        void SetLane(size_t index, T value) {
+            std::memcpy(bytes + index * sizeof(T), &value, sizeof(T));
+        }
+    };
+
+    // Operand shapes, shared by the CPU, the assembler and the disassembler
+    enum class VectorForm : uint8_t {
+        NONE,       // Not a vector instruction
+        LOAD,       // VLOAD Vd, Rn            (32 bytes at [Rn])
+        STORE,      // VSTORE Rn, Vs
+        BROADCAST,  // VBCAST.s Vd, Rs
+        EXTRACT,    // VEXTRACT.s Rd, Va, #lane
+        INSERT,     // VINSERT.s Vd, Rs, #lane
+        BINARY,     // VADD.s Vd, Va, Vb
+        SHIFT,      // VSHL.s Vd, Va, #count
+        REDUCE      // VREDSUM.s Rd, Va       (lanes to a general register)
+    };
+
+    inline VectorForm GetVectorForm(Opcode opcode) {
+        switch (opcode) {
+            case Opcode::VLOAD:    return VectorForm::LOAD;
+            case Opcode::VSTORE:   return VectorForm::STORE;
+            case Opcode::VBCAST:   return VectorForm::BROADCAST;
+            case Opcode::VEXTRACT: return VectorForm::EXTRACT;
+            case Opcode::VINSERT:  return VectorForm::INSERT;
+            case Opcode::VADD:
+            case Opcode::VSUB:
+            case Opcode::VMUL:
+            case Opcode::VAND:
+            case Opcode::VOR:
+            case Opcode::VXOR:
+            case Opcode::VCMPEQ:
+            case Opcode::VCMPGT:
+            case Opcode::VPERM:    return VectorForm::BINARY;
+            case Opcode::VSHL:
+            case Opcode::VSHR:     return VectorForm::SHIFT;
+            case Opcode::VMASK:
+            case Opcode::VREDSUM:
+            case Opcode::VREDMIN:
+            case Opcode::VREDMAX:  return VectorForm::REDUCE;
+            default:               return VectorForm::NONE;
+        }
+    }
+
+    // Whether the element size suffix (.8/.16/.32/.64) is meaningful
+    inline bool HasElementSize(Opcode opcode) {
+        VectorForm form = GetVectorForm(opcode);
+        return form != VectorForm::NONE && form != VectorForm::LOAD && form != VectorForm::STORE &&
+               opcode != Opcode::VAND && opcode != Opcode::VOR && opcode != Opcode::VXOR;
+    }
+
+    inline uint32_t makeVectorImmediate(uint8_t reg3, unsigned sizeCode, uint8_t value) {
+        return (reg3 & 0xFu) | ((sizeCode & 3u) << 4) | (static_cast<uint32_t>(value) << 8);
+    }
+
+    inline unsigned vectorSizeCode(const Instruction& instr) { return (instr.immediate >> 4) & 3; }
+    inline uint8_t vectorImmediate(const Instruction& instr) { return (instr.immediate >> 8) & 0xFF; }
+}
+
+#endif // VM_VECTOR_H
@@ -0,0 +1,199 @@
+// src/cpu/checksum_unit.cpp
+#include "checksum_unit.h"
+#include <array>
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define VM_CRC_SSE42 1
+#include <immintrin.h>
+#endif
+
+namespace vm {
+    namespace {
+        constexpr uint32_t kCastagnoli = 0x82F63B78;    // Reflected polynomial
+        constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+        constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+        constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+
+        bool sAccelerate = true;
+
+        using SliceTables = std::array<std::array<uint32_t, 256>, 8>;
+
+        // tables[0] is the byte-at-a-time table; tables[k] advances a byte through k more zero bytes
+        constexpr SliceTables BuildSliceTables() {
+            SliceTables tables{};
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t crc = n;
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc >> 1) ^ (kCastagnoli & (0 - (crc & 1)));
+                }
+                tables[0][n] = crc;
+            }
+            for (uint32_t n = 0; n < 256; ++n) {
+                for (size_t k = 1; k < 8; ++k) {
+                    uint32_t previous = tables[k - 1][n];
+                    tables[k][n] = (previous >> 8) ^ tables[0][previous & 0xFF];
+                }
+            }
+            return tables;
+        }
+
+        constexpr SliceTables kSlices = BuildSliceTables();
+
+        uint32_t SoftwareWord(uint32_t crc, uint64_t word) {
+            word ^= crc;
+            return kSlices[7][word & 0xFF] ^ kSlices[6][(word >> 8) & 0xFF] ^
+                   kSlices[5][(word >> 16) & 0xFF] ^ kSlices[4][(word >> 24) & 0xFF] ^
+                   kSlices[3][(word >> 32) & 0xFF] ^ kSlices[2][(word >> 40) & 0xFF] ^
+                   kSlices[1][(word >> 48) & 0xFF] ^ kSlices[0][word >> 56];
+        }
+
+        uint32_t SoftwareCrc(uint32_t crc, const uint8_t* data, size_t size) {
+            for (; size >= 8; data += 8, size -= 8) {
+                uint64_t word;
+                std::memcpy(&word, data, sizeof(word));
+                crc = SoftwareWord(crc, word);
+            }
+            for (; size > 0; ++data, --size) {
+                crc = kSlices[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+            }
+            return crc;
+        }
+
+#ifdef VM_CRC_SSE42
+        // Stream lengths of the three-way interleaved loop (powers of two)
+        constexpr size_t kLongStream = 8192;
+        constexpr size_t kShortStream = 256;
+
+        bool HostHasSse42() {
+            static const bool hasSse42 = __builtin_cpu_supports("sse4.2");
+            return hasSse42;
+        }
+
+        // Appending `length` zero bytes to a CRC is linear in the CRC bits: the tables hold the
+        // image of every byte of the CRC, so a shift costs four lookups
+        struct ZeroShift {
+            std::array<std::array<uint32_t, 256>, 4> tables{};
+
+            explicit ZeroShift(size_t length) {
+                static const uint8_t zeros[kLongStream] = {};
+                uint32_t basis[32];
+                for (int bit = 0; bit < 32; ++bit) {
+                    basis[bit] = SoftwareCrc(uint32_t(1) << bit, zeros, length);
+                }
+                for (uint32_t n = 0; n < 256; ++n) {
+                    for (int byte = 0; byte < 4; ++byte) {
+                        uint32_t image = 0;
+                        for (int bit = 0; bit < 8; ++bit) {
+                            if (n & (1u << bit)) {
+                                image ^= basis[byte * 8 + bit];
+                            }
+                        }
+                        tables[byte][n] = image;
+                    }
+                }
+            }
+
+            uint32_t operator()(uint32_t crc) const {
+                return tables[0][crc & 0xFF] ^ tables[1][(crc >> 8) & 0xFF] ^
+                       tables[2][(crc >> 16) & 0xFF] ^ tables[3][crc >> 24];
+            }
+        };
+
+        __attribute__((target("sse4.2")))
+        inline uint64_t Crc32Step(uint64_t crc, const uint8_t* data) {
+            uint64_t word;
+            std::memcpy(&word, data, sizeof(word));
+            return _mm_crc32_u64(crc, word);
+        }
+
+        // crc32 has a latency of three cycles but a throughput of one: run three independent
+        // streams and merge them by shifting the earlier CRCs over the later streams' lengths
+        __attribute__((target("sse4.2")))
+        size_t Interleaved(uint64_t& crc, const uint8_t*& data, size_t size, size_t stream, const ZeroShift& shift) {
+            size_t done = 0;
+            for (; size - done >= 3 * stream; done += 3 * stream) {
+                uint64_t crc0 = crc;
+                uint64_t crc1 = 0;
+                uint64_t crc2 = 0;
+                for (const uint8_t* end = data + stream; data < end; data += 8) {
+                    crc0 = Crc32Step(crc0, data);
+                    crc1 = Crc32Step(crc1, data + stream);
+                    crc2 = Crc32Step(crc2, data + 2 * stream);
+                }
+                crc = shift(shift(static_cast<uint32_t>(crc0)) ^ static_cast<uint32_t>(crc1)) ^
+                      static_cast<uint32_t>(crc2);
+                data += 2 * stream;
+            }
+            return done;
+        }
+
+        __attribute__((target("sse4.2")))
+        uint32_t HardwareCrc(uint32_t crc32, const uint8_t* data, size_t size) {
+            static const ZeroShift longShift(kLongStream);
+            static const ZeroShift shortShift(kShortStream);
+
+            uint64_t crc = crc32;
+            size -= Interleaved(crc, data, size, kLongStream, longShift);
+            size -= Interleaved(crc, data, size, kShortStream, shortShift);
+            for (; size >= 8; data += 8, size -= 8) {
+                crc = Crc32Step(crc, data);
+            }
+            for (; size > 0; ++data, --size) {
+                crc = _mm_crc32_u8(static_cast<uint32_t>(crc), *data);
+            }
+            return static_cast<uint32_t>(crc);
+        }
+
+        __attribute__((target("sse4.2")))
+        uint32_t HardwareWord(uint32_t crc, uint64_t word) {
+            return static_cast<uint32_t>(_mm_crc32_u64(crc, word));
+        }
+#endif
+
+        bool UseSse42() {
+#ifdef VM_CRC_SSE42
+            return sAccelerate && HostHasSse42();
+#else
+            return false;
+#endif
+        }
+    }
+
+    uint32_t ChecksumUnit::Crc32c(uint32_t crc, const uint8_t* data, size_t size) {
+#ifdef VM_CRC_SSE42
+        if (UseSse42()) {
+            return HardwareCrc(crc, data, size);
+        }
+#endif
+        return SoftwareCrc(crc, data, size);
+    }
+
+    uint32_t ChecksumUnit::Crc32cWord(uint32_t crc, uint64_t word) {
+#ifdef VM_CRC_SSE42
+        if (UseSse42()) {
+            return HardwareWord(crc, word);
+        }
+#endif
+        return SoftwareWord(crc, word);
+    }
+
+    uint64_t ChecksumUnit::Hash(uint64_t seed, uint64_t value) {
+        uint64_t hash = std::rotl(seed + value * kPrime2, 31) * kPrime1;
+        hash ^= hash >> 33;
+        hash *= kPrime2;
+        hash ^= hash >> 29;
+        hash *= kPrime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    bool ChecksumUnit::UsesSse42() {
+        return UseSse42();
+    }
+
+    void ChecksumUnit::EnableHostAcceleration(bool enable) {
+        sAccelerate = enable;
+    }
+}
@@ -0,0 +1,27 @@
+// src/cpu/checksum_unit.h
+#ifndef VM_CHECKSUM_UNIT_H
+#define VM_CHECKSUM_UNIT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vm {
+    // Kernels behind CRC32, CRC32M and HASH. CRC32C (Castagnoli) is computed without the
+    // initial and final inversion, like the SSE4.2 crc32 instruction: start from 0xFFFFFFFF
+    // and XOR the result with 0xFFFFFFFF to get the standard checksum. On x86-64 the crc32
+    // instruction is used when the host has it (checked once); otherwise slicing-by-8 tables.
+    class ChecksumUnit {
+    public:
+        static uint32_t Crc32c(uint32_t crc, const uint8_t* data, size_t size);
+        static uint32_t Crc32cWord(uint32_t crc, uint64_t word);    // The 8 bytes of word, little-endian
+
+        // 64-bit mix of a running hash and one more word (full avalanche on every step)
+        static uint64_t Hash(uint64_t seed, uint64_t value);
+
+        // Whether SSE4.2 is in use; disabling it forces the table code
+        static bool UsesSse42();
+        static void EnableHostAcceleration(bool enable);
+    };
+}
+
+#endif // VM_CHECKSUM_UNIT_H
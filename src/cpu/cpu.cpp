@@ -3,14 +3,28 @@
 //
 
 #include "cpu.h"
+#include <common/bits.h>
+#include <common/instruction.h>
+#include <cpu/checksum_unit.h>
+#include <cpu/vector_unit.h>
+#include <algorithm>
+#include <bit>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <cstdlib>
+#include <cstring>
+#include <stdexcept>
 
 #ifdef _WIN32
 #include <windows.h>
 #endif
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define VM_BMI2 1
+#include <immintrin.h>
+#endif
+
 namespace vm {
     // Utility function to convert opcode to string
     const char* OpcodeToString(Opcode opcode) {
@@ -21,6 +35,7 @@ namespace vm {
             case Opcode::PUSH:  return "PUSH";
             case Opcode::POP:   return "POP";
             case Opcode::HLT:   return "HLT";
+            case Opcode::MOVW:  return "MOVW";
 
             case Opcode::ADD:   return "ADD";
             case Opcode::SUB:   return "SUB";
@@ -31,6 +46,13 @@ namespace vm {
             case Opcode::DEC:   return "DEC";
             case Opcode::CMP:   return "CMP";
             case Opcode::SWAP:  return "SWAP";
+            case Opcode::MULH:  return "MULH";
+            case Opcode::UMULH: return "UMULH";
+            case Opcode::IDIV:  return "IDIV";
+            case Opcode::IMOD:  return "IMOD";
+            case Opcode::ADC:   return "ADC";
+            case Opcode::SBB:   return "SBB";
+            case Opcode::DIVMOD: return "DIVMOD";
 
             case Opcode::AND:   return "AND";
             case Opcode::OR:    return "OR";
@@ -38,6 +60,14 @@ namespace vm {
             case Opcode::NOT:   return "NOT";
             case Opcode::SHL:   return "SHL";
             case Opcode::SHR:   return "SHR";
+            case Opcode::POPCNT: return "POPCNT";
+            case Opcode::CLZ:   return "CLZ";
+            case Opcode::CTZ:   return "CTZ";
+            case Opcode::ROL:   return "ROL";
+            case Opcode::ROR:   return "ROR";
+            case Opcode::BSWAP: return "BSWAP";
+            case Opcode::PEXT:  return "PEXT";
+            case Opcode::PDEP:  return "PDEP";
 
             case Opcode::JMP:   return "JMP";
             case Opcode::JZ:    return "JZ";
@@ -58,21 +88,152 @@ namespace vm {
             case Opcode::PRINT: return "PRINT";
             case Opcode::IN:    return "IN";
             case Opcode::OUT:   return "OUT";
+            case Opcode::RDCNT: return "RDCNT";
+            case Opcode::HCALL: return "HCALL";
+            case Opcode::BCOPY: return "BCOPY";
+            case Opcode::BFILL: return "BFILL";
+            case Opcode::BCMP:  return "BCMP";
+            case Opcode::CRC32M: return "CRC32M";
+            case Opcode::CRC32: return "CRC32";
+            case Opcode::HASH:  return "HASH";
+            case Opcode::VLOAD:    return "VLOAD";
+            case Opcode::VSTORE:   return "VSTORE";
+            case Opcode::VBCAST:   return "VBCAST";
+            case Opcode::VEXTRACT: return "VEXTRACT";
+            case Opcode::VINSERT:  return "VINSERT";
+            case Opcode::VADD:     return "VADD";
+            case Opcode::VSUB:     return "VSUB";
+            case Opcode::VMUL:     return "VMUL";
+            case Opcode::VAND:     return "VAND";
+            case Opcode::VOR:      return "VOR";
+            case Opcode::VXOR:     return "VXOR";
+            case Opcode::VSHL:     return "VSHL";
+            case Opcode::VSHR:     return "VSHR";
+            case Opcode::VCMPEQ:   return "VCMPEQ";
+            case Opcode::VCMPGT:   return "VCMPGT";
+            case Opcode::VPERM:    return "VPERM";
+            case Opcode::VMASK:    return "VMASK";
+            case Opcode::VREDSUM:  return "VREDSUM";
+            case Opcode::VREDMIN:  return "VREDMIN";
+            case Opcode::VREDMAX:  return "VREDMAX";
 
             default:            return "UNKNOWN";
         }
     }
 
-    CPU::CPU(Memory* mem) : mMemory(mem), mRunning(false), mDebug(false), mStepByStep(false) {
+    // Cycle cost of each opcode, used by the CYCLES counter
+    static constexpr std::array<uint8_t, 256> BuildCycleCostTable() {
+        std::array<uint8_t, 256> costs{};
+        for (auto& cost : costs) {
+            cost = 1;
+        }
+        costs[static_cast<uint8_t>(Opcode::MOVW)] = 2;
+        costs[static_cast<uint8_t>(Opcode::LOAD)] = 3;
+        costs[static_cast<uint8_t>(Opcode::STORE)] = 3;
+        costs[static_cast<uint8_t>(Opcode::PUSH)] = 2;
+        costs[static_cast<uint8_t>(Opcode::POP)] = 2;
+        costs[static_cast<uint8_t>(Opcode::MUL)] = 3;
+        costs[static_cast<uint8_t>(Opcode::PEXT)] = 3;
+        costs[static_cast<uint8_t>(Opcode::PDEP)] = 3;
+        costs[static_cast<uint8_t>(Opcode::DIV)] = 20;
+        costs[static_cast<uint8_t>(Opcode::MOD)] = 20;
+        costs[static_cast<uint8_t>(Opcode::MULH)] = 3;
+        costs[static_cast<uint8_t>(Opcode::UMULH)] = 3;
+        costs[static_cast<uint8_t>(Opcode::IDIV)] = 20;
+        costs[static_cast<uint8_t>(Opcode::IMOD)] = 20;
+        costs[static_cast<uint8_t>(Opcode::DIVMOD)] = 20;
+        costs[static_cast<uint8_t>(Opcode::JMP)] = 2;
+        costs[static_cast<uint8_t>(Opcode::CALL)] = 3;
+        costs[static_cast<uint8_t>(Opcode::RET)] = 3;
+        costs[static_cast<uint8_t>(Opcode::IN)] = 10;
+        costs[static_cast<uint8_t>(Opcode::OUT)] = 10;
+        costs[static_cast<uint8_t>(Opcode::PRINT)] = 10;
+        costs[static_cast<uint8_t>(Opcode::HCALL)] = 10;
+        costs[static_cast<uint8_t>(Opcode::BCOPY)] = 4;   // Plus one cycle per 32 bytes
+        costs[static_cast<uint8_t>(Opcode::BFILL)] = 4;
+        costs[static_cast<uint8_t>(Opcode::BCMP)] = 4;
+        costs[static_cast<uint8_t>(Opcode::CRC32M)] = 4;
+        costs[static_cast<uint8_t>(Opcode::CRC32)] = 3;
+        costs[static_cast<uint8_t>(Opcode::HASH)] = 3;
+        costs[static_cast<uint8_t>(Opcode::VLOAD)] = 3;
+        costs[static_cast<uint8_t>(Opcode::VSTORE)] = 3;
+        costs[static_cast<uint8_t>(Opcode::VMUL)] = 3;
+        costs[static_cast<uint8_t>(Opcode::VREDSUM)] = 2;
+        costs[static_cast<uint8_t>(Opcode::VREDMIN)] = 2;
+        costs[static_cast<uint8_t>(Opcode::VREDMAX)] = 2;
+        return costs;
+    }
+
+    static constexpr std::array<uint8_t, 256> kCycleCosts = BuildCycleCostTable();
+
+    uint8_t CPU::GetCycleCost(Opcode opcode) {
+        return kCycleCosts[static_cast<uint8_t>(opcode)];
+    }
+
+    // Opcodes the CPU implements (the ones OpcodeToString names), looked up by the
+    // verifier and optimizer once per instruction
+    static constexpr bool IsImplementedOpcode(Opcode opcode) {
+        switch (opcode) {
+            case Opcode::MOV: case Opcode::LOAD: case Opcode::STORE: case Opcode::PUSH:
+            case Opcode::POP: case Opcode::HLT: case Opcode::MOVW: case Opcode::ADD:
+            case Opcode::SUB: case Opcode::MUL: case Opcode::DIV: case Opcode::MOD:
+            case Opcode::INC: case Opcode::DEC: case Opcode::CMP: case Opcode::SWAP:
+            case Opcode::MULH: case Opcode::UMULH: case Opcode::IDIV: case Opcode::IMOD:
+            case Opcode::ADC: case Opcode::SBB: case Opcode::DIVMOD: case Opcode::AND:
+            case Opcode::OR: case Opcode::XOR: case Opcode::NOT: case Opcode::SHL: case Opcode::SHR:
+            case Opcode::POPCNT: case Opcode::CLZ: case Opcode::CTZ: case Opcode::ROL:
+            case Opcode::ROR: case Opcode::BSWAP: case Opcode::PEXT: case Opcode::PDEP:
+            case Opcode::JMP: case Opcode::JZ: case Opcode::JNZ: case Opcode::JEQ: case Opcode::JNE:
+            case Opcode::JC: case Opcode::JNC: case Opcode::JL: case Opcode::JLE: case Opcode::JG:
+            case Opcode::JGE: case Opcode::LOOP: case Opcode::CALL: case Opcode::RET:
+            case Opcode::NOP: case Opcode::PRINT: case Opcode::IN: case Opcode::OUT:
+            case Opcode::RDCNT: case Opcode::HCALL: case Opcode::BCOPY: case Opcode::BFILL:
+            case Opcode::BCMP: case Opcode::CRC32M: case Opcode::CRC32: case Opcode::HASH:
+            case Opcode::VLOAD: case Opcode::VSTORE: case Opcode::VBCAST: case Opcode::VEXTRACT:
+            case Opcode::VINSERT: case Opcode::VADD: case Opcode::VSUB: case Opcode::VMUL:
+            case Opcode::VAND: case Opcode::VOR: case Opcode::VXOR: case Opcode::VSHL:
+            case Opcode::VSHR: case Opcode::VCMPEQ: case Opcode::VCMPGT: case Opcode::VPERM:
+            case Opcode::VMASK: case Opcode::VREDSUM: case Opcode::VREDMIN: case Opcode::VREDMAX:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    static constexpr std::array<bool, 256> BuildValidOpcodeTable() {
+        std::array<bool, 256> valid{};
+        for (size_t i = 0; i < valid.size(); ++i) {
+            valid[i] = IsImplementedOpcode(static_cast<Opcode>(i));
+        }
+        return valid;
+    }
+
+    static constexpr std::array<bool, 256> kValidOpcodes = BuildValidOpcodeTable();
+
+    bool IsValidOpcode(Opcode opcode) {
+        return kValidOpcodes[static_cast<uint8_t>(opcode)];
+    }
+
+    CPU::CPU(Memory* mem)
+        : mMemory(mem), mRunning(false), mDebug(false), mStepByStep(false), mDecodeGeneration(0),
+          mInstructionLimit(UINT64_MAX), mLimitReached(false) {
         Reset();
     }
 
     void CPU::Reset() {
         mRegisters.fill(0);
+        mVectors.fill(VectorRegister{});
         mPC = 0;
+        mCurrentPC.store(0, std::memory_order_relaxed);
         mSP = mMemory->GetSize() - 16;
         mFlags = 0;
+        mCallDepth.store(0, std::memory_order_relaxed);
+        mCounters.Reset();
+        mClock.Reset();
+        mDecodeCache.Clear();
+        mConsole.ClearLastDiagnostic();
         mRunning = false;
+        mLimitReached = false;
     }
 
     void CPU::ClearScreen() const {
@@ -88,8 +249,17 @@ namespace vm {
         std::cin.get();
     }
 
+    bool CPU::CheckInstructionLimit() {
+        if (mCounters[CounterType::INSTRUCTIONS] < mInstructionLimit) {
+            return true;
+        }
+        mLimitReached = true;
+        mRunning = false;
+        return false;
+    }
+
     void CPU::Step() {
-        if (!mRunning) return;
+        if (!mRunning || !CheckInstructionLimit()) return;
 
         if (mDebug && mStepByStep) {
             ClearScreen(); // Clear screen before each step
@@ -98,6 +268,9 @@ namespace vm {
         Instruction instr;
         FetchInstruction(instr);
 
+        ++mCounters[CounterType::INSTRUCTIONS];
+        mCounters[CounterType::CYCLES] += kCycleCosts[static_cast<uint8_t>(instr.opcode)];
+
         if (mDebug) {
             std::cout << "╔════════════════════════════════════════════════════════════╗" << std::endl;
             std::cout << "║                    EXECUTION STEP                          ║" << std::endl;
@@ -114,7 +287,12 @@ namespace vm {
             PrintState();
         }
 
-        ExecuteInstruction(instr);
+        try {
+            ExecuteInstruction(instr);
+        } catch (...) {
+            ++mCounters[CounterType::FAULTS];
+            throw;
+        }
 
         if (mDebug) {
             std::cout << "\n┌─ State AFTER execution ─┐" << std::endl;
@@ -129,27 +307,115 @@ namespace vm {
 
     void CPU::Run() {
         mRunning = true;
+        mLimitReached = false;
+        if (!mDebug && !mDecodeCache.IsEmpty()) {
+            RunDecoded();
+            return;
+        }
         while (mRunning) {
             Step();
         }
     }
 
-    void CPU::FetchInstruction(Instruction& instr) {
-        // Read instruction from memory
-        uint64_t raw_instr = mMemory->Read64(mPC);
+    void CPU::RunDecoded() {
+        while (mRunning) {
+            if (mDecodeGeneration != mMemory->GetCodeGeneration()) {
+                // Self-modifying code: forget the decoded copy, finish on the slow path
+                mDecodeCache.Clear();
+                while (mRunning) {
+                    Step();
+                }
+                return;
+            }
+
+            if (!CheckInstructionLimit()) {
+                return;
+            }
+
+            const DecodedInstruction* entry = mDecodeCache.Lookup(mPC);
+            if (!entry) {
+                Step(); // Outside the decoded range
+                continue;
+            }
+            if (entry->flags & DECODED_VERIFIED_BLOCK) {
+                ExecuteBlock(entry);
+                continue;
+            }
+
+            mCurrentPC.store(mPC, std::memory_order_relaxed);
+            mPC += 8;
+            ++mCounters[CounterType::INSTRUCTIONS];
+            mCounters[CounterType::CYCLES] += entry->cycles;
+
+            try {
+                ExecuteInstruction(entry->instr);
+            } catch (...) {
+                ++mCounters[CounterType::FAULTS];
+                throw;
+            }
+        }
+    }
+
+    // Straight-line run of statically verified instructions: one lookup and one counter
+    // update per block. Only the last instruction can branch, so the entries are
+    // consecutive; the run stops early on HLT/fault and when the guest writes to code.
+    void CPU::ExecuteBlock(const DecodedInstruction* block) {
+        size_t length = block->blockLength;
+        mCounters[CounterType::INSTRUCTIONS] += length;
+        mCounters[CounterType::CYCLES] += block->blockCycles;
+
+        size_t executed = 0;
+        try {
+            while (executed < length) {
+                mCurrentPC.store(mPC, std::memory_order_relaxed);
+                mPC += 8;
+                ExecuteInstruction(block[executed++].instr);
+                if (!mRunning || mDecodeGeneration != mMemory->GetCodeGeneration()) {
+                    break;
+                }
+            }
+        } catch (...) {
+            ++mCounters[CounterType::FAULTS];
+            RefundBlock(block, executed);
+            throw;
+        }
+
+        if (executed < length) {
+            RefundBlock(block, executed);
+        }
+    }
+
+    void CPU::RefundBlock(const DecodedInstruction* block, size_t executed) {
+        for (size_t i = executed; i < block->blockLength; ++i) {
+            --mCounters[CounterType::INSTRUCTIONS];
+            mCounters[CounterType::CYCLES] -= block[i].cycles;
+        }
+    }
 
-        instr.opcode = static_cast<Opcode>((raw_instr >> 56) & 0xFF);
-        instr.mode = static_cast<AddressingMode>((raw_instr >> 52) & 0xF);
-        instr.reg1 = (raw_instr >> 48) & 0xF;
-        instr.reg2 = (raw_instr >> 44) & 0xF;
-        instr.immediate = raw_instr & 0xFFFFFFFF;
+    void CPU::DecodeCode(uint64_t base, size_t count) {
+        const uint8_t* code = mMemory->GetSpan(base, count * sizeof(uint64_t), AccessType::READ);
+        mDecodeCache.Build(code, base, count);
+        mMemory->SetCodeRange(base, count * sizeof(uint64_t));
+        mDecodeGeneration = mMemory->GetCodeGeneration();
+    }
+
+    void CPU::AttachDecodedCode(std::shared_ptr<const DecodedInstruction> entries, uint64_t base, size_t count) {
+        mDecodeCache.Attach(std::move(entries), base, count);
+        mMemory->SetCodeRange(base, count * sizeof(uint64_t));
+        mDecodeGeneration = mMemory->GetCodeGeneration();
+    }
 
+    void CPU::FetchInstruction(Instruction& instr) {
+        // Read instruction from memory
+        mCurrentPC.store(mPC, std::memory_order_relaxed);
+        instr = decodeInstruction(mMemory->Read64(mPC));
         mPC += 8; // 64-bit instruction
     }
 
     void CPU::ExecuteInstruction(const Instruction& instr) {
         switch (instr.opcode) {
             case Opcode::MOV:   ExecuteMov(instr); break;
+            case Opcode::MOVW:  ExecuteMovw(instr); break;
             case Opcode::LOAD:  ExecuteLoad(instr); break;
             case Opcode::STORE: ExecuteStore(instr); break;
             case Opcode::PUSH:  ExecutePush(instr); break;
@@ -160,6 +426,13 @@ namespace vm {
             case Opcode::MUL:   ExecuteMul(instr); break;
             case Opcode::DIV:   ExecuteDiv(instr); break;
             case Opcode::MOD:   ExecuteMod(instr); break;
+            case Opcode::MULH:  ExecuteMulh(instr); break;
+            case Opcode::UMULH: ExecuteUmulh(instr); break;
+            case Opcode::IDIV:  ExecuteIdiv(instr); break;
+            case Opcode::IMOD:  ExecuteImod(instr); break;
+            case Opcode::ADC:   ExecuteAdc(instr); break;
+            case Opcode::SBB:   ExecuteSbb(instr); break;
+            case Opcode::DIVMOD: ExecuteDivmod(instr); break;
             case Opcode::INC:   ExecuteInc(instr); break;
             case Opcode::DEC:   ExecuteDec(instr); break;
             case Opcode::CMP:   ExecuteCmp(instr); break;
@@ -171,6 +444,14 @@ namespace vm {
             case Opcode::NOT:   ExecuteNot(instr); break;
             case Opcode::SHL:   ExecuteShl(instr); break;
             case Opcode::SHR:   ExecuteShr(instr); break;
+            case Opcode::POPCNT: ExecutePopcnt(instr); break;
+            case Opcode::CLZ:   ExecuteClz(instr); break;
+            case Opcode::CTZ:   ExecuteCtz(instr); break;
+            case Opcode::ROL:   ExecuteRol(instr); break;
+            case Opcode::ROR:   ExecuteRor(instr); break;
+            case Opcode::BSWAP: ExecuteBswap(instr); break;
+            case Opcode::PEXT:  ExecutePext(instr); break;
+            case Opcode::PDEP:  ExecutePdep(instr); break;
 
             case Opcode::JMP:   ExecuteJmp(instr); break;
             case Opcode::JZ:    ExecuteJz(instr); break;
@@ -192,10 +473,43 @@ namespace vm {
             case Opcode::PRINT: ExecutePrint(instr); break;
             case Opcode::IN:    ExecuteIn(instr); break;
             case Opcode::OUT:   ExecuteOut(instr); break;
+            case Opcode::RDCNT: ExecuteRdcnt(instr); break;
+            case Opcode::HCALL: ExecuteHcall(instr); break;
+            case Opcode::BCOPY: ExecuteBcopy(instr); break;
+            case Opcode::BFILL: ExecuteBfill(instr); break;
+            case Opcode::BCMP:  ExecuteBcmp(instr); break;
+            case Opcode::CRC32M: ExecuteCrc32m(instr); break;
+            case Opcode::CRC32: ExecuteCrc32(instr); break;
+            case Opcode::HASH:  ExecuteHash(instr); break;
+            case Opcode::VLOAD:
+            case Opcode::VSTORE:
+            case Opcode::VBCAST:
+            case Opcode::VEXTRACT:
+            case Opcode::VINSERT:
+            case Opcode::VADD:
+            case Opcode::VSUB:
+            case Opcode::VMUL:
+            case Opcode::VAND:
+            case Opcode::VOR:
+            case Opcode::VXOR:
+            case Opcode::VSHL:
+            case Opcode::VSHR:
+            case Opcode::VCMPEQ:
+            case Opcode::VCMPGT:
+            case Opcode::VPERM:
+            case Opcode::VMASK:
+            case Opcode::VREDSUM:
+            case Opcode::VREDMIN:
+            case Opcode::VREDMAX: ExecuteVector(instr); break;
             case Opcode::NOP:   break; // Do nothing
             default:
-                std::cerr << "[ERROR] Unimplemented instruction: " << OpcodeToString(instr.opcode)
-                         << " (0x" << std::hex << static_cast<int>(instr.opcode) << ")" << std::endl;
+                ++mCounters[CounterType::FAULTS];
+                {
+                    std::ostringstream message;
+                    message << "[ERROR] Unimplemented instruction: " << OpcodeToString(instr.opcode)
+                            << " (0x" << std::hex << static_cast<int>(instr.opcode) << ")";
+                    mConsole.Diagnostic(message.str());
+                }
                 Halt();
         }
     }
@@ -205,32 +519,43 @@ namespace vm {
         SetOperandValue(instr, value, false); // Destination
     }
 
+    void CPU::ExecuteMovw(const Instruction& instr) {
+        // The constant is the next code word, which mPC already points at
+        mRegisters[instr.reg1] = mMemory->Read64(mPC);
+        mPC += 8;
+    }
+
     void CPU::ExecuteLoad(const Instruction& instr) {
-        uint64_t address = GetOperandValue(instr, true);
+        // [Rn + disp] names the address itself; the older modes produce it as an operand value
+        uint64_t address = isBaseAddressing(instr.mode) ? EffectiveAddress(instr, true) : GetOperandValue(instr, true);
         uint64_t value = mMemory->Read64(address);
         mRegisters[instr.reg1] = value;
+        ++mCounters[CounterType::LOADS];
     }
 
     void CPU::ExecuteStore(const Instruction& instr) {
-        uint64_t address = GetOperandValue(instr, false);
+        uint64_t address = isBaseAddressing(instr.mode) ? EffectiveAddress(instr, false) : GetOperandValue(instr, false);
         uint64_t value = mRegisters[instr.reg2];
         mMemory->Write64(address, value);
+        ++mCounters[CounterType::STORES];
     }
 
     void CPU::ExecutePush(const Instruction& instr) {
         uint64_t value = GetOperandValue(instr);
         mSP -= 8;
         mMemory->Write64(mSP, value);
+        ++mCounters[CounterType::STORES];
     }
 
     void CPU::ExecutePop(const Instruction& instr) {
         uint64_t value = mMemory->Read64(mSP);
         mRegisters[instr.reg1] = value;
         mSP += 8;
+        ++mCounters[CounterType::LOADS];
     }
 
     void CPU::ExecuteAdd(const Instruction& instr) {
-        uint64_t op1 = mRegisters[instr.reg1];
+        uint64_t op1 = mRegisters[aluSource(instr)];
         uint64_t op2 = GetOperandValue(instr, true);
         uint64_t result = op1 + op2;
 
@@ -239,7 +564,7 @@ namespace vm {
     }
 
     void CPU::ExecuteSub(const Instruction& instr) {
-        uint64_t op1 = mRegisters[instr.reg1];
+        uint64_t op1 = mRegisters[aluSource(instr)];
         uint64_t op2 = GetOperandValue(instr, true);
         uint64_t result = op1 - op2;
 
@@ -266,6 +591,7 @@ namespace vm {
     void CPU::ExecuteJmp(const Instruction& instr) {
         uint64_t address = GetOperandValue(instr);
         mPC = address;
+        ++mCounters[CounterType::BRANCHES];
         
         if (mDebug) {
             std::cout << "JMP to address 0x" << std::hex << address << std::endl;
@@ -276,6 +602,7 @@ namespace vm {
         if (GetFlag(FlagType::ZERO)) {
             uint64_t address = GetOperandValue(instr);
             mPC = address;
+            ++mCounters[CounterType::BRANCHES];
             
             if (mDebug) {
                 std::cout << "JZ taken to address 0x" << std::hex << address << std::endl;
@@ -291,6 +618,7 @@ namespace vm {
         if (!GetFlag(FlagType::ZERO)) {
             uint64_t address = GetOperandValue(instr);
             mPC = address;
+            ++mCounters[CounterType::BRANCHES];
             
             if (mDebug) {
                 std::cout << "JNZ taken to address 0x" << std::hex << address << std::endl;
@@ -326,6 +654,10 @@ namespace vm {
         // Jump to function
         uint64_t address = GetOperandValue(instr);
         mPC = address;
+        // Single writer: a relaxed load and store, no locked read-modify-write
+        mCallDepth.store(mCallDepth.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        ++mCounters[CounterType::STORES];
+        ++mCounters[CounterType::CALLS];
         
         if (mDebug) {
             std::cout << "CALL to address 0x" << std::hex << address << std::endl;
@@ -337,6 +669,11 @@ namespace vm {
         uint64_t return_address = mMemory->Read64(mSP);
         mSP += 8;
         mPC = return_address;
+        ++mCounters[CounterType::LOADS];
+        uint64_t depth = mCallDepth.load(std::memory_order_relaxed);
+        if (depth > 0) {
+            mCallDepth.store(depth - 1, std::memory_order_relaxed);
+        }
         
         if (mDebug) {
             std::cout << "🔙 RET to address 0x" << std::hex << return_address << std::endl;
@@ -377,11 +714,11 @@ namespace vm {
     }
 
     void CPU::ExecuteMul(const Instruction& instr) {
-        uint64_t op1 = mRegisters[instr.reg1];
+        uint64_t op1 = mRegisters[aluSource(instr)];
         uint64_t op2 = GetOperandValue(instr, true);
 
-        uint64_t result = op1 * op2;
-        bool overflow = (op2 != 0) && (result / op2 != op1);
+        uint64_t result;
+        bool overflow = __builtin_mul_overflow(op1, op2, &result);
 
         mRegisters[instr.reg1] = result;
         UpdateFlags(result, false, overflow);
@@ -404,6 +741,7 @@ namespace vm {
                 std::cerr << "DIV: Division by zero! R" << static_cast<int>(instr.reg1)
                           << " (0x" << std::hex << op1 << ") / 0" << std::endl;
             }
+            ++mCounters[CounterType::FAULTS];
             Halt();
             return;
         }
@@ -428,6 +766,7 @@ namespace vm {
                 std::cerr << "MOD: Modulo by zero! R" << static_cast<int>(instr.reg1)
                           << " (0x" << std::hex << op1 << ") % 0" << std::endl;
             }
+            ++mCounters[CounterType::FAULTS];
             Halt();
             return;
         }
@@ -443,6 +782,139 @@ namespace vm {
         }
     }
 
+    void CPU::ExecuteMulh(const Instruction& instr) {
+        int64_t op1 = static_cast<int64_t>(mRegisters[instr.reg1]);
+        int64_t op2 = static_cast<int64_t>(GetOperandValue(instr, true));
+        uint64_t result = static_cast<uint64_t>((static_cast<__int128>(op1) * op2) >> 64);
+
+        mRegisters[instr.reg1] = result;
+        UpdateFlags(result);
+
+        if (mDebug) {
+            std::cout << "MULH R" << static_cast<int>(instr.reg1) << " = high(" << std::dec << op1 << " * " << op2
+                      << ") = 0x" << std::hex << result << std::endl;
+        }
+    }
+
+    void CPU::ExecuteUmulh(const Instruction& instr) {
+        uint64_t op1 = mRegisters[instr.reg1];
+        uint64_t op2 = GetOperandValue(instr, true);
+        uint64_t result = static_cast<uint64_t>((static_cast<unsigned __int128>(op1) * op2) >> 64);
+
+        mRegisters[instr.reg1] = result;
+        UpdateFlags(result);
+
+        if (mDebug) {
+            std::cout << "UMULH R" << static_cast<int>(instr.reg1) << " = high(0x" << std::hex << op1 << " * 0x"
+                      << op2 << ") = 0x" << result << std::endl;
+        }
+    }
+
+    bool CPU::CheckDivisor(const Instruction& instr, uint64_t dividend, uint64_t divisor) {
+        if (divisor != 0) {
+            return true;
+        }
+        if (mDebug) {
+            std::cerr << OpcodeToString(instr.opcode) << ": Division by zero! R" << static_cast<int>(instr.reg1)
+                      << " (0x" << std::hex << dividend << ") / 0" << std::endl;
+        }
+        ++mCounters[CounterType::FAULTS];
+        Halt();
+        return false;
+    }
+
+    void CPU::ExecuteIdiv(const Instruction& instr) {
+        int64_t op1 = static_cast<int64_t>(mRegisters[instr.reg1]);
+        int64_t op2 = static_cast<int64_t>(GetOperandValue(instr, true));
+        if (!CheckDivisor(instr, op1, op2)) {
+            return;
+        }
+
+        // INT64_MIN / -1 wraps to INT64_MIN and sets OF instead of trapping
+        bool overflow = op1 == INT64_MIN && op2 == -1;
+        uint64_t result = overflow ? static_cast<uint64_t>(op1) : static_cast<uint64_t>(op1 / op2);
+        mRegisters[instr.reg1] = result;
+        UpdateFlags(result, false, overflow);
+
+        if (mDebug) {
+            std::cout << "IDIV R" << static_cast<int>(instr.reg1) << " (" << std::dec << op1 << ") / " << op2
+                      << " = " << static_cast<int64_t>(result) << std::endl;
+        }
+    }
+
+    void CPU::ExecuteImod(const Instruction& instr) {
+        int64_t op1 = static_cast<int64_t>(mRegisters[instr.reg1]);
+        int64_t op2 = static_cast<int64_t>(GetOperandValue(instr, true));
+        if (!CheckDivisor(instr, op1, op2)) {
+            return;
+        }
+
+        uint64_t result = op2 == -1 ? 0 : static_cast<uint64_t>(op1 % op2);
+        mRegisters[instr.reg1] = result;
+        UpdateFlags(result);
+
+        if (mDebug) {
+            std::cout << "IMOD R" << static_cast<int>(instr.reg1) << " (" << std::dec << op1 << ") % " << op2
+                      << " = " << static_cast<int64_t>(result) << std::endl;
+        }
+    }
+
+    void CPU::ExecuteAdc(const Instruction& instr) {
+        uint64_t op1 = mRegisters[instr.reg1];
+        uint64_t op2 = GetOperandValue(instr, true);
+        uint64_t carryIn = GetFlag(FlagType::CARRY) ? 1 : 0;
+
+        uint64_t sum;
+        uint64_t result;
+        bool carry = __builtin_add_overflow(op1, op2, &sum);
+        carry |= __builtin_add_overflow(sum, carryIn, &result);
+
+        mRegisters[instr.reg1] = result;
+        UpdateFlags(result, carry);
+
+        if (mDebug) {
+            std::cout << "ADC R" << static_cast<int>(instr.reg1) << " (0x" << std::hex << op1 << ") + 0x" << op2
+                      << " + " << carryIn << " = 0x" << result << (carry ? " [CARRY]" : "") << std::endl;
+        }
+    }
+
+    void CPU::ExecuteSbb(const Instruction& instr) {
+        uint64_t op1 = mRegisters[instr.reg1];
+        uint64_t op2 = GetOperandValue(instr, true);
+        uint64_t borrowIn = GetFlag(FlagType::CARRY) ? 1 : 0;
+
+        uint64_t difference;
+        uint64_t result;
+        bool borrow = __builtin_sub_overflow(op1, op2, &difference);
+        borrow |= __builtin_sub_overflow(difference, borrowIn, &result);
+
+        mRegisters[instr.reg1] = result;
+        UpdateFlags(result, borrow);
+
+        if (mDebug) {
+            std::cout << "SBB R" << static_cast<int>(instr.reg1) << " (0x" << std::hex << op1 << ") - 0x" << op2
+                      << " - " << borrowIn << " = 0x" << result << (borrow ? " [BORROW]" : "") << std::endl;
+        }
+    }
+
+    void CPU::ExecuteDivmod(const Instruction& instr) {
+        uint64_t dividend = mRegisters[instr.reg1];
+        uint64_t divisor = mRegisters[thirdRegister(instr)];
+        if (!CheckDivisor(instr, dividend, divisor)) {
+            return;
+        }
+
+        // The remainder is written last, so it wins when Rq and Rr are the same register
+        uint64_t quotient = dividend / divisor;
+        mRegisters[instr.reg1] = quotient;
+        mRegisters[instr.reg2] = dividend % divisor;
+        UpdateFlags(quotient);
+
+        if (mDebug) {
+            std::cout << "DIVMOD 0x" << std::hex << dividend << " / 0x" << divisor << " = 0x" << quotient
+                      << " rem 0x" << dividend % divisor << std::endl;
+        }
+    }
 
     uint64_t CPU::GetOperandValue(const Instruction& instr, bool isSecondOperand) {
         uint8_t reg = isSecondOperand ? instr.reg2 : instr.reg1;
@@ -451,18 +923,35 @@ namespace vm {
             case AddressingMode::REGISTER:
                 return mRegisters[reg];
             case AddressingMode::IMMEDIATE:
-                return instr.immediate;
+                return immediateValue(instr);
             case AddressingMode::MEMORY:
+                ++mCounters[CounterType::LOADS];
                 return mMemory->Read64(instr.immediate);
             case AddressingMode::REGISTER_INDIRECT:
+                ++mCounters[CounterType::LOADS];
                 return mMemory->Read64(mRegisters[reg]);
+            case AddressingMode::BASE_DISP:
+            case AddressingMode::BASE_INDEX:
+                ++mCounters[CounterType::LOADS];
+                return mMemory->Read64(EffectiveAddress(instr, isSecondOperand));
+            case AddressingMode::REGISTER3:
+                return mRegisters[isSecondOperand ? thirdRegister(instr) : instr.reg1];
             default:
                 return 0;
         }
     }
 
+    uint64_t CPU::EffectiveAddress(const Instruction& instr, bool isSecondOperand) const {
+        uint64_t address = mRegisters[isSecondOperand ? instr.reg2 : instr.reg1] +
+                           static_cast<uint64_t>(static_cast<int64_t>(displacement(instr)));
+        if (instr.mode == AddressingMode::BASE_INDEX) {
+            address += mRegisters[indexRegister(instr)] << indexScaleShift(instr);
+        }
+        return address;
+    }
+
     void CPU::ExecuteAnd(const Instruction& instr) {
-        uint64_t op1 = mRegisters[instr.reg1];
+        uint64_t op1 = mRegisters[aluSource(instr)];
         uint64_t op2 = GetOperandValue(instr, true);
         uint64_t result = op1 & op2;
 
@@ -477,7 +966,7 @@ namespace vm {
     }
 
     void CPU::ExecuteOr(const Instruction& instr) {
-        uint64_t op1 = mRegisters[instr.reg1];
+        uint64_t op1 = mRegisters[aluSource(instr)];
         uint64_t op2 = GetOperandValue(instr, true);
         uint64_t result = op1 | op2;
 
@@ -492,7 +981,7 @@ namespace vm {
     }
 
     void CPU::ExecuteXor(const Instruction& instr) {
-        uint64_t op1 = mRegisters[instr.reg1];
+        uint64_t op1 = mRegisters[aluSource(instr)];
         uint64_t op2 = GetOperandValue(instr, true);
         uint64_t result = op1 ^ op2;
 
@@ -520,7 +1009,7 @@ namespace vm {
     }
 
     void CPU::ExecuteShl(const Instruction& instr) {
-        uint64_t op1 = mRegisters[instr.reg1];
+        uint64_t op1 = mRegisters[aluSource(instr)];
         uint64_t shift_amount = GetOperandValue(instr, true) & 0x3F; // Limiter à 63
         uint64_t result = op1 << shift_amount;
 
@@ -537,7 +1026,7 @@ namespace vm {
     }
 
     void CPU::ExecuteShr(const Instruction& instr) {
-        uint64_t op1 = mRegisters[instr.reg1];
+        uint64_t op1 = mRegisters[aluSource(instr)];
         uint64_t shift_amount = GetOperandValue(instr, true) & 0x3F; // Limiter à 63
         uint64_t result = op1 >> shift_amount;
 
@@ -553,10 +1042,165 @@ namespace vm {
         }
     }
 
+    void CPU::ExecutePopcnt(const Instruction& instr) {
+        uint64_t value = GetOperandValue(instr, true);
+        uint64_t result = std::popcount(value);
+
+        mRegisters[instr.reg1] = result;
+        UpdateFlags(result);
+
+        if (mDebug) {
+            std::cout << "POPCNT R" << static_cast<int>(instr.reg1)
+                      << " = popcount(0x" << std::hex << value << ") = " << std::dec << result << std::endl;
+        }
+    }
+
+    void CPU::ExecuteClz(const Instruction& instr) {
+        uint64_t value = GetOperandValue(instr, true);
+        uint64_t result = std::countl_zero(value);
+
+        // Carry marks a zero source, as with LZCNT
+        mRegisters[instr.reg1] = result;
+        UpdateFlags(result, value == 0);
+
+        if (mDebug) {
+            std::cout << "CLZ R" << static_cast<int>(instr.reg1)
+                      << " = clz(0x" << std::hex << value << ") = " << std::dec << result << std::endl;
+        }
+    }
+
+    void CPU::ExecuteCtz(const Instruction& instr) {
+        uint64_t value = GetOperandValue(instr, true);
+        uint64_t result = std::countr_zero(value);
+
+        mRegisters[instr.reg1] = result;
+        UpdateFlags(result, value == 0);
+
+        if (mDebug) {
+            std::cout << "CTZ R" << static_cast<int>(instr.reg1)
+                      << " = ctz(0x" << std::hex << value << ") = " << std::dec << result << std::endl;
+        }
+    }
+
+    void CPU::ExecuteRol(const Instruction& instr) {
+        uint64_t op1 = mRegisters[instr.reg1];
+        unsigned count = GetOperandValue(instr, true) & 0x3F;
+        uint64_t result = std::rotl(op1, count);
+
+        // Carry is the last bit rotated out (now bit 0), cleared for a zero count like SHL
+        bool carry = count > 0 && (result & 1);
+
+        mRegisters[instr.reg1] = result;
+        UpdateFlags(result, carry);
+
+        if (mDebug) {
+            std::cout << "ROL R" << static_cast<int>(instr.reg1)
+                      << " (0x" << std::hex << op1 << ") by " << std::dec << count
+                      << " = 0x" << std::hex << result << std::endl;
+        }
+    }
+
+    void CPU::ExecuteRor(const Instruction& instr) {
+        uint64_t op1 = mRegisters[instr.reg1];
+        unsigned count = GetOperandValue(instr, true) & 0x3F;
+        uint64_t result = std::rotr(op1, count);
+
+        bool carry = count > 0 && (result >> 63);
+
+        mRegisters[instr.reg1] = result;
+        UpdateFlags(result, carry);
+
+        if (mDebug) {
+            std::cout << "ROR R" << static_cast<int>(instr.reg1)
+                      << " (0x" << std::hex << op1 << ") by " << std::dec << count
+                      << " = 0x" << std::hex << result << std::endl;
+        }
+    }
+
+    void CPU::ExecuteBswap(const Instruction& instr) {
+        uint64_t value = mRegisters[instr.reg1];
+        uint64_t result = __builtin_bswap64(value);
+
+        mRegisters[instr.reg1] = result;
+        UpdateFlags(result);
+
+        if (mDebug) {
+            std::cout << "BSWAP R" << static_cast<int>(instr.reg1)
+                      << " (0x" << std::hex << value << ") = 0x" << result << std::endl;
+        }
+    }
+
+    namespace {
+#ifdef VM_BMI2
+        bool HostHasBmi2() {
+            static const bool hasBmi2 = __builtin_cpu_supports("bmi2");
+            return hasBmi2;
+        }
+
+        __attribute__((target("bmi2")))
+        uint64_t HostBitExtract(uint64_t value, uint64_t mask) {
+            return _pext_u64(value, mask);
+        }
+
+        __attribute__((target("bmi2")))
+        uint64_t HostBitDeposit(uint64_t value, uint64_t mask) {
+            return _pdep_u64(value, mask);
+        }
+#endif
+
+        // BMI2 when the host has it, the portable loop (common/bits.h) otherwise
+        uint64_t BitExtract(uint64_t value, uint64_t mask) {
+#ifdef VM_BMI2
+            if (HostHasBmi2()) {
+                return HostBitExtract(value, mask);
+            }
+#endif
+            return bitExtract(value, mask);
+        }
+
+        uint64_t BitDeposit(uint64_t value, uint64_t mask) {
+#ifdef VM_BMI2
+            if (HostHasBmi2()) {
+                return HostBitDeposit(value, mask);
+            }
+#endif
+            return bitDeposit(value, mask);
+        }
+    }
+
+    void CPU::ExecutePext(const Instruction& instr) {
+        uint64_t op1 = mRegisters[instr.reg1];
+        uint64_t mask = GetOperandValue(instr, true);
+        uint64_t result = BitExtract(op1, mask);
+
+        mRegisters[instr.reg1] = result;
+        UpdateFlags(result);
+
+        if (mDebug) {
+            std::cout << "PEXT R" << static_cast<int>(instr.reg1)
+                      << " (0x" << std::hex << op1 << ") mask 0x" << mask << " = 0x" << result << std::endl;
+        }
+    }
+
+    void CPU::ExecutePdep(const Instruction& instr) {
+        uint64_t op1 = mRegisters[instr.reg1];
+        uint64_t mask = GetOperandValue(instr, true);
+        uint64_t result = BitDeposit(op1, mask);
+
+        mRegisters[instr.reg1] = result;
+        UpdateFlags(result);
+
+        if (mDebug) {
+            std::cout << "PDEP R" << static_cast<int>(instr.reg1)
+                      << " (0x" << std::hex << op1 << ") mask 0x" << mask << " = 0x" << result << std::endl;
+        }
+    }
+
     void CPU::ExecuteJc(const Instruction& instr) {
         if (GetFlag(FlagType::CARRY)) {
             uint64_t address = GetOperandValue(instr);
             mPC = address;
+            ++mCounters[CounterType::BRANCHES];
 
             if (mDebug) {
                 std::cout << "JC taken to address 0x" << std::hex << address << std::endl;
@@ -572,6 +1216,7 @@ namespace vm {
         if (!GetFlag(FlagType::CARRY)) {
             uint64_t address = GetOperandValue(instr);
             mPC = address;
+            ++mCounters[CounterType::BRANCHES];
 
             if (mDebug) {
                 std::cout << "JNC taken to address 0x" << std::hex << address << std::endl;
@@ -589,6 +1234,7 @@ namespace vm {
         if (condition) {
             uint64_t address = GetOperandValue(instr);
             mPC = address;
+            ++mCounters[CounterType::BRANCHES];
 
             if (mDebug) {
                 std::cout << "JL taken to address 0x" << std::hex << address << std::endl;
@@ -607,6 +1253,7 @@ namespace vm {
         if (condition) {
             uint64_t address = GetOperandValue(instr);
             mPC = address;
+            ++mCounters[CounterType::BRANCHES];
 
             if (mDebug) {
                 std::cout << "JLE taken to address 0x" << std::hex << address << std::endl;
@@ -627,6 +1274,7 @@ namespace vm {
         if (condition) {
             uint64_t address = GetOperandValue(instr);
             mPC = address;
+            ++mCounters[CounterType::BRANCHES];
 
             if (mDebug) {
                 std::cout << "JG taken to address 0x" << std::hex << address << std::endl;
@@ -644,6 +1292,7 @@ namespace vm {
         if (condition) {
             uint64_t address = GetOperandValue(instr);
             mPC = address;
+            ++mCounters[CounterType::BRANCHES];
 
             if (mDebug) {
                 std::cout << "JGE taken to address 0x" << std::hex << address << std::endl;
@@ -661,11 +1310,13 @@ namespace vm {
 
         switch (port) {
             case 0: // Port clavier (simulation)
-                std::cout << "Input from keyboard: ";
-                std::cin >> value;
+                value = mConsole.Read(ConsoleChannel::KEYBOARD);
                 break;
-            case 1: // Port timer (simulation)
-                value = static_cast<uint64_t>(std::time(nullptr)) & 0xFFFFFFFF;
+            case 1: // Port timer: nanoseconds since reset (host or virtual time)
+                value = mClock.GetNanoseconds(mCounters.Get(CounterType::CYCLES));
+                break;
+            case 2: // Port cycle counter: deterministic virtual cycles
+                value = mCounters.Get(CounterType::CYCLES);
                 break;
             default:
                 value = 0; // Port non supporté
@@ -690,11 +1341,10 @@ namespace vm {
 
         switch (port) {
             case 0:
-                std::cout << "Screen output: " << std::dec << value
-                          << " (char: '" << static_cast<char>(value & 0xFF) << "')" << std::endl;
+                mConsole.Write(ConsoleChannel::SCREEN, value);
                 break;
             case 1:
-                std::cout << "Serial output: 0x" << std::hex << value << std::endl;
+                mConsole.Write(ConsoleChannel::SERIAL, value);
                 break;
             default:
                 if (mDebug) {
@@ -709,6 +1359,258 @@ namespace vm {
         }
     }
 
+    void CPU::ExecuteRdcnt(const Instruction& instr) {
+        uint64_t counter = GetOperandValue(instr, true);
+        uint64_t value = counter < COUNTER_COUNT ? mCounters.values[counter] : 0;
+
+        mRegisters[instr.reg1] = value;
+
+        if (mDebug) {
+            std::cout << "RDCNT counter " << std::dec << counter
+                      << " → R" << static_cast<int>(instr.reg1)
+                      << " = " << value << std::endl;
+        }
+    }
+
+    void CPU::ExecuteHcall(const Instruction& instr) {
+        uint64_t index = GetOperandValue(instr);
+        const HostFunctionEntry* entry = mHostCalls.Find(index);
+        if (!entry) {
+            ++mCounters[CounterType::FAULTS];
+            std::ostringstream message;
+            message << "[ERROR] HCALL to unregistered host function " << std::dec << index;
+            mConsole.Diagnostic(message.str());
+            Halt();
+            return;
+        }
+
+        if (mDebug) {
+            std::cout << "HCALL " << std::dec << index << " (" << entry->name << ")" << std::endl;
+        }
+
+        HostCallFrame frame(mRegisters, *mMemory);
+        entry->function(entry->context, frame);
+        if (frame.HasFault()) {
+            throw std::runtime_error("Host function " + entry->name + ": " + frame.GetFault());
+        }
+    }
+
+    // The bulk memory instructions check each range once against the segments and
+    // run on the host's memmove/memset/memcmp. One execution handles at most
+    // BLOCK_CHUNK bytes and leaves the registers describing what is left; while
+    // bytes remain the PC is stepped back onto the instruction, so a long operation
+    // can be stepped, sampled or faulted in the middle and simply resumes.
+    void CPU::ExecuteBcopy(const Instruction& instr) {
+        uint8_t lengthReg = thirdRegister(instr);
+        uint64_t destination = mRegisters[instr.reg1];
+        uint64_t source = mRegisters[instr.reg2];
+        uint64_t length = mRegisters[lengthReg];
+
+        // A destination overlapping the source from above is copied back to front: each
+        // chunk is the top of what is left, so only Rn moves and Rd/Rs stay put
+        bool backward = destination > source && destination - source < length;
+        uint64_t chunk = std::min(length, BLOCK_CHUNK);
+        uint64_t offset = backward ? length - chunk : 0;
+        if (chunk > 0) {
+            const uint8_t* from = mMemory->GetSpan(source + offset, chunk, AccessType::READ);
+            uint8_t* to = mMemory->GetWritableSpan(destination + offset, chunk);
+            std::memmove(to, from, chunk);
+            ++mCounters[CounterType::LOADS];
+            ++mCounters[CounterType::STORES];
+            mCounters[CounterType::CYCLES] += chunk / 32;
+        }
+
+        if (!backward) {
+            mRegisters[instr.reg1] = destination + chunk;
+            mRegisters[instr.reg2] = source + chunk;
+        }
+        mRegisters[lengthReg] = length - chunk;
+        if (chunk < length) {
+            mPC -= 8;
+        }
+
+        if (mDebug) {
+            std::cout << "BCOPY " << std::dec << chunk << " bytes 0x" << std::hex << source + offset
+                      << " → 0x" << destination + offset << " (" << std::dec << length - chunk << " left)" << std::endl;
+        }
+    }
+
+    void CPU::ExecuteBfill(const Instruction& instr) {
+        uint8_t lengthReg = thirdRegister(instr);
+        uint64_t destination = mRegisters[instr.reg1];
+        uint8_t value = static_cast<uint8_t>(mRegisters[instr.reg2]);
+        uint64_t length = mRegisters[lengthReg];
+
+        uint64_t chunk = std::min(length, BLOCK_CHUNK);
+        if (chunk > 0) {
+            std::memset(mMemory->GetWritableSpan(destination, chunk), value, chunk);
+            ++mCounters[CounterType::STORES];
+            mCounters[CounterType::CYCLES] += chunk / 32;
+        }
+
+        mRegisters[instr.reg1] = destination + chunk;
+        mRegisters[lengthReg] = length - chunk;
+        if (chunk < length) {
+            mPC -= 8;
+        }
+
+        if (mDebug) {
+            std::cout << "BFILL " << std::dec << chunk << " bytes at 0x" << std::hex << destination
+                      << " with 0x" << static_cast<int>(value) << " (" << std::dec << length - chunk << " left)"
+                      << std::endl;
+        }
+    }
+
+    void CPU::ExecuteBcmp(const Instruction& instr) {
+        uint8_t lengthReg = thirdRegister(instr);
+        uint64_t first = mRegisters[instr.reg1];
+        uint64_t second = mRegisters[instr.reg2];
+        uint64_t length = mRegisters[lengthReg];
+
+        uint64_t chunk = std::min(length, BLOCK_CHUNK);
+        uint64_t same = chunk;      // Bytes known equal
+        uint64_t op1 = 0;
+        uint64_t op2 = 0;
+        if (chunk > 0) {
+            const uint8_t* a = mMemory->GetSpan(first, chunk, AccessType::READ);
+            const uint8_t* b = mMemory->GetSpan(second, chunk, AccessType::READ);
+            if (std::memcmp(a, b, chunk) != 0) {
+                // Narrow down with memcmp over 64-byte pieces, then bytes
+                same = 0;
+                while (std::memcmp(a + same, b + same, std::min<uint64_t>(64, chunk - same)) == 0) {
+                    same += 64;
+                }
+                while (a[same] == b[same]) {
+                    ++same;
+                }
+                op1 = a[same];
+                op2 = b[same];
+            }
+            mCounters[CounterType::LOADS] += 2;
+            mCounters[CounterType::CYCLES] += same / 32;
+        }
+
+        mRegisters[instr.reg1] = first + same;
+        mRegisters[instr.reg2] = second + same;
+        mRegisters[lengthReg] = length - same;
+
+        if (same < chunk) {
+            // Ra and Rb point at the first differing bytes, Rn counts them in
+            UpdateFlags(op1 - op2, op1 < op2);
+        } else if (chunk < length) {
+            mPC -= 8;
+        } else {
+            UpdateFlags(0);
+        }
+
+        if (mDebug) {
+            std::cout << "BCMP 0x" << std::hex << first << " with 0x" << second << ": "
+                      << std::dec << same << " equal bytes (" << length - same << " left)" << std::endl;
+        }
+    }
+
+    void CPU::ExecuteCrc32m(const Instruction& instr) {
+        uint8_t lengthReg = thirdRegister(instr);
+        uint32_t crc = static_cast<uint32_t>(mRegisters[instr.reg1]);
+        uint64_t address = mRegisters[instr.reg2];
+        uint64_t length = mRegisters[lengthReg];
+
+        uint64_t chunk = std::min(length, BLOCK_CHUNK);
+        if (chunk > 0) {
+            crc = ChecksumUnit::Crc32c(crc, mMemory->GetSpan(address, chunk, AccessType::READ), chunk);
+            ++mCounters[CounterType::LOADS];
+            mCounters[CounterType::CYCLES] += chunk / 32;
+        }
+
+        mRegisters[instr.reg1] = crc;
+        mRegisters[instr.reg2] = address + chunk;
+        mRegisters[lengthReg] = length - chunk;
+        if (chunk < length) {
+            mPC -= 8;
+        }
+
+        if (mDebug) {
+            std::cout << "CRC32M " << std::dec << chunk << " bytes at 0x" << std::hex << address
+                      << " = 0x" << crc << " (" << std::dec << length - chunk << " left)" << std::endl;
+        }
+    }
+
+    void CPU::ExecuteCrc32(const Instruction& instr) {
+        uint32_t crc = static_cast<uint32_t>(mRegisters[instr.reg1]);
+        uint64_t value = GetOperandValue(instr, true);
+        uint64_t result = ChecksumUnit::Crc32cWord(crc, value);
+
+        mRegisters[instr.reg1] = result;
+        UpdateFlags(result);
+
+        if (mDebug) {
+            std::cout << "CRC32 R" << static_cast<int>(instr.reg1) << " (0x" << std::hex << crc << ") with 0x"
+                      << value << " = 0x" << result << std::endl;
+        }
+    }
+
+    void CPU::ExecuteHash(const Instruction& instr) {
+        uint64_t seed = mRegisters[instr.reg1];
+        uint64_t value = GetOperandValue(instr, true);
+        uint64_t result = ChecksumUnit::Hash(seed, value);
+
+        mRegisters[instr.reg1] = result;
+        UpdateFlags(result);
+
+        if (mDebug) {
+            std::cout << "HASH R" << static_cast<int>(instr.reg1) << " (0x" << std::hex << seed << ") with 0x"
+                      << value << " = 0x" << result << std::endl;
+        }
+    }
+
+    void CPU::ExecuteVector(const Instruction& instr) {
+        unsigned sizeCode = vectorSizeCode(instr);
+        switch (GetVectorForm(instr.opcode)) {
+            case VectorForm::LOAD:
+                std::memcpy(mVectors[instr.reg1].bytes,
+                            mMemory->GetSpan(mRegisters[instr.reg2], VECTOR_BYTES, AccessType::READ), VECTOR_BYTES);
+                ++mCounters[CounterType::LOADS];
+                break;
+            case VectorForm::STORE:
+                std::memcpy(mMemory->GetWritableSpan(mRegisters[instr.reg1], VECTOR_BYTES),
+                            mVectors[instr.reg2].bytes, VECTOR_BYTES);
+                ++mCounters[CounterType::STORES];
+                break;
+            case VectorForm::BROADCAST:
+                VectorUnit::Broadcast(sizeCode, mVectors[instr.reg1], mRegisters[instr.reg2]);
+                break;
+            case VectorForm::EXTRACT:
+                mRegisters[instr.reg1] = VectorUnit::Extract(sizeCode, mVectors[instr.reg2], vectorImmediate(instr));
+                break;
+            case VectorForm::INSERT:
+                VectorUnit::Insert(sizeCode, mVectors[instr.reg1], mRegisters[instr.reg2], vectorImmediate(instr));
+                break;
+            case VectorForm::BINARY:
+                VectorUnit::Binary(instr.opcode, sizeCode, mVectors[instr.reg1], mVectors[instr.reg2],
+                                   mVectors[thirdRegister(instr)]);
+                break;
+            case VectorForm::SHIFT:
+                VectorUnit::Shift(instr.opcode, sizeCode, mVectors[instr.reg1], mVectors[instr.reg2],
+                                  vectorImmediate(instr));
+                break;
+            case VectorForm::REDUCE:
+                mRegisters[instr.reg1] = VectorUnit::Reduce(instr.opcode, sizeCode, mVectors[instr.reg2]);
+                UpdateFlags(mRegisters[instr.reg1]);
+                break;
+            case VectorForm::NONE:
+                break;
+        }
+
+        if (mDebug) {
+            std::cout << OpcodeToString(instr.opcode);
+            if (HasElementSize(instr.opcode)) {
+                std::cout << "." << (8 << sizeCode);
+            }
+            std::cout << " reg1=" << static_cast<int>(instr.reg1) << " reg2=" << static_cast<int>(instr.reg2)
+                      << " imm=0x" << std::hex << instr.immediate << std::dec << std::endl;
+        }
+    }
+
     void CPU::ExecuteSwap(const Instruction& instr) {
         uint64_t temp = mRegisters[instr.reg1];
         mRegisters[instr.reg1] = mRegisters[instr.reg2];
@@ -733,6 +1635,7 @@ namespace vm {
         if (counter != 0) {
             uint64_t address = GetOperandValue(instr);
             mPC = address;
+            ++mCounters[CounterType::BRANCHES];
 
             if (mDebug) {
                 std::cout << "LOOP taken (counter=" << std::dec << counter
@@ -750,8 +1653,7 @@ namespace vm {
     void CPU::ExecutePrint(const Instruction& instr) {
         uint64_t value = GetOperandValue(instr);
 
-        std::cout << "PRINT: " << std::dec << value
-                  << " (0x" << std::hex << value << ")" << std::endl;
+        mConsole.Write(ConsoleChannel::PRINT, value);
 
         if (mDebug) {
             std::cout << "PRINT executed: value=" << std::dec << value << std::endl;
@@ -767,9 +1669,16 @@ namespace vm {
                 break;
             case AddressingMode::MEMORY:
                 mMemory->Write64(instr.immediate, value);
+                ++mCounters[CounterType::STORES];
                 break;
             case AddressingMode::REGISTER_INDIRECT:
                 mMemory->Write64(mRegisters[reg], value);
+                ++mCounters[CounterType::STORES];
+                break;
+            case AddressingMode::BASE_DISP:
+            case AddressingMode::BASE_INDEX:
+                mMemory->Write64(EffectiveAddress(instr, isSecondOperand), value);
+                ++mCounters[CounterType::STORES];
                 break;
             case AddressingMode::IMMEDIATE:
                 mRegisters[instr.reg1] = value;
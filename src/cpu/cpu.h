@@ -6,25 +6,52 @@
 #define VM_CPU_H
 
 #include <common/types.h>
+#include <common/vector.h>
 #include <memory/memory.h>
+#include <io/clock.h>
+#include <io/console.h>
+#include <cpu/host_call.h>
+#include <cpu/decode_cache.h>
 #include <array>
+#include <atomic>
+#include <memory>
 
 namespace vm {
+    // Mnemonic of an opcode, "UNKNOWN" for values the CPU does not implement
+    const char* OpcodeToString(Opcode opcode);
+    bool IsValidOpcode(Opcode opcode);
+
     class CPU {
+        friend class SamplingProfiler; // Reads mCurrentPC/mCallDepth (relaxed atomics) from its signal handler
+
     private:
         std::array<uint64_t, REGISTER_COUNT> mRegisters;
+        std::array<VectorRegister, VECTOR_REGISTER_COUNT> mVectors; // V0-V15 (vector extension)
         uint64_t mPC;        // Program Counter
+        std::atomic<uint64_t> mCurrentPC; // Address of the instruction being executed (mPC has moved past it)
         uint64_t mSP;        // Stack Pointer
         uint32_t mFlags;     // Flags register
         Memory* mMemory;
         bool mRunning;
         bool mDebug;
         bool mStepByStep;    // Step-by-step mode
+        std::atomic<uint64_t> mCallDepth; // Shadow call depth (CALL/RET nesting)
+        PerformanceCounters mCounters;
+        Clock mClock;        // Clock device (IN ports 1 and 2)
+        Console mConsole;    // PRINT, OUT ports 0/1, IN port 0
+        HostCallTable mHostCalls; // HCALL targets, kept across Reset()
+        DecodeCache mDecodeCache;
+        uint64_t mDecodeGeneration; // Memory code generation the decoded copy matches
+        uint64_t mInstructionLimit; // Run() stops once this many instructions are retired
+        bool mLimitReached;
 
         // Private methods
+        bool CheckInstructionLimit(); // false (and stopped) once the limit is reached
         void FetchInstruction(Instruction& instr);
-        void DecodeInstruction(const Instruction& instr);
         void ExecuteInstruction(const Instruction& instr);
+        void RunDecoded();   // Run() fast path over the decoded copy of the code
+        void ExecuteBlock(const DecodedInstruction* block);
+        void RefundBlock(const DecodedInstruction* block, size_t executed);
         void WaitForKey() const; // Wait for key press
         void ClearScreen() const; // Clear screen
 
@@ -32,7 +59,10 @@ namespace vm {
         
         // Move data between registers or load immediate values into register
         void ExecuteMov(const Instruction& instr);
-        
+
+        // Load the 64-bit constant in the next code word and step over it
+        void ExecuteMovw(const Instruction& instr);
+
         // Load data from memory address into register
         void ExecuteLoad(const Instruction& instr);
         
@@ -61,6 +91,24 @@ namespace vm {
         
         // Calculate modulo (remainder) of division and store in destination register
         void ExecuteMod(const Instruction& instr);
+
+        // High half of the 128-bit product, signed / unsigned
+        void ExecuteMulh(const Instruction& instr);
+        void ExecuteUmulh(const Instruction& instr);
+
+        // Signed division and remainder (INT64_MIN / -1 sets OF)
+        void ExecuteIdiv(const Instruction& instr);
+        void ExecuteImod(const Instruction& instr);
+
+        // Add / subtract with the carry flag as carry (borrow) in
+        void ExecuteAdc(const Instruction& instr);
+        void ExecuteSbb(const Instruction& instr);
+
+        // Quotient and remainder in one step (three registers)
+        void ExecuteDivmod(const Instruction& instr);
+
+        // Fault and halt on a zero divisor; false when the instruction must stop
+        bool CheckDivisor(const Instruction& instr, uint64_t dividend, uint64_t divisor);
         
         // Increment register value by 1
         void ExecuteInc(const Instruction& instr);
@@ -94,6 +142,24 @@ namespace vm {
         // Shift bits right by specified amount (logical shift)
         void ExecuteShr(const Instruction& instr);
 
+        // Bit Manipulation Instructions
+
+        // Count set / leading zero / trailing zero bits of the operand into a register
+        void ExecutePopcnt(const Instruction& instr);
+        void ExecuteClz(const Instruction& instr);
+        void ExecuteCtz(const Instruction& instr);
+
+        // Rotate a register left / right (count modulo 64)
+        void ExecuteRol(const Instruction& instr);
+        void ExecuteRor(const Instruction& instr);
+
+        // Reverse the byte order of a register
+        void ExecuteBswap(const Instruction& instr);
+
+        // Parallel bit extract / deposit with the operand as mask
+        void ExecutePext(const Instruction& instr);
+        void ExecutePdep(const Instruction& instr);
+
         // Control Flow Instructions
         
         // Unconditional jump to specified address
@@ -154,10 +220,49 @@ namespace vm {
         // Write register value to specified output port
         void ExecuteOut(const Instruction& instr);
 
+        // Read performance counter (index from second operand) into register
+        void ExecuteRdcnt(const Instruction& instr);
+
+        // Call the host function whose index is the operand (arguments and result in registers)
+        void ExecuteHcall(const Instruction& instr);
+
+        // Bulk Memory Instructions (at most BLOCK_CHUNK bytes per execution, then resume)
+
+        // Copy Rn bytes from [Rs] to [Rd] (overlap-safe); Rn counts down, Rd and Rs advance
+        // except while an overlapping copy to a higher address runs back to front
+        void ExecuteBcopy(const Instruction& instr);
+
+        // Fill Rn bytes at [Rd] with the low byte of Rv; Rd advances, Rn counts down
+        void ExecuteBfill(const Instruction& instr);
+
+        // Compare Rn bytes at [Ra] and [Rb]; stops at the first difference with flags as CMP of the two bytes
+        void ExecuteBcmp(const Instruction& instr);
+
+        // Fold Rn bytes at [Ra] into the CRC32C in Rc; Ra advances, Rn counts down
+        void ExecuteCrc32m(const Instruction& instr);
+
+        // Checksum Instructions
+
+        // Fold the 8 operand bytes into the CRC32C in the low half of the register
+        void ExecuteCrc32(const Instruction& instr);
+
+        // Mix the operand into the 64-bit hash in the register
+        void ExecuteHash(const Instruction& instr);
+
+        // Vector Instructions
+
+        // Every vector opcode, dispatched on its VectorForm (see common/vector.h)
+        void ExecuteVector(const Instruction& instr);
+
         uint64_t GetOperandValue(const Instruction& instr, bool isSecondOperand = false);
         void SetOperandValue(const Instruction& instr, uint64_t value, bool isSecondOperand = false);
 
+        // Address of a BASE_DISP / BASE_INDEX operand; the operand's register is the base
+        uint64_t EffectiveAddress(const Instruction& instr, bool isSecondOperand) const;
+
     public:
+        static constexpr uint64_t BLOCK_CHUNK = 256 * 1024;
+
         CPU(Memory* mem);
         ~CPU() = default;
 
@@ -174,14 +279,48 @@ namespace vm {
         void SetFlag(FlagType flag, bool value);
         bool GetFlag(FlagType flag) const;
         void UpdateFlags(uint64_t result, bool carry = false, bool overflow = false);
+        uint32_t GetFlags() const { return mFlags; }
 
         // Register access
         uint64_t GetRegister(uint8_t reg) const;
         void SetRegister(uint8_t reg, uint64_t value);
+        const VectorRegister& GetVectorRegister(uint8_t reg) const { return mVectors[reg % VECTOR_REGISTER_COUNT]; }
+        void SetVectorRegister(uint8_t reg, const VectorRegister& value) { mVectors[reg % VECTOR_REGISTER_COUNT] = value; }
         uint64_t GetPC() const { return mPC; }
         void SetPC(uint64_t address) { mPC = address; }
         uint64_t GetSP() const { return mSP; }
         void SetSP(uint64_t address) { mSP = address; }
+        uint64_t GetCallDepth() const { return mCallDepth.load(std::memory_order_relaxed); }
+
+        // Performance counters
+        const PerformanceCounters& GetCounters() const { return mCounters; }
+        uint64_t GetCounter(CounterType type) const { return mCounters.Get(type); }
+        void ResetCounters() { mCounters.Reset(); }
+        static uint8_t GetCycleCost(Opcode opcode);
+
+        // Instruction budget: Run() stops at the first block boundary past it (0 = none)
+        void SetInstructionLimit(uint64_t limit) { mInstructionLimit = limit ? limit : UINT64_MAX; }
+        bool ReachedInstructionLimit() const { return mLimitReached; }
+
+        // Clock device
+        Clock& GetClock() { return mClock; }
+        const Clock& GetClock() const { return mClock; }
+        void SetClockMode(ClockMode mode) { mClock.SetMode(mode); }
+
+        // Console device
+        Console& GetConsole() { return mConsole; }
+        const Console& GetConsole() const { return mConsole; }
+
+        // Host functions (HCALL)
+        HostCallTable& GetHostCalls() { return mHostCalls; }
+        const HostCallTable& GetHostCalls() const { return mHostCalls; }
+
+        // Decoded code: Run() executes from it when not debugging, and drops it
+        // as soon as the guest writes to the code range
+        void DecodeCode(uint64_t base, size_t count);
+        void AttachDecodedCode(std::shared_ptr<const DecodedInstruction> entries, uint64_t base, size_t count);
+        const DecodeCache& GetDecodeCache() const { return mDecodeCache; }
+        DecodeCache& GetDecodeCache() { return mDecodeCache; }
 
         // Debug
         void EnableDebug(bool enable = true) { mDebug = enable; }
@@ -0,0 +1,71 @@
+// src/cpu/decode_cache.cpp
+#include "decode_cache.h"
+#include "cpu.h"
+#include <common/instruction.h>
+#include <algorithm>
+#include <cstring>
+
+namespace vm {
+    DecodeCache::DecodeCache() : mEntries(nullptr), mCount(0), mBase(0) {
+    }
+
+    void DecodeCache::Build(const uint8_t* code, uint64_t base, size_t count) {
+        mBorrowed.reset();
+        mOwned.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t raw;
+            std::memcpy(&raw, code + i * sizeof(uint64_t), sizeof(raw));
+
+            DecodedInstruction& entry = mOwned[i];
+            entry = DecodedInstruction{};
+            entry.instr = decodeInstruction(raw);
+            entry.cycles = CPU::GetCycleCost(entry.instr.opcode);
+        }
+        mEntries = mOwned.data();
+        mCount = count;
+        mBase = base;
+    }
+
+    void DecodeCache::Attach(std::shared_ptr<const DecodedInstruction> entries, uint64_t base, size_t count) {
+        mOwned.clear();
+        mBorrowed = std::move(entries);
+        mEntries = mBorrowed.get();
+        mCount = count;
+        mBase = base;
+    }
+
+    void DecodeCache::MarkBlock(size_t start, size_t length, bool verified) {
+        if (mOwned.empty() || start + length > mCount) {
+            return;
+        }
+
+        while (length > 0) {
+            size_t chunk = std::min<size_t>(length, UINT16_MAX);
+            DecodedInstruction& head = mOwned[start];
+            head.flags = DECODED_BLOCK_START | (verified ? DECODED_VERIFIED_BLOCK : 0);
+            head.blockLength = static_cast<uint16_t>(chunk);
+            head.blockCycles = 0;
+            for (size_t i = start; i < start + chunk; ++i) {
+                head.blockCycles += mOwned[i].cycles;
+            }
+            start += chunk;
+            length -= chunk;
+        }
+    }
+
+    size_t DecodeCache::CountBlocks(uint8_t flag) const {
+        size_t blocks = 0;
+        for (size_t i = 0; i < mCount; ++i) {
+            blocks += (mEntries[i].flags & flag) != 0;
+        }
+        return blocks;
+    }
+
+    void DecodeCache::Clear() {
+        mOwned.clear();
+        mBorrowed.reset();
+        mEntries = nullptr;
+        mCount = 0;
+        mBase = 0;
+    }
+}
@@ -0,0 +1,63 @@
+// src/cpu/decode_cache.h
+#ifndef VM_DECODE_CACHE_H
+#define VM_DECODE_CACHE_H
+
+#include <common/types.h>
+#include <memory>
+#include <vector>
+
+namespace vm {
+    // DecodedInstruction::flags
+    constexpr uint8_t DECODED_BLOCK_START = 1;     // First instruction of a basic block
+    constexpr uint8_t DECODED_VERIFIED_BLOCK = 2;  // Block proven safe by the verifier (block starts only)
+
+    // One pre-decoded instruction slot. Plain data: the array is written to and
+    // memory-mapped from translation cache files as is.
+    struct DecodedInstruction {
+        Instruction instr;
+        uint8_t cycles;         // CYCLES counter increment
+        uint8_t flags;
+        uint16_t blockLength;   // Instructions in the block (block starts only)
+        uint32_t blockCycles;   // Cycles of the whole block (block starts only)
+    };
+    static_assert(sizeof(DecodedInstruction) == 20, "DecodedInstruction is stored in translation cache files");
+
+    // Decoded copy of the code region, indexed by (pc - base) / 8.
+    // Entries are either owned or borrowed from a mapped cache file.
+    class DecodeCache {
+    private:
+        const DecodedInstruction* mEntries;
+        size_t mCount;
+        uint64_t mBase;
+        std::vector<DecodedInstruction> mOwned;
+        std::shared_ptr<const DecodedInstruction> mBorrowed;   // e.g. a mapped cache file
+
+    public:
+        DecodeCache();
+
+        // Decode count instruction words starting at guest address base
+        void Build(const uint8_t* code, uint64_t base, size_t count);
+        void Attach(std::shared_ptr<const DecodedInstruction> entries, uint64_t base, size_t count);
+
+        // Record a basic block of length instructions starting at entry index start
+        // (owned entries only). Blocks longer than a uint16_t are split.
+        void MarkBlock(size_t start, size_t length, bool verified);
+        void Clear();
+
+        const DecodedInstruction* Lookup(uint64_t pc) const {
+            uint64_t offset = pc - mBase;
+            if (offset >= mCount * sizeof(uint64_t) || (offset & 7) != 0) {
+                return nullptr;
+            }
+            return mEntries + offset / sizeof(uint64_t);
+        }
+
+        bool IsEmpty() const { return mCount == 0; }
+        size_t CountBlocks(uint8_t flag) const;
+        size_t GetCount() const { return mCount; }
+        uint64_t GetBase() const { return mBase; }
+        const DecodedInstruction* GetEntries() const { return mEntries; }
+    };
+}
+
+#endif // VM_DECODE_CACHE_H
@@ -0,0 +1,42 @@
+// src/cpu/host_call.cpp
+#include "host_call.h"
+#include <memory/memory.h>
+
+namespace vm {
+    const uint8_t* HostCallFrame::Read(uint64_t address, uint64_t size) const {
+        return mMemory.GetSpan(address, size, AccessType::READ);
+    }
+
+    uint8_t* HostCallFrame::Write(uint64_t address, uint64_t size) {
+        return mMemory.GetWritableSpan(address, size);
+    }
+
+    bool HostCallTable::Register(uint32_t index, const std::string& name, HostFunction function, void* context) {
+        if (!function || index >= MAX_FUNCTIONS) {
+            return false;
+        }
+        if (index >= mEntries.size()) {
+            mEntries.resize(index + 1);
+        }
+        mEntries[index] = {function, context, name};
+        return true;
+    }
+
+    void HostCallTable::Unregister(uint32_t index) {
+        if (index < mEntries.size()) {
+            mEntries[index] = HostFunctionEntry();
+        }
+        while (!mEntries.empty() && !mEntries.back().function) {
+            mEntries.pop_back();
+        }
+    }
+
+    int64_t HostCallTable::FindByName(const std::string& name) const {
+        for (size_t i = 0; i < mEntries.size(); ++i) {
+            if (mEntries[i].function && mEntries[i].name == name) {
+                return static_cast<int64_t>(i);
+            }
+        }
+        return -1;
+    }
+}
@@ -0,0 +1,73 @@
+// src/cpu/host_call.h
+#ifndef VM_HOST_CALL_H
+#define VM_HOST_CALL_H
+
+#include <common/types.h>
+#include <array>
+#include <string>
+#include <vector>
+
+namespace vm {
+    class Memory;
+
+    // What a host function sees of the guest during one HCALL: the register file
+    // (arguments in R0..R15, result in R0 by convention) and guest memory as
+    // directly addressable spans.
+    class HostCallFrame {
+    private:
+        std::array<uint64_t, REGISTER_COUNT>& mRegisters;
+        Memory& mMemory;
+        std::string mFault;
+
+    public:
+        HostCallFrame(std::array<uint64_t, REGISTER_COUNT>& registers, Memory& memory)
+            : mRegisters(registers), mMemory(memory) {}
+
+        uint64_t GetArgument(size_t index) const { return mRegisters[index % REGISTER_COUNT]; }
+        uint64_t GetRegister(uint8_t reg) const { return mRegisters[reg % REGISTER_COUNT]; }
+        void SetRegister(uint8_t reg, uint64_t value) { mRegisters[reg % REGISTER_COUNT] = value; }
+        void SetResult(uint64_t value) { mRegisters[0] = value; }
+
+        // Guest memory [address, address + size) after one range and permission check;
+        // an invalid range throws, which the CPU reports as a fault
+        const uint8_t* Read(uint64_t address, uint64_t size) const;
+        uint8_t* Write(uint64_t address, uint64_t size);
+        Memory& GetMemory() { return mMemory; }
+
+        // Fail the HCALL without throwing (the CPU faults once the function returns)
+        void Fault(const std::string& message) { mFault = message.empty() ? "Host function fault" : message; }
+        bool HasFault() const { return !mFault.empty(); }
+        const std::string& GetFault() const { return mFault; }
+    };
+
+    using HostFunction = void (*)(void* context, HostCallFrame& frame);
+
+    struct HostFunctionEntry {
+        HostFunction function = nullptr;
+        void* context = nullptr;
+        std::string name;
+    };
+
+    // Native functions reachable from the guest through HCALL <index>. Indices are
+    // small and dense, so the table is a plain vector and a call is one bounds check.
+    class HostCallTable {
+    private:
+        std::vector<HostFunctionEntry> mEntries;
+
+    public:
+        static constexpr size_t MAX_FUNCTIONS = 4096;
+
+        bool Register(uint32_t index, const std::string& name, HostFunction function, void* context = nullptr);
+        void Unregister(uint32_t index);
+        void Clear() { mEntries.clear(); }
+
+        const HostFunctionEntry* Find(uint64_t index) const {
+            return index < mEntries.size() && mEntries[index].function ? &mEntries[index] : nullptr;
+        }
+        // Index of a registered name, or -1
+        int64_t FindByName(const std::string& name) const;
+        size_t GetCapacity() const { return mEntries.size(); }
+    };
+}
+
+#endif // VM_HOST_CALL_H
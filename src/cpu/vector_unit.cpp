@@ -0,0 +1,280 @@
+// src/cpu/vector_unit.cpp
+#include "vector_unit.h"
+#include <algorithm>
+#include <type_traits>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define VM_VECTOR_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace vm {
+    namespace {
+        bool sAccelerate = true;
+
+        template <typename T>
+        constexpr size_t Lanes() {
+            return VECTOR_BYTES / sizeof(T);
+        }
+
+        template <typename T>
+        void ScalarBinary(Opcode opcode, VectorRegister& result, const VectorRegister& a, const VectorRegister& b) {
+            using Signed = std::make_signed_t<T>;
+            constexpr size_t N = Lanes<T>();
+            T x[N];
+            T y[N];
+            T r[N];
+            std::memcpy(x, a.bytes, VECTOR_BYTES);
+            std::memcpy(y, b.bytes, VECTOR_BYTES);
+
+            switch (opcode) {
+                case Opcode::VADD:
+                    for (size_t i = 0; i < N; ++i) r[i] = static_cast<T>(x[i] + y[i]);
+                    break;
+                case Opcode::VSUB:
+                    for (size_t i = 0; i < N; ++i) r[i] = static_cast<T>(x[i] - y[i]);
+                    break;
+                case Opcode::VMUL:
+                    for (size_t i = 0; i < N; ++i) r[i] = static_cast<T>(static_cast<uint64_t>(x[i]) * y[i]);
+                    break;
+                case Opcode::VAND:
+                    for (size_t i = 0; i < N; ++i) r[i] = x[i] & y[i];
+                    break;
+                case Opcode::VOR:
+                    for (size_t i = 0; i < N; ++i) r[i] = x[i] | y[i];
+                    break;
+                case Opcode::VXOR:
+                    for (size_t i = 0; i < N; ++i) r[i] = x[i] ^ y[i];
+                    break;
+                case Opcode::VCMPEQ:
+                    for (size_t i = 0; i < N; ++i) r[i] = x[i] == y[i] ? static_cast<T>(~T(0)) : T(0);
+                    break;
+                case Opcode::VCMPGT:
+                    for (size_t i = 0; i < N; ++i) {
+                        r[i] = static_cast<Signed>(x[i]) > static_cast<Signed>(y[i]) ? static_cast<T>(~T(0)) : T(0);
+                    }
+                    break;
+                case Opcode::VPERM:
+                    for (size_t i = 0; i < N; ++i) r[i] = x[y[i] & (N - 1)];
+                    break;
+                default:
+                    std::memcpy(r, x, VECTOR_BYTES);
+                    break;
+            }
+            std::memcpy(result.bytes, r, VECTOR_BYTES);
+        }
+
+        template <typename T>
+        void ScalarShift(Opcode opcode, VectorRegister& result, const VectorRegister& a, unsigned count) {
+            constexpr size_t N = Lanes<T>();
+            T x[N];
+            std::memcpy(x, a.bytes, VECTOR_BYTES);
+            for (size_t i = 0; i < N; ++i) {
+                if (count >= sizeof(T) * 8) {
+                    x[i] = 0;
+                } else {
+                    x[i] = static_cast<T>(opcode == Opcode::VSHL ? x[i] << count : x[i] >> count);
+                }
+            }
+            std::memcpy(result.bytes, x, VECTOR_BYTES);
+        }
+
+        template <typename T>
+        uint64_t ScalarReduce(Opcode opcode, const VectorRegister& a) {
+            constexpr size_t N = Lanes<T>();
+            T x[N];
+            std::memcpy(x, a.bytes, VECTOR_BYTES);
+
+            uint64_t value = opcode == Opcode::VREDMIN ? x[0] : 0;
+            for (size_t i = 0; i < N; ++i) {
+                switch (opcode) {
+                    case Opcode::VMASK:
+                        value |= static_cast<uint64_t>(x[i] >> (sizeof(T) * 8 - 1)) << i;
+                        break;
+                    case Opcode::VREDSUM:
+                        value += x[i];
+                        break;
+                    case Opcode::VREDMIN:
+                        value = std::min<uint64_t>(value, x[i]);
+                        break;
+                    case Opcode::VREDMAX:
+                        value = std::max<uint64_t>(value, x[i]);
+                        break;
+                    default:
+                        break;
+                }
+            }
+            return value;
+        }
+
+#ifdef VM_VECTOR_AVX2
+        bool HostHasAvx2() {
+            static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+            return hasAvx2;
+        }
+
+        // AVX2 versions of the operations with a direct instruction; false leaves it to the scalar code
+        __attribute__((target("avx2")))
+        bool Avx2Binary(Opcode opcode, unsigned sizeCode, VectorRegister& result,
+                        const VectorRegister& a, const VectorRegister& b) {
+            __m256i x = _mm256_load_si256(reinterpret_cast<const __m256i*>(a.bytes));
+            __m256i y = _mm256_load_si256(reinterpret_cast<const __m256i*>(b.bytes));
+            __m256i r;
+            switch (opcode) {
+                case Opcode::VADD:
+                    r = sizeCode == 0 ? _mm256_add_epi8(x, y) : sizeCode == 1 ? _mm256_add_epi16(x, y)
+                      : sizeCode == 2 ? _mm256_add_epi32(x, y) : _mm256_add_epi64(x, y);
+                    break;
+                case Opcode::VSUB:
+                    r = sizeCode == 0 ? _mm256_sub_epi8(x, y) : sizeCode == 1 ? _mm256_sub_epi16(x, y)
+                      : sizeCode == 2 ? _mm256_sub_epi32(x, y) : _mm256_sub_epi64(x, y);
+                    break;
+                case Opcode::VMUL:
+                    if (sizeCode == 1) {
+                        r = _mm256_mullo_epi16(x, y);
+                    } else if (sizeCode == 2) {
+                        r = _mm256_mullo_epi32(x, y);
+                    } else {
+                        return false;
+                    }
+                    break;
+                case Opcode::VAND:
+                    r = _mm256_and_si256(x, y);
+                    break;
+                case Opcode::VOR:
+                    r = _mm256_or_si256(x, y);
+                    break;
+                case Opcode::VXOR:
+                    r = _mm256_xor_si256(x, y);
+                    break;
+                case Opcode::VCMPEQ:
+                    r = sizeCode == 0 ? _mm256_cmpeq_epi8(x, y) : sizeCode == 1 ? _mm256_cmpeq_epi16(x, y)
+                      : sizeCode == 2 ? _mm256_cmpeq_epi32(x, y) : _mm256_cmpeq_epi64(x, y);
+                    break;
+                case Opcode::VCMPGT:
+                    r = sizeCode == 0 ? _mm256_cmpgt_epi8(x, y) : sizeCode == 1 ? _mm256_cmpgt_epi16(x, y)
+                      : sizeCode == 2 ? _mm256_cmpgt_epi32(x, y) : _mm256_cmpgt_epi64(x, y);
+                    break;
+                case Opcode::VPERM:
+                    if (sizeCode != 2) {
+                        return false;
+                    }
+                    r = _mm256_permutevar8x32_epi32(x, y);
+                    break;
+                default:
+                    return false;
+            }
+            _mm256_store_si256(reinterpret_cast<__m256i*>(result.bytes), r);
+            return true;
+        }
+
+        __attribute__((target("avx2")))
+        bool Avx2Shift(Opcode opcode, unsigned sizeCode, VectorRegister& result, const VectorRegister& a, unsigned count) {
+            if (sizeCode == 0) {
+                return false;
+            }
+            __m256i x = _mm256_load_si256(reinterpret_cast<const __m256i*>(a.bytes));
+            __m128i n = _mm_cvtsi32_si128(static_cast<int>(count));
+            __m256i r;
+            if (opcode == Opcode::VSHL) {
+                r = sizeCode == 1 ? _mm256_sll_epi16(x, n) : sizeCode == 2 ? _mm256_sll_epi32(x, n) : _mm256_sll_epi64(x, n);
+            } else {
+                r = sizeCode == 1 ? _mm256_srl_epi16(x, n) : sizeCode == 2 ? _mm256_srl_epi32(x, n) : _mm256_srl_epi64(x, n);
+            }
+            _mm256_store_si256(reinterpret_cast<__m256i*>(result.bytes), r);
+            return true;
+        }
+
+        __attribute__((target("avx2")))
+        bool Avx2Mask(unsigned sizeCode, const VectorRegister& a, uint64_t& mask) {
+            __m256i x = _mm256_load_si256(reinterpret_cast<const __m256i*>(a.bytes));
+            switch (sizeCode) {
+                case 0: mask = static_cast<uint32_t>(_mm256_movemask_epi8(x)); return true;
+                case 2: mask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(x))); return true;
+                case 3: mask = static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(x))); return true;
+                default: return false;
+            }
+        }
+#endif
+
+        bool UseAvx2() {
+#ifdef VM_VECTOR_AVX2
+            return sAccelerate && HostHasAvx2();
+#else
+            return false;
+#endif
+        }
+    }
+
+    void VectorUnit::Binary(Opcode opcode, unsigned sizeCode, VectorRegister& result,
+                            const VectorRegister& a, const VectorRegister& b) {
+#ifdef VM_VECTOR_AVX2
+        if (UseAvx2() && Avx2Binary(opcode, sizeCode, result, a, b)) {
+            return;
+        }
+#endif
+        switch (sizeCode) {
+            case 0: ScalarBinary<uint8_t>(opcode, result, a, b); break;
+            case 1: ScalarBinary<uint16_t>(opcode, result, a, b); break;
+            case 2: ScalarBinary<uint32_t>(opcode, result, a, b); break;
+            default: ScalarBinary<uint64_t>(opcode, result, a, b); break;
+        }
+    }
+
+    void VectorUnit::Shift(Opcode opcode, unsigned sizeCode, VectorRegister& result,
+                           const VectorRegister& a, unsigned count) {
+#ifdef VM_VECTOR_AVX2
+        if (UseAvx2() && Avx2Shift(opcode, sizeCode, result, a, count)) {
+            return;
+        }
+#endif
+        switch (sizeCode) {
+            case 0: ScalarShift<uint8_t>(opcode, result, a, count); break;
+            case 1: ScalarShift<uint16_t>(opcode, result, a, count); break;
+            case 2: ScalarShift<uint32_t>(opcode, result, a, count); break;
+            default: ScalarShift<uint64_t>(opcode, result, a, count); break;
+        }
+    }
+
+    uint64_t VectorUnit::Reduce(Opcode opcode, unsigned sizeCode, const VectorRegister& a) {
+#ifdef VM_VECTOR_AVX2
+        uint64_t mask;
+        if (opcode == Opcode::VMASK && UseAvx2() && Avx2Mask(sizeCode, a, mask)) {
+            return mask;
+        }
+#endif
+        switch (sizeCode) {
+            case 0: return ScalarReduce<uint8_t>(opcode, a);
+            case 1: return ScalarReduce<uint16_t>(opcode, a);
+            case 2: return ScalarReduce<uint32_t>(opcode, a);
+            default: return ScalarReduce<uint64_t>(opcode, a);
+        }
+    }
+
+    void VectorUnit::Broadcast(unsigned sizeCode, VectorRegister& result, uint64_t value) {
+        size_t width = size_t(1) << sizeCode;
+        for (size_t offset = 0; offset < VECTOR_BYTES; offset += width) {
+            std::memcpy(result.bytes + offset, &value, width);
+        }
+    }
+
+    uint64_t VectorUnit::Extract(unsigned sizeCode, const VectorRegister& a, unsigned lane) {
+        size_t width = size_t(1) << sizeCode;
+        uint64_t value = 0;
+        std::memcpy(&value, a.bytes + (lane % (VECTOR_BYTES / width)) * width, width);
+        return value;
+    }
+
+    void VectorUnit::Insert(unsigned sizeCode, VectorRegister& result, uint64_t value, unsigned lane) {
+        size_t width = size_t(1) << sizeCode;
+        std::memcpy(result.bytes + (lane % (VECTOR_BYTES / width)) * width, &value, width);
+    }
+
+    bool VectorUnit::UsesAvx2() {
+        return UseAvx2();
+    }
+
+    void VectorUnit::EnableHostAcceleration(bool enable) {
+        sAccelerate = enable;
+    }
+}
@@ -0,0 +1,32 @@
+// src/cpu/vector_unit.h
+#ifndef VM_VECTOR_UNIT_H
+#define VM_VECTOR_UNIT_H
+
+#include <common/vector.h>
+
+namespace vm {
+    // Lane-wise kernels behind the vector instructions. Every operation has a portable
+    // scalar version; on x86-64 the common ones also have AVX2 versions, used when the
+    // host CPU supports them (checked once, at first use).
+    class VectorUnit {
+    public:
+        // VADD .. VPERM: Vd = Va op Vb
+        static void Binary(Opcode opcode, unsigned sizeCode, VectorRegister& result,
+                           const VectorRegister& a, const VectorRegister& b);
+        // VSHL, VSHR: logical shift of every lane; counts of the lane width or more give 0
+        static void Shift(Opcode opcode, unsigned sizeCode, VectorRegister& result,
+                          const VectorRegister& a, unsigned count);
+        // VMASK, VREDSUM, VREDMIN, VREDMAX
+        static uint64_t Reduce(Opcode opcode, unsigned sizeCode, const VectorRegister& a);
+
+        static void Broadcast(unsigned sizeCode, VectorRegister& result, uint64_t value);
+        static uint64_t Extract(unsigned sizeCode, const VectorRegister& a, unsigned lane);
+        static void Insert(unsigned sizeCode, VectorRegister& result, uint64_t value, unsigned lane);
+
+        // Whether the AVX2 kernels are in use; disabling them forces the scalar code
+        static bool UsesAvx2();
+        static void EnableHostAcceleration(bool enable);
+    };
+}
+
+#endif // VM_VECTOR_UNIT_H
@@ -0,0 +1,36 @@
+// src/io/clock.cpp
+#include "clock.h"
+
+namespace vm {
+    Clock::Clock(ClockMode mode)
+        : mMode(mode)
+        , mVirtualFrequency(DEFAULT_VIRTUAL_FREQUENCY)
+        , mEpoch(std::chrono::steady_clock::now()) {
+    }
+
+    void Clock::Reset() {
+        mEpoch = std::chrono::steady_clock::now();
+    }
+
+    void Clock::SetVirtualFrequency(uint64_t hz) {
+        mVirtualFrequency = hz != 0 ? hz : DEFAULT_VIRTUAL_FREQUENCY;
+    }
+
+    uint64_t Clock::GetNanoseconds(uint64_t cycles) const {
+        if (mMode == ClockMode::VIRTUAL) {
+            return CyclesToNanoseconds(cycles);
+        }
+
+        auto elapsed = std::chrono::steady_clock::now() - mEpoch;
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    uint64_t Clock::CyclesToNanoseconds(uint64_t cycles) const {
+        if (mVirtualFrequency == DEFAULT_VIRTUAL_FREQUENCY) {
+            return cycles;
+        }
+        // 128-bit intermediate so long runs at high frequencies do not overflow
+        unsigned __int128 ns = static_cast<unsigned __int128>(cycles) * 1000000000ULL;
+        return static_cast<uint64_t>(ns / mVirtualFrequency);
+    }
+}
@@ -0,0 +1,42 @@
+// src/io/clock.h
+#ifndef VM_CLOCK_H
+#define VM_CLOCK_H
+
+#include <common/types.h>
+#include <chrono>
+
+namespace vm {
+    // Time source used by the clock device
+    enum class ClockMode : uint8_t {
+        HOST = 0,       // Host monotonic clock (steady_clock)
+        VIRTUAL = 1     // Derived from retired cycles, fully reproducible
+    };
+
+    // Clock device exposed to the guest through IN ports:
+    //   port 1 - nanoseconds since reset (host or virtual time, depending on the mode)
+    //   port 2 - virtual cycle counter (always deterministic)
+    class Clock {
+    private:
+        ClockMode mMode;
+        uint64_t mVirtualFrequency;   // Virtual cycles per second
+        std::chrono::steady_clock::time_point mEpoch;
+
+    public:
+        static constexpr uint64_t DEFAULT_VIRTUAL_FREQUENCY = 1000000000ULL; // 1 GHz
+
+        Clock(ClockMode mode = ClockMode::HOST);
+
+        void Reset();
+        void SetMode(ClockMode mode) { mMode = mode; }
+        ClockMode GetMode() const { return mMode; }
+        void SetVirtualFrequency(uint64_t hz);
+        uint64_t GetVirtualFrequency() const { return mVirtualFrequency; }
+
+        // Nanoseconds elapsed since reset, given the cycles retired so far
+        uint64_t GetNanoseconds(uint64_t cycles) const;
+        // Convert a cycle count to virtual nanoseconds
+        uint64_t CyclesToNanoseconds(uint64_t cycles) const;
+    };
+}
+
+#endif // VM_CLOCK_H
@@ -0,0 +1,61 @@
+// src/io/console.cpp
+#include "console.h"
+#include <iostream>
+
+namespace vm {
+    Console::Console() : mOutput(nullptr), mInput(nullptr), mContext(nullptr), mStream(&std::cout), mMuted(false) {
+    }
+
+    void Console::SetHandlers(OutputHandler output, InputHandler input, void* context) {
+        mOutput = output;
+        mInput = input;
+        mContext = context;
+    }
+
+    void Console::Write(ConsoleChannel channel, uint64_t value) {
+        if (mMuted) {
+            return;
+        }
+        if (mOutput) {
+            mOutput(mContext, channel, value);
+            return;
+        }
+
+        switch (channel) {
+            case ConsoleChannel::PRINT:
+                *mStream << "PRINT: " << std::dec << value
+                          << " (0x" << std::hex << value << ")" << std::endl;
+                break;
+            case ConsoleChannel::SCREEN:
+                *mStream << "Screen output: " << std::dec << value
+                          << " (char: '" << static_cast<char>(value & 0xFF) << "')" << std::endl;
+                break;
+            case ConsoleChannel::SERIAL:
+                *mStream << "Serial output: 0x" << std::hex << value << std::endl;
+                break;
+            default:
+                break;
+        }
+    }
+
+    uint64_t Console::Read(ConsoleChannel channel) {
+        if (mInput) {
+            return mInput(mContext, channel);
+        }
+        if (mMuted) {
+            return 0;
+        }
+
+        uint64_t value = 0;
+        *mStream << "Input from keyboard: " << std::flush;
+        std::cin >> value;
+        return value;
+    }
+
+    void Console::Diagnostic(const std::string& message) {
+        mLastDiagnostic = message;
+        if (!mMuted && !mOutput) {
+            std::cerr << message << std::endl;
+        }
+    }
+}
@@ -0,0 +1,53 @@
+// src/io/console.h
+#ifndef VM_CONSOLE_H
+#define VM_CONSOLE_H
+
+#include <common/types.h>
+#include <iosfwd>
+#include <string>
+
+namespace vm {
+    // Where a guest value is written or read
+    enum class ConsoleChannel : uint8_t {
+        PRINT = 0,      // PRINT instruction
+        SCREEN = 1,     // OUT port 0
+        SERIAL = 2,     // OUT port 1
+        KEYBOARD = 3    // IN port 0
+    };
+
+    // Console device behind PRINT, OUT ports 0/1 and IN port 0, plus the CPU's own
+    // diagnostics. It talks to the host terminal unless a handler is installed; an
+    // embedder installs its own handlers, or mutes the console entirely.
+    class Console {
+    public:
+        using OutputHandler = void (*)(void* context, ConsoleChannel channel, uint64_t value);
+        using InputHandler = uint64_t (*)(void* context, ConsoleChannel channel);
+
+    private:
+        OutputHandler mOutput;
+        InputHandler mInput;
+        void* mContext;
+        std::ostream* mStream; // Host terminal output, std::cout by default
+        bool mMuted;
+        std::string mLastDiagnostic; // Kept even when muted or redirected
+
+    public:
+        Console();
+
+        void SetHandlers(OutputHandler output, InputHandler input, void* context);
+        // Where PRINT/OUT (and the keyboard prompt) go when no handler is installed,
+        // e.g. std::cerr to keep stdout for a report
+        void SetOutputStream(std::ostream& stream) { mStream = &stream; }
+        void SetMuted(bool muted) { mMuted = muted; }
+        bool IsMuted() const { return mMuted; }
+
+        void Write(ConsoleChannel channel, uint64_t value);
+        uint64_t Read(ConsoleChannel channel);
+        // Host stderr only: dropped when muted or redirected
+        void Diagnostic(const std::string& message);
+        const std::string& GetLastDiagnostic() const { return mLastDiagnostic; }
+        void ClearLastDiagnostic() { mLastDiagnostic.clear(); }
+    };
+}
+
+#endif // VM_CONSOLE_H
@@ -7,10 +7,45 @@
 #include <iomanip>
 #include <sstream>
 #include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define VM_HAVE_MMAP 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 namespace vm {
-    Memory::Memory(size_t memSize) : mSize(memSize) {
-        mRam.resize(memSize, 0);
+    Memory::Memory(size_t memSize)
+        : mRam(nullptr), mSize(memSize), mMappedSize(0), mCodeBase(0), mCodeSize(0), mCodeGeneration(0) {
+#ifdef VM_HAVE_MMAP
+        // An anonymous mapping lets firmware sections be mapped over guest pages (MAP_FIXED)
+        size_t mappedSize = (memSize + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+        void* mapping = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping != MAP_FAILED) {
+            mRam = static_cast<uint8_t*>(mapping);
+            mMappedSize = mappedSize;
+        }
+#endif
+        if (!mRam) {
+            mFallbackRam.resize(memSize, 0);
+            mRam = mFallbackRam.data();
+        }
+        mTouchedPages.resize((memSize + PAGE_SIZE - 1) / PAGE_SIZE, 0);
+        SetDefaultSegments();
+    }
+
+    Memory::~Memory() {
+#ifdef VM_HAVE_MMAP
+        if (mMappedSize) {
+            munmap(mRam, mMappedSize);
+        }
+#endif
+    }
+
+    void Memory::SetDefaultSegments() {
+        mSegments.clear();
 
         // Segments par défaut
         AddSegment(MemorySegment(0x000000, 0x100000,
@@ -26,7 +61,7 @@ namespace vm {
                    static_cast<AccessType>(static_cast<uint8_t>(AccessType::READ) |
                                          static_cast<uint8_t>(AccessType::WRITE)),
                    "HEAP"));
-        AddSegment(MemorySegment(memSize - 0x100000, 0x100000,
+        AddSegment(MemorySegment(mSize - 0x100000, 0x100000,
                    static_cast<AccessType>(static_cast<uint8_t>(AccessType::READ) |
                                          static_cast<uint8_t>(AccessType::WRITE)),
                    "STACK"));
@@ -36,13 +71,68 @@ namespace vm {
         return addr < mSize;
     }
 
-    bool Memory::CheckAccess(uint64_t addr, AccessType type) const {
+    const MemorySegment* Memory::FindSegment(uint64_t addr) const {
         for (const auto& segment : mSegments) {
             if (addr >= segment.base && addr < segment.base + segment.size) {
-                return (static_cast<uint8_t>(segment.permissions) & static_cast<uint8_t>(type)) != 0;
+                return &segment;
             }
         }
-        return false;
+        return nullptr;
+    }
+
+    bool Memory::IsWordAccessible(uint64_t addr, AccessType type) const {
+        const MemorySegment* segment = FindSegment(addr);
+        return segment && (static_cast<uint8_t>(segment->permissions) & static_cast<uint8_t>(type)) != 0 &&
+               addr + sizeof(uint64_t) <= segment->base + segment->size && addr + sizeof(uint64_t) <= mSize;
+    }
+
+    bool Memory::CheckAccess(uint64_t addr, AccessType type) const {
+        const MemorySegment* segment = FindSegment(addr);
+        return segment && (static_cast<uint8_t>(segment->permissions) & static_cast<uint8_t>(type)) != 0;
+    }
+
+    void Memory::CheckRange(uint64_t addr, uint64_t size, AccessType type) const {
+        if (size == 0) {
+            return;
+        }
+        if (!IsValidAddress(addr) || size > mSize - addr) {
+            std::stringstream temp;
+            temp << "Invalid memory range: 0x" << std::hex << addr << " (+" << std::dec << size << " bytes)";
+            throw std::runtime_error(temp.str());
+        }
+
+        // Walk segment by segment rather than byte by byte
+        uint64_t end = addr + size;
+        for (uint64_t position = addr; position < end;) {
+            const MemorySegment* segment = FindSegment(position);
+            if (!segment || (static_cast<uint8_t>(segment->permissions) & static_cast<uint8_t>(type)) == 0) {
+                std::stringstream temp;
+                temp << "Memory access violation (" << (type == AccessType::WRITE ? "write" : "read")
+                     << ") at: 0x" << std::hex << position;
+                throw std::runtime_error(temp.str());
+            }
+            position = std::min(end, segment->base + segment->size);
+        }
+    }
+
+    const uint8_t* Memory::GetSpan(uint64_t addr, uint64_t size, AccessType type) const {
+        CheckRange(addr, size, type);
+        return mRam + addr;
+    }
+
+    uint8_t* Memory::GetWritableSpan(uint64_t addr, uint64_t size) {
+        CheckRange(addr, size, AccessType::WRITE);
+        MarkTouched(addr, size);
+        NoteWrite(addr, size);
+        return mRam + addr;
+    }
+
+    void Memory::MarkTouched(uint64_t addr, uint64_t size) {
+        if (size == 0) {
+            return;
+        }
+        std::fill(mTouchedPages.begin() + addr / PAGE_SIZE,
+                  mTouchedPages.begin() + (addr + size - 1) / PAGE_SIZE + 1, 1);
     }
 
     uint8_t Memory::Read8(uint64_t addr) {
@@ -68,6 +158,13 @@ namespace vm {
     }
 
     uint64_t Memory::Read64(uint64_t addr) {
+        // One segment check when the word sits inside a single segment; otherwise go
+        // byte by byte so a fault reports the first inaccessible byte
+        if (IsWordAccessible(addr, AccessType::READ)) {
+            uint64_t value;
+            std::memcpy(&value, mRam + addr, sizeof(value));
+            return value;
+        }
         return static_cast<uint64_t>(Read32(addr)) |
                (static_cast<uint64_t>(Read32(addr + 4)) << 32);
     }
@@ -82,6 +179,8 @@ namespace vm {
             throw std::runtime_error("Memory access violation (write) at: 0x" + std::to_string(addr));
         }
         mRam[addr] = value;
+        mTouchedPages[addr / PAGE_SIZE] = 1;
+        NoteWrite(addr, 1);
     }
 
     void Memory::Write16(uint64_t addr, uint16_t value) {
@@ -95,20 +194,99 @@ namespace vm {
     }
 
     void Memory::Write64(uint64_t addr, uint64_t value) {
+        if (IsWordAccessible(addr, AccessType::WRITE)) {
+            std::memcpy(mRam + addr, &value, sizeof(value));
+            MarkTouched(addr, sizeof(value));
+            NoteWrite(addr, sizeof(value));
+            return;
+        }
         Write32(addr, value & 0xFFFFFFFF);
         Write32(addr + 4, (value >> 32) & 0xFFFFFFFF);
     }
 
+    void Memory::WriteBlock(uint64_t addr, const void* data, uint64_t size) {
+        CheckRange(addr, size, AccessType::WRITE);
+        std::memcpy(mRam + addr, data, size);
+        MarkTouched(addr, size);
+        NoteWrite(addr, size);
+    }
+
+    void Memory::FillBlock(uint64_t addr, uint8_t value, uint64_t size) {
+        CheckRange(addr, size, AccessType::WRITE);
+        std::memset(mRam + addr, value, size);
+        MarkTouched(addr, size);
+        NoteWrite(addr, size);
+    }
+
+    bool Memory::LoadFromFile(int fd, uint64_t fileOffset, uint64_t addr, uint64_t size) {
+        CheckRange(addr, size, AccessType::WRITE);
+        if (size == 0) {
+            return true;
+        }
+
+#ifdef VM_HAVE_MMAP
+        // Only whole pages are mapped: a partial last page may be shared with another
+        // section, so it is read like an unaligned section
+        uint64_t done = 0;
+        uint64_t wholePages = size & ~(PAGE_SIZE - 1);
+        if (mMappedSize && wholePages && addr % PAGE_SIZE == 0 && fileOffset % PAGE_SIZE == 0) {
+            void* mapping = mmap(mRam + addr, wholePages, PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE | MAP_FIXED, fd, static_cast<off_t>(fileOffset));
+            if (mapping != MAP_FAILED) {
+                done = wholePages;
+            }
+        }
+
+        while (done < size) {
+            ssize_t count = pread(fd, mRam + addr + done, size - done, static_cast<off_t>(fileOffset + done));
+            if (count <= 0) {
+                return false;
+            }
+            done += static_cast<uint64_t>(count);
+        }
+        MarkTouched(addr, size);
+        NoteWrite(addr, size);
+        return true;
+#else
+        (void)fd;
+        (void)fileOffset;
+        return false;
+#endif
+    }
+
     void Memory::AddSegment(const MemorySegment& segment) {
         mSegments.push_back(segment);
     }
 
+    void Memory::SetSegments(const std::vector<MemorySegment>& segments) {
+        mSegments = segments;
+    }
+
     bool Memory::CheckPermissions(uint64_t addr, AccessType type) const {
         return CheckAccess(addr, type);
     }
 
     void Memory::Clear() {
-        std::fill(mRam.begin(), mRam.end(), 0);
+#ifdef VM_HAVE_MMAP
+        // A fresh anonymous mapping drops any file-backed pages and is cheaper than memset
+        if (mMappedSize && mmap(mRam, mMappedSize, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != MAP_FAILED) {
+            std::fill(mTouchedPages.begin(), mTouchedPages.end(), 0);
+            ++mCodeGeneration;
+            return;
+        }
+#endif
+        std::fill(mRam, mRam + mSize, 0);
+        std::fill(mTouchedPages.begin(), mTouchedPages.end(), 0);
+        ++mCodeGeneration;
+    }
+
+    uint64_t Memory::GetTouchedBytes() const {
+        uint64_t pages = 0;
+        for (uint8_t touched : mTouchedPages) {
+            pages += touched;
+        }
+        return pages * PAGE_SIZE;
     }
 
     void Memory::Dump(uint64_t start, uint64_t length) const {
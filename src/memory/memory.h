@@ -7,6 +7,7 @@
 
 #include <common/types.h>
 #include <vector>
+#include <string>
 #include <map>
 
 namespace vm {
@@ -21,17 +22,37 @@ namespace vm {
     };
 
     class Memory {
+    public:
+        static constexpr uint64_t PAGE_SIZE = 4096;
+
     private:
-        std::vector<uint8_t> mRam;
+        uint8_t* mRam;                        // Page-aligned, anonymous mapping where available
         size_t mSize;
+        size_t mMappedSize;                   // mSize rounded up to PAGE_SIZE (0: heap fallback)
+        std::vector<uint8_t> mFallbackRam;
         std::vector<MemorySegment> mSegments;
+        std::vector<uint8_t> mTouchedPages;   // One flag per page written since Clear()
+        uint64_t mCodeBase;                   // Watched range: writes bump mCodeGeneration
+        uint64_t mCodeSize;
+        uint64_t mCodeGeneration;
 
         bool IsValidAddress(uint64_t addr) const;
         bool CheckAccess(uint64_t addr, AccessType type) const;
+        bool IsWordAccessible(uint64_t addr, AccessType type) const; // All 8 bytes in one permitted segment
+        const MemorySegment* FindSegment(uint64_t addr) const;
+        void CheckRange(uint64_t addr, uint64_t size, AccessType type) const;
+        void MarkTouched(uint64_t addr, uint64_t size);
+        void NoteWrite(uint64_t addr, uint64_t size) {
+            if (addr < mCodeBase + mCodeSize && addr + size > mCodeBase) {
+                ++mCodeGeneration;
+            }
+        }
 
     public:
         Memory(size_t memSize);
-        ~Memory() = default;
+        ~Memory();
+        Memory(const Memory&) = delete;
+        Memory& operator=(const Memory&) = delete;
 
         // Lecture/écriture de base
         uint8_t Read8(uint64_t addr);
@@ -44,14 +65,36 @@ namespace vm {
         void Write32(uint64_t addr, uint32_t value);
         void Write64(uint64_t addr, uint64_t value);
 
+        // Bulk transfers: one range and permission check for the whole block
+        void WriteBlock(uint64_t addr, const void* data, uint64_t size);
+        void FillBlock(uint64_t addr, uint8_t value, uint64_t size);
+
+        // Load size bytes of a file straight into guest memory. The whole pages of a
+        // page-aligned range are mapped copy-on-write over the guest pages; a partial
+        // last page and unaligned ranges are read with pread().
+        bool LoadFromFile(int fd, uint64_t fileOffset, uint64_t addr, uint64_t size);
+
+        // Direct pointer to [addr, addr + size) after a single range and permission check
+        const uint8_t* GetSpan(uint64_t addr, uint64_t size, AccessType type) const;
+        // Same for writing through the pointer: the range counts as written (touched pages, code watch)
+        uint8_t* GetWritableSpan(uint64_t addr, uint64_t size);
+
+        // Code range watch: any write overlapping it bumps the code generation, which
+        // tells holders of decoded code that their copy is stale
+        void SetCodeRange(uint64_t base, uint64_t size) { mCodeBase = base; mCodeSize = size; ++mCodeGeneration; }
+        uint64_t GetCodeGeneration() const { return mCodeGeneration; }
+
         // Gestion des segments
         void AddSegment(const MemorySegment& segment);
+        void SetSegments(const std::vector<MemorySegment>& segments);
+        void SetDefaultSegments();
         bool CheckPermissions(uint64_t addr, AccessType type) const;
 
         // Utilitaires
         void Clear();
         void Dump(uint64_t start, uint64_t length) const;
         size_t GetSize() const { return mSize; }
+        uint64_t GetTouchedBytes() const; // Guest memory written since Clear(), page granular
     };
 }
 
@@ -0,0 +1,188 @@
+// src/profiler/sampling_profiler.cpp
+#include "sampling_profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <csignal>
+#include <ctime>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+namespace vm {
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                  "Sample buffer index must be lock-free to be used from a signal handler");
+
+    namespace {
+        std::atomic<SamplingProfiler*> sActiveProfiler{nullptr};
+
+#ifdef __linux__
+        struct sigaction sPreviousAction;
+
+        void HandleProfileSignal(int, siginfo_t*, void*) {
+            SamplingProfiler* profiler = sActiveProfiler.load(std::memory_order_relaxed);
+            if (profiler) {
+                profiler->RecordSample();
+            }
+        }
+#endif
+    }
+
+    SamplingProfiler::SamplingProfiler(size_t capacity)
+        : mSamples(std::make_unique<ProfileSample[]>(capacity))
+        , mCapacity(capacity)
+        , mWriteIndex(0)
+        , mDropped(0)
+        , mCPU(nullptr)
+        , mFrequency(0)
+        , mActive(false)
+        , mTimer(nullptr) {
+    }
+
+    SamplingProfiler::~SamplingProfiler() {
+        Stop();
+    }
+
+    bool SamplingProfiler::Start(const CPU& cpu, uint32_t frequencyHz) {
+#ifdef __linux__
+        if (mActive || frequencyHz == 0) {
+            return false;
+        }
+
+        SamplingProfiler* expected = nullptr;
+        if (!sActiveProfiler.compare_exchange_strong(expected, this)) {
+            std::cerr << "Error: Another sampling profiler is already active" << std::endl;
+            return false;
+        }
+
+        mCPU = &cpu;
+        mFrequency = frequencyHz;
+        mWriteIndex.store(0, std::memory_order_relaxed);
+        mDropped.store(0, std::memory_order_relaxed);
+
+        struct sigaction action{};
+        action.sa_sigaction = HandleProfileSignal;
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGPROF, &action, &sPreviousAction) != 0) {
+            sActiveProfiler.store(nullptr);
+            return false;
+        }
+
+        // Deliver the signal to the thread running the guest, measuring its CPU time only,
+        // so that time spent blocked (e.g. waiting for a key in step mode) is not sampled
+        struct sigevent event{};
+        event.sigev_notify = SIGEV_THREAD_ID;
+        event.sigev_signo = SIGPROF;
+        event._sigev_un._tid = static_cast<pid_t>(syscall(SYS_gettid));
+
+        timer_t timer;
+        if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &timer) != 0) {
+            sigaction(SIGPROF, &sPreviousAction, nullptr);
+            sActiveProfiler.store(nullptr);
+            return false;
+        }
+
+        struct itimerspec interval{};
+        // tv_nsec must stay below one second, so 1 Hz is { 1, 0 }
+        uint64_t periodNs = std::max<uint64_t>(1, 1000000000ULL / frequencyHz);
+        interval.it_interval.tv_sec = static_cast<time_t>(periodNs / 1000000000ULL);
+        interval.it_interval.tv_nsec = static_cast<long>(periodNs % 1000000000ULL);
+        interval.it_value = interval.it_interval;
+
+        if (timer_settime(timer, 0, &interval, nullptr) != 0) {
+            timer_delete(timer);
+            sigaction(SIGPROF, &sPreviousAction, nullptr);
+            sActiveProfiler.store(nullptr);
+            return false;
+        }
+
+        mTimer = timer;
+        mActive = true;
+        return true;
+#else
+        (void)cpu;
+        (void)frequencyHz;
+        std::cerr << "Error: Sampling profiler is only supported on Linux" << std::endl;
+        return false;
+#endif
+    }
+
+    void SamplingProfiler::Stop() {
+#ifdef __linux__
+        if (!mActive) {
+            return;
+        }
+
+        timer_delete(static_cast<timer_t>(mTimer));
+        mTimer = nullptr;
+        sigaction(SIGPROF, &sPreviousAction, nullptr);
+        sActiveProfiler.store(nullptr);
+        mActive = false;
+#endif
+    }
+
+    void SamplingProfiler::RecordSample() {
+        const CPU* cpu = mCPU;
+        if (!cpu) {
+            return;
+        }
+
+        uint64_t index = mWriteIndex.fetch_add(1, std::memory_order_relaxed);
+        if (index >= mCapacity) {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        mSamples[index].pc = cpu->mCurrentPC.load(std::memory_order_relaxed);
+        mSamples[index].callDepth = cpu->mCallDepth.load(std::memory_order_relaxed);
+    }
+
+    size_t SamplingProfiler::GetSampleCount() const {
+        return static_cast<size_t>(std::min<uint64_t>(mWriteIndex.load(std::memory_order_relaxed), mCapacity));
+    }
+
+    bool SamplingProfiler::WriteHistogram(const std::string& filename) const {
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Error: Cannot create profile file: " << filename << std::endl;
+            return false;
+        }
+
+        size_t count = GetSampleCount();
+        std::unordered_map<uint64_t, uint64_t> pcHistogram;
+        std::map<uint64_t, uint64_t> depthHistogram;
+        for (size_t i = 0; i < count; ++i) {
+            ++pcHistogram[mSamples[i].pc];
+            ++depthHistogram[mSamples[i].callDepth];
+        }
+
+        std::vector<std::pair<uint64_t, uint64_t>> hottest(pcHistogram.begin(), pcHistogram.end());
+        std::sort(hottest.begin(), hottest.end(), [](const auto& a, const auto& b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        });
+
+        file << "# VM sampling profile" << std::endl;
+        file << "# samples: " << count << " dropped: " << GetDroppedSamples()
+             << " frequency: " << mFrequency << " Hz" << std::endl;
+        file << "# pc <address> <samples> <percent>" << std::endl;
+        for (const auto& [pc, samples] : hottest) {
+            file << "pc 0x" << std::hex << std::setfill('0') << std::setw(16) << pc
+                 << " " << std::dec << samples << " " << std::fixed << std::setprecision(2)
+                 << (100.0 * samples / count) << std::endl;
+        }
+
+        file << "# depth <call depth> <samples>" << std::endl;
+        for (const auto& [depth, samples] : depthHistogram) {
+            file << "depth " << std::dec << depth << " " << samples << std::endl;
+        }
+
+        return file.good();
+    }
+}
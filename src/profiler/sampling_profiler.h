@@ -0,0 +1,55 @@
+// src/profiler/sampling_profiler.h
+#ifndef VM_SAMPLING_PROFILER_H
+#define VM_SAMPLING_PROFILER_H
+
+#include <cpu/cpu.h>
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace vm {
+    // One sample taken by the timer signal handler
+    struct ProfileSample {
+        uint64_t pc;
+        uint64_t callDepth;
+    };
+
+    // Low-overhead statistical profiler.
+    // A POSIX interval timer measuring the CPU time of the executing thread delivers
+    // SIGPROF; the handler copies the address of the executing guest instruction and
+    // the shadow call depth into a preallocated buffer (one atomic increment, no locks,
+    // no allocation).
+    // Only one profiler can be active at a time.
+    class SamplingProfiler {
+    private:
+        std::unique_ptr<ProfileSample[]> mSamples;
+        size_t mCapacity;
+        std::atomic<uint64_t> mWriteIndex;
+        std::atomic<uint64_t> mDropped;
+        const CPU* mCPU;
+        uint32_t mFrequency;
+        bool mActive;
+        void* mTimer;        // timer_t, kept opaque to avoid leaking <time.h> types
+
+    public:
+        SamplingProfiler(size_t capacity = 1 << 20);
+        ~SamplingProfiler();
+
+        // Start sampling the given CPU at the given frequency (samples per CPU second)
+        bool Start(const CPU& cpu, uint32_t frequencyHz = 1000);
+        void Stop();
+        bool IsActive() const { return mActive; }
+
+        // Async-signal-safe: called from the SIGPROF handler
+        void RecordSample();
+
+        size_t GetSampleCount() const;
+        uint64_t GetDroppedSamples() const { return mDropped.load(std::memory_order_relaxed); }
+        const ProfileSample* GetSamples() const { return mSamples.get(); }
+
+        // Write per-PC and per-call-depth histograms, hottest first
+        bool WriteHistogram(const std::string& filename) const;
+    };
+}
+
+#endif // VM_SAMPLING_PROFILER_H
@@ -0,0 +1,116 @@
+// src/vm/batch_runner.cpp
+#include "batch_runner.h"
+#include "vm.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace vm {
+    BatchRunner::BatchRunner(size_t threads, size_t memorySize)
+        : mThreads(threads), mMemorySize(memorySize), mInstructionLimit(DEFAULT_INSTRUCTION_LIMIT) {
+        if (mThreads == 0) {
+            mThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+    }
+
+    std::vector<std::string> BatchRunner::DiscoverFirmware(const std::string& path) {
+        namespace fs = std::filesystem;
+        std::vector<std::string> files;
+        std::error_code ec;
+
+        if (fs::is_directory(path, ec)) {
+            for (fs::recursive_directory_iterator it(path, fs::directory_options::skip_permission_denied, ec), end;
+                 !ec && it != end; it.increment(ec)) {
+                if (it->is_regular_file(ec) && it->path().extension() == ".vmfw") {
+                    files.push_back(it->path().string());
+                }
+            }
+            std::sort(files.begin(), files.end());
+        } else {
+            // List file: one firmware path per line, '#' starts a comment
+            std::ifstream list(path);
+            std::string line;
+            while (std::getline(list, line)) {
+                line.erase(0, line.find_first_not_of(" \t\r"));
+                line.erase(line.find_last_not_of(" \t\r") + 1);
+                if (!line.empty() && line[0] != '#') {
+                    files.push_back(line);
+                }
+            }
+        }
+
+        return files;
+    }
+
+    void BatchRunner::RunOne(VirtualMachine& machine, BatchResult& result) {
+        auto start = std::chrono::steady_clock::now();
+
+        machine.Reset();
+        if (!machine.LoadFirmware(result.filename)) {
+            result.error = machine.GetLastError().empty() ? "Cannot load firmware" : machine.GetLastError();
+        } else {
+            result.loaded = true;
+            machine.Run();
+
+            // Faults that halt the CPU without an exception only leave a console diagnostic
+            result.error = machine.GetLastError();
+            if (result.error.empty()) {
+                result.error = machine.GetCPU().GetConsole().GetLastDiagnostic();
+            }
+            result.instructions = machine.GetCounter(CounterType::INSTRUCTIONS);
+            result.faults = machine.GetCounter(CounterType::FAULTS);
+            result.timedOut = machine.ReachedInstructionLimit();
+            if (result.timedOut && result.error.empty()) {
+                result.error = "Instruction limit reached";
+            }
+            result.halted = result.error.empty() && result.faults == 0;
+            for (size_t i = 0; i < REGISTER_COUNT; ++i) {
+                result.registers[i] = machine.GetCPU().GetRegister(static_cast<uint8_t>(i));
+            }
+        }
+
+        result.wallNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+
+    std::vector<BatchResult> BatchRunner::Run(const std::vector<std::string>& files) const {
+        std::vector<BatchResult> results(files.size());
+        for (size_t i = 0; i < files.size(); ++i) {
+            results[i].filename = files[i];
+        }
+
+        // Workers pull the next image from a shared index, so long and short
+        // images balance across cores without a central queue
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            VirtualMachine machine(mMemorySize);
+            machine.SetTranslationCacheDirectory(mTranslationCacheDir);
+            machine.SetInstructionLimit(mInstructionLimit);
+            // Workers share the host terminal: no guest output mixed into the report,
+            // no concurrent reads from stdin
+            machine.GetCPU().GetConsole().SetMuted(true);
+            for (size_t i = next.fetch_add(1); i < results.size(); i = next.fetch_add(1)) {
+                try {
+                    RunOne(machine, results[i]);
+                } catch (const std::exception& e) {
+                    results[i].error = e.what();
+                }
+            }
+        };
+
+        size_t threadCount = std::min(mThreads, std::max<size_t>(1, files.size()));
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount);
+        for (size_t t = 0; t < threadCount; ++t) {
+            threads.emplace_back(worker);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        return results;
+    }
+}
@@ -0,0 +1,60 @@
+// src/vm/batch_runner.h
+#ifndef VM_BATCH_RUNNER_H
+#define VM_BATCH_RUNNER_H
+
+#include <common/types.h>
+#include <array>
+#include <string>
+#include <vector>
+
+namespace vm {
+    class VirtualMachine;
+
+    // Outcome of one firmware image run by the batch runner
+    struct BatchResult {
+        std::string filename;
+        bool loaded;              // Firmware file parsed and placed in guest memory
+        bool halted;              // Stopped by HLT (or end of program) without fault
+        bool timedOut;            // Stopped by the instruction limit
+        std::string error;        // Load or runtime error message, or the guest's fault diagnostic
+        uint64_t instructions;
+        uint64_t faults;
+        double wallNs;            // Load + execution time
+        std::array<uint64_t, REGISTER_COUNT> registers;
+
+        BatchResult() : loaded(false), halted(false), timedOut(false), instructions(0), faults(0), wallNs(0.0) {
+            registers.fill(0);
+        }
+    };
+
+    // Runs many firmware images concurrently, one VirtualMachine per worker thread.
+    // Guest consoles are muted (IN reads 0), and an image that retires more than the
+    // instruction limit is stopped and reported as timed out.
+    class BatchRunner {
+    private:
+        size_t mThreads;
+        size_t mMemorySize;
+        uint64_t mInstructionLimit;
+        std::string mTranslationCacheDir;
+
+        static void RunOne(VirtualMachine& machine, BatchResult& result);
+
+    public:
+        static constexpr uint64_t DEFAULT_INSTRUCTION_LIMIT = 10'000'000'000ULL;
+
+        // threads == 0 uses one worker per host core
+        BatchRunner(size_t threads = 0, size_t memorySize = 4 * 1024 * 1024);
+
+        // .vmfw files under a directory (recursively), or the paths listed in a text file
+        static std::vector<std::string> DiscoverFirmware(const std::string& path);
+
+        std::vector<BatchResult> Run(const std::vector<std::string>& files) const;
+        size_t GetThreadCount() const { return mThreads; }
+        void SetTranslationCacheDirectory(const std::string& directory) { mTranslationCacheDir = directory; }
+        // Per-image budget, 0 for none
+        void SetInstructionLimit(uint64_t limit) { mInstructionLimit = limit; }
+        uint64_t GetInstructionLimit() const { return mInstructionLimit; }
+    };
+}
+
+#endif // VM_BATCH_RUNNER_H
@@ -0,0 +1,224 @@
+// src/vm/firmware_codec.cpp
+#include "firmware_codec.h"
+#include <algorithm>
+#include <cstring>
+
+namespace vm {
+    namespace {
+        constexpr size_t kPlaneCount = sizeof(uint64_t);
+        constexpr size_t kMinMatch = 4;
+        constexpr size_t kMaxOffset = 65535;
+        constexpr int kHashBits = 14;
+
+        void AppendLength(std::vector<uint8_t>& output, size_t length) {
+            for (; length >= 255; length -= 255) {
+                output.push_back(255);
+            }
+            output.push_back(static_cast<uint8_t>(length));
+        }
+
+        void AppendSequence(std::vector<uint8_t>& output, const uint8_t* literals, size_t literalLength,
+                            size_t offset, size_t matchLength) {
+            size_t matchCode = matchLength ? matchLength - kMinMatch : 0;
+            output.push_back(static_cast<uint8_t>((std::min<size_t>(literalLength, 15) << 4) |
+                                                  std::min<size_t>(matchCode, 15)));
+            if (literalLength >= 15) {
+                AppendLength(output, literalLength - 15);
+            }
+            output.insert(output.end(), literals, literals + literalLength);
+
+            if (matchLength) {
+                output.push_back(static_cast<uint8_t>(offset));
+                output.push_back(static_cast<uint8_t>(offset >> 8));
+                if (matchCode >= 15) {
+                    AppendLength(output, matchCode - 15);
+                }
+            }
+        }
+
+        // Greedy LZ77 with a single-entry hash table, as in LZ4's fast mode
+        void EncodePayload(const uint8_t* input, size_t size, std::vector<uint8_t>& output) {
+            std::vector<int32_t> table(size_t(1) << kHashBits, -1);
+            size_t anchor = 0;
+            size_t i = 0;
+
+            while (i + kMinMatch <= size) {
+                uint32_t sequence;
+                std::memcpy(&sequence, input + i, sizeof(sequence));
+                uint32_t hash = (sequence * 2654435761U) >> (32 - kHashBits);
+                int32_t candidate = table[hash];
+                table[hash] = static_cast<int32_t>(i);
+
+                if (candidate >= 0 && i - candidate <= kMaxOffset &&
+                    std::memcmp(input + candidate, input + i, kMinMatch) == 0) {
+                    size_t length = kMinMatch;
+                    while (i + length < size && input[candidate + length] == input[i + length]) {
+                        ++length;
+                    }
+                    AppendSequence(output, input + anchor, i - anchor, i - candidate, length);
+                    i += length;
+                    anchor = i;
+                } else {
+                    ++i;
+                }
+            }
+
+            AppendSequence(output, input + anchor, size - anchor, 0, 0);
+        }
+
+        bool ReadLength(const uint8_t*& input, const uint8_t* end, size_t& length) {
+            uint8_t byte;
+            do {
+                if (input >= end) {
+                    return false;
+                }
+                byte = *input++;
+                length += byte;
+            } while (byte == 255);
+            return true;
+        }
+
+        void AppendU32(std::vector<uint8_t>& output, uint32_t value) {
+            uint8_t bytes[4];
+            std::memcpy(bytes, &value, sizeof(bytes));
+            output.insert(output.end(), bytes, bytes + sizeof(bytes));
+        }
+    }
+
+    std::vector<uint8_t> CompressCode(const uint64_t* code, size_t count) {
+        std::vector<uint8_t> output;
+        std::vector<uint8_t> planes(kPlaneCount * CODEC_BLOCK_INSTRUCTIONS);
+
+        for (size_t first = 0; first < count; first += CODEC_BLOCK_INSTRUCTIONS) {
+            size_t blockCount = std::min<size_t>(CODEC_BLOCK_INSTRUCTIONS, count - first);
+
+            size_t headerPosition = output.size();
+            AppendU32(output, static_cast<uint32_t>(blockCount));
+            AppendU32(output, 0);
+
+            for (size_t p = 0; p < kPlaneCount; ++p) {
+                for (size_t i = 0; i < blockCount; ++i) {
+                    planes[p * blockCount + i] = static_cast<uint8_t>(code[first + i] >> (p * 8));
+                }
+            }
+            EncodePayload(planes.data(), kPlaneCount * blockCount, output);
+
+            uint32_t payloadSize = static_cast<uint32_t>(output.size() - headerPosition - 8);
+            std::memcpy(output.data() + headerPosition + 4, &payloadSize, sizeof(payloadSize));
+        }
+        return output;
+    }
+
+    CodeDecompressor::CodeDecompressor(const uint8_t* data, size_t size)
+        : mData(data), mSize(size), mPosition(0), mPlanes(kPlaneCount * CODEC_BLOCK_INSTRUCTIONS) {
+    }
+
+    bool CodeDecompressor::DecodePayload(const uint8_t* input, const uint8_t* end, uint8_t* output, size_t size) {
+        size_t written = 0;
+        while (input < end) {
+            uint8_t token = *input++;
+
+            size_t literalLength = token >> 4;
+            if (literalLength == 15 && !ReadLength(input, end, literalLength)) {
+                return false;
+            }
+            if (literalLength > static_cast<size_t>(end - input) || literalLength > size - written) {
+                return false;
+            }
+            std::memcpy(output + written, input, literalLength);
+            input += literalLength;
+            written += literalLength;
+
+            if (input == end) {
+                break;
+            }
+
+            if (end - input < 2) {
+                return false;
+            }
+            size_t offset = input[0] | (static_cast<size_t>(input[1]) << 8);
+            input += 2;
+            size_t matchLength = token & 0x0F;
+            if (matchLength == 15 && !ReadLength(input, end, matchLength)) {
+                return false;
+            }
+            matchLength += kMinMatch;
+            if (offset == 0 || offset > written || matchLength > size - written) {
+                return false;
+            }
+
+            // Matches may overlap their own output (runs), so copy forward byte by byte then
+            const uint8_t* source = output + written - offset;
+            uint8_t* destination = output + written;
+            if (offset >= matchLength) {
+                std::memcpy(destination, source, matchLength);
+            } else {
+                for (size_t i = 0; i < matchLength; ++i) {
+                    destination[i] = source[i];
+                }
+            }
+            written += matchLength;
+        }
+        return written == size;
+    }
+
+    size_t CodeDecompressor::NextBlock(uint64_t* output) {
+        if (mPosition == mSize || HasError()) {
+            return 0;
+        }
+        if (mSize - mPosition < 8) {
+            mError = "Truncated compressed block header";
+            return 0;
+        }
+
+        uint32_t count;
+        uint32_t payloadSize;
+        std::memcpy(&count, mData + mPosition, sizeof(count));
+        std::memcpy(&payloadSize, mData + mPosition + 4, sizeof(payloadSize));
+        if (count == 0 || count > CODEC_BLOCK_INSTRUCTIONS || payloadSize > mSize - mPosition - 8) {
+            mError = "Corrupt compressed block header";
+            return 0;
+        }
+
+        const uint8_t* input = mData + mPosition + 8;
+        if (!DecodePayload(input, input + payloadSize, mPlanes.data(), kPlaneCount * count)) {
+            mError = "Corrupt compressed block";
+            return 0;
+        }
+
+        // Interleave the planes back into instruction words
+        const uint8_t* planes = mPlanes.data();
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t word = 0;
+            for (size_t p = 0; p < kPlaneCount; ++p) {
+                word |= static_cast<uint64_t>(planes[p * count + i]) << (p * 8);
+            }
+            output[i] = word;
+        }
+
+        mPosition += 8 + payloadSize;
+        return count;
+    }
+
+    bool DecompressCode(const uint8_t* data, size_t size, uint64_t* output, size_t count) {
+        CodeDecompressor decompressor(data, size);
+        std::vector<uint64_t> block(CODEC_BLOCK_INSTRUCTIONS);
+        size_t decoded = 0;
+        for (;;) {
+            // Decode in place while a full block still fits, through scratch for the tail
+            bool direct = count - decoded >= CODEC_BLOCK_INSTRUCTIONS;
+            size_t blockCount = decompressor.NextBlock(direct ? output + decoded : block.data());
+            if (blockCount == 0) {
+                break;
+            }
+            if (blockCount > count - decoded) {
+                return false;
+            }
+            if (!direct) {
+                std::memcpy(output + decoded, block.data(), blockCount * sizeof(uint64_t));
+            }
+            decoded += blockCount;
+        }
+        return !decompressor.HasError() && decoded == count;
+    }
+}
@@ -0,0 +1,56 @@
+// src/vm/firmware_codec.h
+#ifndef VM_FIRMWARE_CODEC_H
+#define VM_FIRMWARE_CODEC_H
+
+#include <common/types.h>
+#include <string>
+#include <vector>
+
+namespace vm {
+    // Instruction-aware codec for compressed CODE sections.
+    //
+    // Code is cut into blocks of up to CODEC_BLOCK_INSTRUCTIONS words. Inside a block the
+    // words are split into 8 byte planes (immediate bytes, reg2|immediate, mode|reg1, opcode)
+    // laid end to end, and the result is compressed with an LZ4-style byte coder. The upper
+    // immediate planes become a few long matches, and recurring instruction sequences
+    // match within the opcode and register planes.
+    //
+    //   block    := uint32 instructionCount, uint32 payloadSize, payload
+    //   payload  := sequence*, decoding to exactly 8 * instructionCount bytes
+    //   sequence := token, [literal length bytes], literals, [uint16 offset, [match length bytes]]
+    //   token    := literal length (high nibble), match length - 4 (low nibble); 15 means
+    //               "add the following bytes until one is below 255". The last sequence of a
+    //               block carries literals only.
+    constexpr uint32_t CODEC_BLOCK_INSTRUCTIONS = 8192;
+
+    std::vector<uint8_t> CompressCode(const uint64_t* code, size_t count);
+
+    // Decodes one block at a time so that callers can stream into guest memory
+    // with a fixed amount of scratch space
+    class CodeDecompressor {
+    private:
+        const uint8_t* mData;
+        size_t mSize;
+        size_t mPosition;
+        std::vector<uint8_t> mPlanes;
+        std::string mError;
+
+        bool DecodePayload(const uint8_t* input, const uint8_t* end, uint8_t* output, size_t size);
+
+    public:
+        CodeDecompressor(const uint8_t* data, size_t size);
+
+        // Decode the next block into output (room for CODEC_BLOCK_INSTRUCTIONS words).
+        // Returns the number of words written, 0 at the end of the stream or on error.
+        size_t NextBlock(uint64_t* output);
+
+        bool IsFinished() const { return mPosition == mSize; }
+        bool HasError() const { return !mError.empty(); }
+        const std::string& GetError() const { return mError; }
+    };
+
+    // Decode a whole stream; fails unless it yields exactly count words
+    bool DecompressCode(const uint8_t* data, size_t size, uint64_t* output, size_t count);
+}
+
+#endif // VM_FIRMWARE_CODEC_H
@@ -0,0 +1,367 @@
+// src/vm/firmware_format.cpp
+#include "firmware_format.h"
+#include "firmware_loader.h"
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define VM_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vm {
+    namespace {
+        constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+        constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+        constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+
+        inline uint64_t Rotl(uint64_t value, int shift) {
+            return (value << shift) | (value >> (64 - shift));
+        }
+
+        inline uint64_t MixWord(uint64_t lane, uint64_t word) {
+            lane += word * kPrime2;
+            return Rotl(lane, 31) * kPrime1;
+        }
+
+        // True when [offset, offset + size) lies inside a file of fileSize bytes
+        inline bool InFile(uint64_t offset, uint64_t size, uint64_t fileSize) {
+            return offset <= fileSize && size <= fileSize - offset;
+        }
+    }
+
+    uint64_t FirmwareChecksum(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        size_t position = 0;
+
+        // Four independent lanes keep the multiplier pipeline busy on large sections
+        uint64_t lanes[4] = {kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1};
+        for (; position + 32 <= size; position += 32) {
+            for (int lane = 0; lane < 4; ++lane) {
+                uint64_t word;
+                std::memcpy(&word, bytes + position + lane * 8, sizeof(word));
+                lanes[lane] = MixWord(lanes[lane], word);
+            }
+        }
+
+        uint64_t hash = Rotl(lanes[0], 1) + Rotl(lanes[1], 7) + Rotl(lanes[2], 12) + Rotl(lanes[3], 18);
+        hash += static_cast<uint64_t>(size) * kPrime3;
+
+        for (; position + 8 <= size; position += 8) {
+            uint64_t word;
+            std::memcpy(&word, bytes + position, sizeof(word));
+            hash ^= MixWord(0, word);
+            hash = Rotl(hash, 27) * kPrime1 + kPrime3;
+        }
+
+        if (position < size) {
+            uint64_t tail = 0;
+            std::memcpy(&tail, bytes + position, size - position);
+            hash ^= MixWord(0, tail);
+            hash = Rotl(hash, 27) * kPrime1 + kPrime3;
+        }
+
+        hash ^= hash >> 33;
+        hash *= kPrime2;
+        hash ^= hash >> 29;
+        hash *= kPrime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    const char* SectionTypeToString(SectionType type) {
+        switch (type) {
+            case SectionType::CODE: return "CODE";
+            case SectionType::DATA: return "DATA";
+            case SectionType::SYMBOLS: return "SYMBOLS";
+            case SectionType::LAYOUT: return "LAYOUT";
+            case SectionType::DESCRIPTION: return "DESCRIPTION";
+            default: return "UNKNOWN";
+        }
+    }
+
+    MappedFirmware::MappedFirmware()
+        : mData(nullptr), mSize(0), mFd(-1), mMapped(false),
+          mVersion(0), mEntryPoint(0), mTimestamp(0) {
+    }
+
+    MappedFirmware::~MappedFirmware() {
+        Close();
+    }
+
+    bool MappedFirmware::Open(const std::string& filename) {
+        Close();
+
+#ifdef VM_HAVE_MMAP
+        mFd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (mFd < 0) {
+            mError = "Cannot open firmware file: " + filename;
+            return false;
+        }
+
+        struct stat info{};
+        if (fstat(mFd, &info) != 0) {
+            mError = "Cannot stat firmware file: " + filename;
+            Close();
+            return false;
+        }
+        mSize = static_cast<size_t>(info.st_size);
+
+        if (mSize > 0) {
+            void* mapping = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFd, 0);
+            if (mapping == MAP_FAILED) {
+                mError = "Cannot map firmware file: " + filename;
+                Close();
+                return false;
+            }
+            mData = static_cast<const uint8_t*>(mapping);
+            mMapped = true;
+        }
+#else
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            mError = "Cannot open firmware file: " + filename;
+            return false;
+        }
+        mBuffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        mData = mBuffer.data();
+        mSize = mBuffer.size();
+#endif
+
+        return Parse();
+    }
+
+    bool MappedFirmware::OpenMemory(const void* data, size_t size) {
+        Close();
+        mData = static_cast<const uint8_t*>(data);
+        mSize = size;
+        return Parse();
+    }
+
+    bool MappedFirmware::Parse() {
+        if (!mData || mSize < 8) {
+            Close();
+            mError = "File too small to be firmware";
+            return false;
+        }
+
+        bool parsed = false;
+        if (std::memcmp(mData, "VMFW001", 8) == 0) {
+            parsed = ParseV1();
+        } else if (std::memcmp(mData, "VMFW002", 8) == 0) {
+            parsed = ParseV2();
+        } else {
+            mError = "Bad firmware signature";
+        }
+
+        if (!parsed) {
+            std::string error = mError;
+            Close();
+            mError = error;
+            return false;
+        }
+        return true;
+    }
+
+    void MappedFirmware::Close() {
+#ifdef VM_HAVE_MMAP
+        if (mMapped) {
+            munmap(const_cast<uint8_t*>(mData), mSize);
+        }
+        if (mFd >= 0) {
+            close(mFd);
+        }
+#endif
+        mBuffer.clear();
+        mData = nullptr;
+        mSize = 0;
+        mFd = -1;
+        mMapped = false;
+        mVersion = 0;
+        mEntryPoint = 0;
+        mTimestamp = 0;
+        mSections.clear();
+        mError.clear();
+    }
+
+    bool MappedFirmware::ParseV1() {
+        FirmwareHeader header;
+        if (mSize < sizeof(header)) {
+            mError = "Truncated firmware header";
+            return false;
+        }
+        std::memcpy(&header, mData, sizeof(header));
+
+        if (header.mVersion != 1 || header.mInstructionCount == 0 || header.mDescriptionSize > 10000) {
+            mError = "Invalid firmware header";
+            return false;
+        }
+
+        uint64_t descriptionOffset = sizeof(header);
+        uint64_t codeOffset = descriptionOffset + header.mDescriptionSize;
+        uint64_t codeSize = static_cast<uint64_t>(header.mInstructionCount) * sizeof(uint64_t);
+        if (!InFile(codeOffset, codeSize, mSize)) {
+            mError = "Firmware file is truncated";
+            return false;
+        }
+
+        mVersion = 1;
+        mEntryPoint = header.mEntryPoint;
+        mTimestamp = header.mTimestamp;
+
+        // v1 has no checksums: sections are synthesized with a zero checksum and never verified
+        FirmwareSection code;
+        code.mType = static_cast<uint32_t>(SectionType::CODE);
+        code.mOffset = codeOffset;
+        code.mFileSize = codeSize;
+        code.mMemorySize = codeSize;
+        mSections.push_back(code);
+
+        if (header.mDescriptionSize > 0) {
+            FirmwareSection description;
+            description.mType = static_cast<uint32_t>(SectionType::DESCRIPTION);
+            description.mOffset = descriptionOffset;
+            description.mFileSize = header.mDescriptionSize;
+            description.mMemorySize = header.mDescriptionSize;
+            mSections.push_back(description);
+        }
+        return true;
+    }
+
+    bool MappedFirmware::ParseV2() {
+        FirmwareHeaderV2 header;
+        if (mSize < sizeof(header)) {
+            mError = "Truncated firmware header";
+            return false;
+        }
+        std::memcpy(&header, mData, sizeof(header));
+
+        if (header.mVersion != FIRMWARE_VERSION_2) {
+            mError = "Unsupported firmware version " + std::to_string(header.mVersion);
+            return false;
+        }
+
+        uint64_t tableSize = static_cast<uint64_t>(header.mSectionCount) * sizeof(FirmwareSection);
+        if (header.mHeaderSize != sizeof(header) + tableSize || !InFile(sizeof(header), tableSize, mSize)) {
+            mError = "Invalid section table";
+            return false;
+        }
+
+        const uint8_t* table = mData + sizeof(header);
+        if (FirmwareChecksum(table, tableSize) != header.mTableChecksum) {
+            mError = "Section table checksum mismatch";
+            return false;
+        }
+
+        mSections.resize(header.mSectionCount);
+        std::memcpy(mSections.data(), table, tableSize);
+
+        bool hasCode = false;
+        for (const auto& section : mSections) {
+            if (section.mOffset % SectionAlignment(section) != 0 || !InFile(section.mOffset, section.mFileSize, mSize)) {
+                mError = std::string("Section ") + SectionTypeToString(static_cast<SectionType>(section.mType)) +
+                         " lies outside the file or is misaligned";
+                return false;
+            }
+            if (section.mType == static_cast<uint32_t>(SectionType::CODE)) {
+                if (hasCode || section.mMemorySize % sizeof(uint64_t) != 0 || section.mMemorySize == 0) {
+                    mError = "Invalid CODE section";
+                    return false;
+                }
+                hasCode = true;
+            } else if (section.mFlags & SECTION_FLAG_COMPRESSED) {
+                mError = std::string("Section ") + SectionTypeToString(static_cast<SectionType>(section.mType)) +
+                         " is compressed; only CODE may be";
+                return false;
+            }
+        }
+
+        if (!hasCode) {
+            mError = "Firmware has no CODE section";
+            return false;
+        }
+
+        mVersion = FIRMWARE_VERSION_2;
+        mEntryPoint = header.mEntryPoint;
+        mTimestamp = header.mTimestamp;
+        return true;
+    }
+
+    bool MappedFirmware::VerifyChecksums() {
+        if (mVersion != FIRMWARE_VERSION_2) {
+            return mVersion != 0;
+        }
+
+        for (const auto& section : mSections) {
+            if (FirmwareChecksum(GetSectionData(section), section.mFileSize) != section.mChecksum) {
+                mError = std::string("Checksum mismatch in section ") +
+                         SectionTypeToString(static_cast<SectionType>(section.mType));
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const FirmwareSection* MappedFirmware::FindSection(SectionType type) const {
+        for (const auto& section : mSections) {
+            if (section.mType == static_cast<uint32_t>(type)) {
+                return &section;
+            }
+        }
+        return nullptr;
+    }
+
+    std::string MappedFirmware::GetDescription() const {
+        const FirmwareSection* section = FindSection(SectionType::DESCRIPTION);
+        if (!section) {
+            return "";
+        }
+        return std::string(reinterpret_cast<const char*>(GetSectionData(*section)), section->mFileSize);
+    }
+
+    std::vector<FirmwareSymbol> MappedFirmware::GetSymbols() const {
+        std::vector<FirmwareSymbol> symbols;
+        const FirmwareSection* section = FindSection(SectionType::SYMBOLS);
+        if (!section) {
+            return symbols;
+        }
+
+        const uint8_t* data = GetSectionData(*section);
+        uint64_t position = 0;
+        while (InFile(position, sizeof(FirmwareSymbolRecord), section->mFileSize)) {
+            FirmwareSymbolRecord record;
+            std::memcpy(&record, data + position, sizeof(record));
+            position += sizeof(record);
+            if (!InFile(position, record.mNameLength, section->mFileSize)) {
+                break;
+            }
+
+            symbols.push_back({std::string(reinterpret_cast<const char*>(data + position), record.mNameLength),
+                               record.mAddress});
+            position += (record.mNameLength + 7) & ~uint64_t(7);
+        }
+        return symbols;
+    }
+
+    std::vector<FirmwareSegment> MappedFirmware::GetSegments() const {
+        std::vector<FirmwareSegment> segments;
+        const FirmwareSection* section = FindSection(SectionType::LAYOUT);
+        if (!section) {
+            return segments;
+        }
+
+        const uint8_t* data = GetSectionData(*section);
+        size_t count = section->mFileSize / sizeof(FirmwareSegmentRecord);
+        for (size_t i = 0; i < count; ++i) {
+            FirmwareSegmentRecord record;
+            std::memcpy(&record, data + i * sizeof(record), sizeof(record));
+            record.mName[sizeof(record.mName) - 1] = '\0';
+            segments.push_back({record.mName, record.mBase, record.mSize,
+                                static_cast<AccessType>(record.mPermissions)});
+        }
+        return segments;
+    }
+}
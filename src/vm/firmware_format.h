@@ -0,0 +1,172 @@
+// src/vm/firmware_format.h
+#ifndef VM_FIRMWARE_FORMAT_H
+#define VM_FIRMWARE_FORMAT_H
+
+#include <common/types.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace vm {
+    // Firmware format v2
+    //
+    //   FirmwareHeaderV2            fixed 64 bytes at offset 0
+    //   FirmwareSection[count]      section table right after the header
+    //   sections                    CODE/DATA on a FIRMWARE_PAGE_SIZE boundary, others on 8 bytes
+    //
+    // Page-aligned sections let CODE and DATA be mmap()ed straight over guest memory.
+    // Compressed sections are decoded rather than mapped and only need 8-byte alignment.
+    // All fields are little-endian.
+    constexpr uint32_t FIRMWARE_VERSION_2 = 2;
+    constexpr uint64_t FIRMWARE_PAGE_SIZE = 4096;
+
+    // FirmwareSection::mFlags
+    constexpr uint32_t SECTION_FLAG_COMPRESSED = 1;    // CODE stored with the firmware codec
+
+    enum class SectionType : uint32_t {
+        CODE = 1,           // Instruction words, loaded at mLoadAddress
+        DATA = 2,           // Initialized data, loaded at mLoadAddress
+        SYMBOLS = 3,        // FirmwareSymbolRecord entries
+        LAYOUT = 4,         // FirmwareSegmentRecord entries (guest memory segments)
+        DESCRIPTION = 5     // UTF-8 text
+    };
+
+    struct FirmwareHeaderV2 {
+        char mMagic[8];             // "VMFW002\0"
+        uint32_t mVersion;          // FIRMWARE_VERSION_2
+        uint32_t mSectionCount;
+        uint64_t mEntryPoint;
+        uint64_t mTimestamp;
+        uint32_t mHeaderSize;       // Header + section table
+        uint32_t mFlags;
+        uint64_t mTableChecksum;    // Checksum of the section table
+        uint8_t mReserved[16];
+
+        FirmwareHeaderV2() : mVersion(FIRMWARE_VERSION_2), mSectionCount(0), mEntryPoint(0),
+                             mTimestamp(0), mHeaderSize(0), mFlags(0), mTableChecksum(0) {
+            std::memcpy(mMagic, "VMFW002", 8);
+            std::memset(mReserved, 0, sizeof(mReserved));
+        }
+    };
+    static_assert(sizeof(FirmwareHeaderV2) == 64, "FirmwareHeaderV2 layout is part of the file format");
+
+    struct FirmwareSection {
+        uint32_t mType;             // SectionType
+        uint32_t mFlags;
+        uint64_t mOffset;           // File offset, see SectionAlignment()
+        uint64_t mFileSize;         // Bytes stored in the file
+        uint64_t mMemorySize;       // Bytes occupied once loaded (uncompressed size)
+        uint64_t mLoadAddress;      // Guest address (CODE, DATA)
+        uint64_t mChecksum;         // FirmwareChecksum of the stored bytes
+
+        FirmwareSection() : mType(0), mFlags(0), mOffset(0), mFileSize(0),
+                            mMemorySize(0), mLoadAddress(0), mChecksum(0) {}
+    };
+    static_assert(sizeof(FirmwareSection) == 48, "FirmwareSection layout is part of the file format");
+
+    struct FirmwareSymbolRecord {
+        uint64_t mAddress;
+        uint32_t mNameLength;       // Name bytes follow, padded to 8 bytes
+        uint32_t mReserved;
+    };
+
+    struct FirmwareSegmentRecord {
+        uint64_t mBase;
+        uint64_t mSize;
+        uint32_t mPermissions;      // AccessType bits
+        uint32_t mReserved;
+        char mName[24];
+    };
+    static_assert(sizeof(FirmwareSegmentRecord) == 48, "FirmwareSegmentRecord layout is part of the file format");
+
+    struct FirmwareSymbol {
+        std::string name;
+        uint64_t address;
+    };
+
+    struct FirmwareSegment {
+        std::string name;
+        uint64_t base;
+        uint64_t size;
+        AccessType permissions;
+    };
+
+    // In-memory form of a firmware image (any version)
+    struct FirmwareImage {
+        std::vector<uint64_t> code;
+        uint64_t codeAddress;
+        std::vector<uint8_t> data;
+        uint64_t dataAddress;
+        std::vector<FirmwareSymbol> symbols;
+        std::vector<FirmwareSegment> segments;  // Empty: default memory layout
+        uint64_t entryPoint;
+        std::string description;
+
+        FirmwareImage() : codeAddress(0), dataAddress(0x100000), entryPoint(0) {}
+    };
+
+    // Required file alignment of a section: a page for anything mapped into guest memory
+    inline uint64_t SectionAlignment(const FirmwareSection& section) {
+        bool mapped = (section.mType == static_cast<uint32_t>(SectionType::CODE) ||
+                       section.mType == static_cast<uint32_t>(SectionType::DATA)) &&
+                      !(section.mFlags & SECTION_FLAG_COMPRESSED);
+        return mapped ? FIRMWARE_PAGE_SIZE : sizeof(uint64_t);
+    }
+
+    // 64-bit checksum over a byte range (word-at-a-time multiply/rotate mixing)
+    uint64_t FirmwareChecksum(const void* data, size_t size);
+
+    // Read-only view of a firmware file, memory-mapped where the platform allows, or of an
+    // image held in memory.
+    // v1 files are presented as a single (unaligned) CODE section.
+    class MappedFirmware {
+    private:
+        const uint8_t* mData;
+        size_t mSize;
+        int mFd;
+        bool mMapped;
+        std::vector<uint8_t> mBuffer;           // Fallback when mmap is unavailable
+        uint32_t mVersion;
+        uint64_t mEntryPoint;
+        uint64_t mTimestamp;
+        std::vector<FirmwareSection> mSections;
+        std::string mError;
+
+        bool Parse();
+        bool ParseV1();
+        bool ParseV2();
+
+    public:
+        MappedFirmware();
+        ~MappedFirmware();
+        MappedFirmware(const MappedFirmware&) = delete;
+        MappedFirmware& operator=(const MappedFirmware&) = delete;
+
+        bool Open(const std::string& filename);
+        // View an image already in memory; the caller keeps it alive until Close()
+        bool OpenMemory(const void* data, size_t size);
+        void Close();
+
+        // Recompute every section checksum (linear in the image size)
+        bool VerifyChecksums();
+
+        uint32_t GetVersion() const { return mVersion; }
+        uint64_t GetEntryPoint() const { return mEntryPoint; }
+        uint64_t GetTimestamp() const { return mTimestamp; }
+        size_t GetFileSize() const { return mSize; }
+        int GetFileDescriptor() const { return mFd; }
+        const std::string& GetError() const { return mError; }
+
+        const std::vector<FirmwareSection>& GetSections() const { return mSections; }
+        const FirmwareSection* FindSection(SectionType type) const;
+        const uint8_t* GetSectionData(const FirmwareSection& section) const { return mData + section.mOffset; }
+
+        std::string GetDescription() const;
+        std::vector<FirmwareSymbol> GetSymbols() const;
+        std::vector<FirmwareSegment> GetSegments() const;
+    };
+
+    const char* SectionTypeToString(SectionType type);
+}
+
+#endif // VM_FIRMWARE_FORMAT_H
@@ -2,11 +2,15 @@
 // Created by Jean-Michel Frouin on 17/08/2025.
 //
 #include "firmware_loader.h"
+#include "firmware_codec.h"
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <chrono>
 #include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <sstream>
 
 namespace vm {
     bool FirmwareLoader::SaveFirmware(const std::string& filename,
@@ -50,62 +54,224 @@ namespace vm {
         }
     }
 
-    bool FirmwareLoader::LoadFirmware(const std::string& filename,
-                                    std::vector<uint64_t>& instructions) {
-        std::ifstream file(filename, std::ios::binary);
+    bool FirmwareLoader::SaveFirmwareV2(const std::string& filename, const FirmwareImage& image,
+                                        bool compressCode) {
+        if (image.code.empty()) {
+            std::cerr << "Error: Firmware image has no code" << std::endl;
+            return false;
+        }
+
+        // Variable-length sections are serialized up front so that every payload is a flat byte range
+        std::vector<uint8_t> symbolBytes;
+        for (const auto& symbol : image.symbols) {
+            FirmwareSymbolRecord record{symbol.address, static_cast<uint32_t>(symbol.name.size()), 0};
+            const uint8_t* raw = reinterpret_cast<const uint8_t*>(&record);
+            symbolBytes.insert(symbolBytes.end(), raw, raw + sizeof(record));
+            symbolBytes.insert(symbolBytes.end(), symbol.name.begin(), symbol.name.end());
+            symbolBytes.resize((symbolBytes.size() + 7) & ~size_t(7), 0);
+        }
+
+        std::vector<FirmwareSegmentRecord> layoutRecords;
+        for (const auto& segment : image.segments) {
+            FirmwareSegmentRecord record{};
+            record.mBase = segment.base;
+            record.mSize = segment.size;
+            record.mPermissions = static_cast<uint32_t>(segment.permissions);
+            std::strncpy(record.mName, segment.name.c_str(), sizeof(record.mName) - 1);
+            layoutRecords.push_back(record);
+        }
+
+        std::vector<FirmwareSection> sections;
+        std::vector<const void*> payloads;
+        auto addSection = [&](SectionType type, const void* data, uint64_t size, uint64_t loadAddress) {
+            FirmwareSection section;
+            section.mType = static_cast<uint32_t>(type);
+            section.mFileSize = size;
+            section.mMemorySize = size;
+            section.mLoadAddress = loadAddress;
+            section.mChecksum = FirmwareChecksum(data, size);
+            sections.push_back(section);
+            payloads.push_back(data);
+        };
+
+        uint64_t codeSize = image.code.size() * sizeof(uint64_t);
+        std::vector<uint8_t> compressed;
+        if (compressCode) {
+            compressed = CompressCode(image.code.data(), image.code.size());
+        }
+        if (compressCode && compressed.size() < codeSize) {
+            addSection(SectionType::CODE, compressed.data(), compressed.size(), image.codeAddress);
+            sections.back().mFlags |= SECTION_FLAG_COMPRESSED;
+            sections.back().mMemorySize = codeSize;
+        } else {
+            addSection(SectionType::CODE, image.code.data(), codeSize, image.codeAddress);
+        }
+        if (!image.data.empty()) {
+            addSection(SectionType::DATA, image.data.data(), image.data.size(), image.dataAddress);
+        }
+        if (!symbolBytes.empty()) {
+            addSection(SectionType::SYMBOLS, symbolBytes.data(), symbolBytes.size(), 0);
+        }
+        if (!layoutRecords.empty()) {
+            addSection(SectionType::LAYOUT, layoutRecords.data(),
+                       layoutRecords.size() * sizeof(FirmwareSegmentRecord), 0);
+        }
+        if (!image.description.empty()) {
+            addSection(SectionType::DESCRIPTION, image.description.data(), image.description.size(), 0);
+        }
+
+        FirmwareHeaderV2 header;
+        header.mSectionCount = static_cast<uint32_t>(sections.size());
+        header.mHeaderSize = static_cast<uint32_t>(sizeof(header) + sections.size() * sizeof(FirmwareSection));
+        header.mEntryPoint = image.entryPoint;
+        header.mTimestamp = GetCurrentTimestamp();
+
+        uint64_t offset = header.mHeaderSize;
+        for (auto& section : sections) {
+            uint64_t alignment = SectionAlignment(section);
+            section.mOffset = (offset + alignment - 1) & ~(alignment - 1);
+            offset = section.mOffset + section.mFileSize;
+        }
+        header.mTableChecksum = FirmwareChecksum(sections.data(), sections.size() * sizeof(FirmwareSection));
+
+        std::ofstream file(filename, std::ios::binary);
         if (!file.is_open()) {
-            std::cerr << "Error: Cannot open firmware file: " << filename << std::endl;
+            std::cerr << "Error: Cannot create firmware file: " << filename << std::endl;
             return false;
         }
 
-        try {
-            FirmwareHeader header;
-            file.read(reinterpret_cast<char*>(&header), sizeof(FirmwareHeader));
-            
-            if (!file.good()) {
-                std::cerr << "Error: Cannot read firmware header" << std::endl;
-                return false;
-            }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(FirmwareSection));
 
-            if (!ValidateHeader(header)) {
-                std::cerr << "Error: Invalid firmware header" << std::endl;
-                return false;
-            }
+        uint64_t position = header.mHeaderSize;
+        const std::vector<char> padding(FIRMWARE_PAGE_SIZE, 0);
+        for (size_t i = 0; i < sections.size(); ++i) {
+            file.write(padding.data(), static_cast<std::streamsize>(sections[i].mOffset - position));
+            file.write(static_cast<const char*>(payloads[i]), static_cast<std::streamsize>(sections[i].mFileSize));
+            position = sections[i].mOffset + sections[i].mFileSize;
+        }
 
-            if (header.mDescriptionSize > 0) {
-                file.seekg(header.mDescriptionSize, std::ios::cur);
-            }
+        if (!file.good()) {
+            std::cerr << "Error writing firmware file: " << filename << std::endl;
+            return false;
+        }
 
-            instructions.clear();
-            instructions.reserve(header.mInstructionCount);
-
-            for (uint32_t i = 0; i < header.mInstructionCount; ++i) {
-                uint64_t instruction;
-                file.read(reinterpret_cast<char*>(&instruction), sizeof(uint64_t));
-                
-                if (!file.good()) {
-                    std::cerr << "Error: Cannot read instruction " << i << std::endl;
-                    return false;
-                }
-                
-                instructions.push_back(instruction);
-            }
+        std::cout << "Firmware saved successfully: " << filename << " (format v2)" << std::endl;
+        std::cout << "Instructions: " << image.code.size() << std::endl;
+        std::cout << "Entry point: 0x" << std::hex << image.entryPoint << std::dec << std::endl;
+        return true;
+    }
 
-            file.close();
-            
+    bool FirmwareLoader::LoadFirmware(const std::string& filename,
+                                    std::vector<uint64_t>& instructions,
+                                    bool verbose) {
+        FirmwareImage image;
+        if (!LoadFirmwareImage(filename, image, false)) {
+            return false;
+        }
+
+        instructions = std::move(image.code);
+
+        if (verbose) {
             std::cout << "Firmware loaded successfully: " << filename << std::endl;
             std::cout << "Instructions: " << instructions.size() << std::endl;
-            std::cout << "Entry point: 0x" << std::hex << header.mEntryPoint << std::endl;
-            
-            return true;
-        } catch (const std::exception& e) {
-            std::cerr << "Error reading firmware file: " << e.what() << std::endl;
-            file.close();
+            std::cout << "Entry point: 0x" << std::hex << image.entryPoint << std::endl;
+        }
+
+        return true;
+    }
+
+    bool FirmwareLoader::LoadFirmwareImage(const std::string& filename,
+                                         FirmwareImage& image,
+                                         bool verbose) {
+        MappedFirmware firmware;
+        if (!firmware.Open(filename) || !firmware.VerifyChecksums()) {
+            std::cerr << "Error: " << firmware.GetError() << " (" << filename << ")" << std::endl;
             return false;
         }
+
+        // A section may occupy more memory than it stores; the remainder is zero-filled
+        auto copySection = [&](const FirmwareSection& section, void* destination) {
+            std::memcpy(destination, firmware.GetSectionData(section),
+                        std::min(section.mFileSize, section.mMemorySize));
+        };
+
+        const FirmwareSection* code = firmware.FindSection(SectionType::CODE);
+        image.code.assign(code->mMemorySize / sizeof(uint64_t), 0);
+        if (code->mFlags & SECTION_FLAG_COMPRESSED) {
+            if (!DecompressCode(firmware.GetSectionData(*code), code->mFileSize, image.code.data(), image.code.size())) {
+                std::cerr << "Error: Corrupt compressed code section (" << filename << ")" << std::endl;
+                return false;
+            }
+        } else {
+            copySection(*code, image.code.data());
+        }
+        image.codeAddress = code->mLoadAddress;
+
+        image.data.clear();
+        if (const FirmwareSection* data = firmware.FindSection(SectionType::DATA)) {
+            image.data.assign(data->mMemorySize, 0);
+            copySection(*data, image.data.data());
+            image.dataAddress = data->mLoadAddress;
+        }
+
+        image.symbols = firmware.GetSymbols();
+        image.segments = firmware.GetSegments();
+        image.entryPoint = firmware.GetEntryPoint();
+        image.description = firmware.GetDescription();
+
+        if (verbose) {
+            std::cout << "Firmware loaded successfully: " << filename
+                      << " (format v" << firmware.GetVersion() << ")" << std::endl;
+            std::cout << "Instructions: " << image.code.size() << std::endl;
+            std::cout << "Data: " << image.data.size() << " bytes" << std::endl;
+            std::cout << "Entry point: 0x" << std::hex << image.entryPoint << std::dec << std::endl;
+        }
+
+        return true;
     }
 
     void FirmwareLoader::PrintFirmwareInfo(const std::string& filename) {
+        if (GetFirmwareVersion(filename) == FIRMWARE_VERSION_2) {
+            MappedFirmware firmware;
+            if (!firmware.Open(filename)) {
+                std::cerr << "Error: " << firmware.GetError() << std::endl;
+                return;
+            }
+
+            std::cout << "=== Firmware Information ===" << std::endl;
+            std::cout << "File: " << filename << std::endl;
+            std::cout << "Version: " << firmware.GetVersion() << std::endl;
+            std::cout << "Entry Point: 0x" << std::hex << firmware.GetEntryPoint() << std::dec << std::endl;
+            std::cout << "Created: " << FormatTimestamp(firmware.GetTimestamp()) << std::endl;
+            std::cout << "Sections: " << firmware.GetSections().size() << std::endl;
+            for (const auto& section : firmware.GetSections()) {
+                std::cout << "  " << std::left << std::setw(12)
+                          << SectionTypeToString(static_cast<SectionType>(section.mType)) << std::right
+                          << " offset 0x" << std::hex << section.mOffset
+                          << " size " << std::dec << section.mFileSize
+                          << ((section.mFlags & SECTION_FLAG_COMPRESSED) ? " (compressed)" : "")
+                          << " load 0x" << std::hex << section.mLoadAddress
+                          << " checksum 0x" << std::setfill('0') << std::setw(16) << section.mChecksum
+                          << std::setfill(' ') << std::dec << std::endl;
+            }
+
+            const FirmwareSection* code = firmware.FindSection(SectionType::CODE);
+            if (code->mFlags & SECTION_FLAG_COMPRESSED) {
+                std::cout << "Code compression: " << code->mMemorySize << " -> " << code->mFileSize
+                          << " bytes (ratio " << std::fixed << std::setprecision(2)
+                          << static_cast<double>(code->mMemorySize) / static_cast<double>(code->mFileSize)
+                          << ":1)" << std::defaultfloat << std::endl;
+            }
+
+            std::string description = firmware.GetDescription();
+            if (!description.empty()) {
+                std::cout << "Description: " << description << std::endl;
+            }
+            std::cout << "Checksums: " << (firmware.VerifyChecksums() ? "OK" : firmware.GetError()) << std::endl;
+            return;
+        }
+
         std::ifstream file(filename, std::ios::binary);
         if (!file.is_open()) {
             std::cerr << "Error: unable to open file " << filename << std::endl;
@@ -120,49 +286,56 @@ namespace vm {
             return;
         }
 
-        // Read separator character for verification
-        char separator;
-        file.read(&separator, 1);
-        
+        // v1 has no separator: the description follows the header directly, then the code
+        std::string description(std::min<uint32_t>(header.mDescriptionSize, 10000), '\0');
+        file.read(description.data(), static_cast<std::streamsize>(description.size()));
+        description.resize(static_cast<size_t>(file.gcount()));
+
         std::cout << "=== Firmware Information ===" << std::endl;
         std::cout << "File: " << filename << std::endl;
-        std::cout << "Signature: " << std::string(header.mVersion, 4) << std::endl;
+        std::cout << "Signature: " << std::string(header.mMagic, strnlen(header.mMagic, sizeof(header.mMagic))) << std::endl;
         std::cout << "Version: " << header.mVersion << std::endl;
         std::cout << "Instructions: " << header.mInstructionCount << std::endl;
-        std::cout << "Entry Point: " << header.mEntryPoint << std::endl;
+        std::cout << "Entry Point: 0x" << std::hex << header.mEntryPoint << std::dec << std::endl;
+        std::cout << "Created: " << FormatTimestamp(header.mTimestamp) << std::endl;
         std::cout << "Description Size: " << header.mDescriptionSize << std::endl;
-        
-        if (file.gcount() == 1 && separator == '|') {
-            std::cout << "Separator: Found ('|')" << std::endl;
-        } else {
-            std::cout << "Separator: Missing or invalid" << std::endl;
+        if (!description.empty()) {
+            std::cout << "Description: " << description << std::endl;
         }
 
         file.close();
     }
 
-    bool FirmwareLoader::ValidateHeader(const FirmwareHeader& header) {
-        // Vérifier la signature magique
-        if (std::memcmp(header.mMagic, "VMFW001", 7) != 0) {
-            return false;
-        }
-
-        // Vérifier la version (on supporte seulement la version 1 pour l'instant)
-        if (header.mVersion != 1) {
-            return false;
-        }
+    bool FirmwareLoader::IsValidFirmware(const std::string& filename) {
+        MappedFirmware firmware;
+        return firmware.Open(filename) && firmware.VerifyChecksums();
+    }
 
-        // Vérifier que le nombre d'instructions est raisonnable
-        if (header.mInstructionCount == 0 || header.mInstructionCount > 1000000) {
-            return false;
+    uint32_t FirmwareLoader::GetFirmwareVersion(const std::string& filename) {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            return 0;
         }
 
-        // Vérifier que la taille de description est raisonnable
-        if (header.mDescriptionSize > 10000) {
-            return false;
+        FirmwareHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(FirmwareHeader));
+        if (!file.good() || std::memcmp(header.mMagic, "VMFW", 4) != 0) {
+            return 0;
         }
+        return header.mVersion;
+    }
 
-        return true;
+    std::string FirmwareLoader::FormatTimestamp(uint64_t timestamp) {
+        std::time_t time = static_cast<std::time_t>(timestamp);
+        std::tm parts{};
+#ifdef _WIN32
+        localtime_s(&parts, &time);
+#else
+        localtime_r(&time, &parts);
+#endif
+        std::ostringstream stream;
+        stream << std::put_time(&parts, "%Y-%m-%d %H:%M:%S");
+        return stream.str();
     }
 
     uint64_t FirmwareLoader::GetCurrentTimestamp() {
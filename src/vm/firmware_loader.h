@@ -5,7 +5,9 @@
 #define VM_FIRMWARE_LOADER_H
 
 #include <common/types.h>
+#include <vm/firmware_format.h>
 #include <string>
+#include <cstring>
 #include <vector>
 
 namespace vm {
@@ -32,10 +34,20 @@ namespace vm {
                                 const std::vector<uint64_t>& instructions,
                                 const std::string& description = "",
                                 uint64_t entryPoint = 0);
+
+        // Save a firmware in the sectioned v2 format, optionally with a compressed CODE section
+        static bool SaveFirmwareV2(const std::string& filename, const FirmwareImage& image,
+                                   bool compressCode = false);
         
-        // Load a firmware
+        // Load a firmware (v1 or v2, code only)
         static bool LoadFirmware(const std::string& filename,
-                               std::vector<uint64_t>& instructions);
+                               std::vector<uint64_t>& instructions,
+                               bool verbose = true);
+
+        // Load every section of a firmware (v1 or v2)
+        static bool LoadFirmwareImage(const std::string& filename,
+                                      FirmwareImage& image,
+                                      bool verbose = true);
         
         // Display firmware information
         static void PrintFirmwareInfo(const std::string& filename);
@@ -48,7 +60,6 @@ namespace vm {
 
     private:
         // Private utility methods
-        static bool ValidateHeader(const FirmwareHeader& header);
         static std::string FormatTimestamp(uint64_t timestamp);
         static uint64_t GetCurrentTimestamp();
     };
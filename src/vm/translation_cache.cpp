@@ -0,0 +1,161 @@
+// src/vm/translation_cache.cpp
+#include "translation_cache.h"
+#include "firmware_format.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define VM_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vm {
+    namespace {
+        bool HeaderMatches(const TranslationCacheHeader& header, uint64_t key, uint64_t base, size_t count) {
+            return std::memcmp(header.mMagic, "VMTC001", 8) == 0 &&
+                   header.mFormat == TRANSLATION_CACHE_FORMAT &&
+                   header.mVmVersion == VM_VERSION &&
+                   header.mEntrySize == sizeof(DecodedInstruction) &&
+                   header.mKey == key && header.mCodeBase == base && header.mCount == count;
+        }
+
+        // Entries the CPU can execute without indexing past its registers or the entry
+        // array: ExecuteBlock trusts blockLength of any entry flagged as a verified block
+        bool EntriesInRange(const DecodedInstruction* entries, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                const DecodedInstruction& entry = entries[i];
+                if (entry.instr.reg1 >= REGISTER_COUNT || entry.instr.reg2 >= REGISTER_COUNT) {
+                    return false;
+                }
+                if ((entry.flags & DECODED_VERIFIED_BLOCK) &&
+                    (!(entry.flags & DECODED_BLOCK_START) || entry.blockLength == 0 || entry.blockLength > count - i)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    TranslationCache::TranslationCache(const std::string& directory) : mDirectory(directory) {
+    }
+
+    uint64_t TranslationCache::ComputeKey(const uint8_t* code, uint64_t size, uint64_t base) {
+        uint64_t parts[4] = {
+            FirmwareChecksum(code, size),
+            base,
+            VM_VERSION,
+            TRANSLATION_CACHE_FORMAT
+        };
+        return FirmwareChecksum(parts, sizeof(parts));
+    }
+
+    std::string TranslationCache::GetPath(uint64_t key) const {
+        std::ostringstream name;
+        name << std::hex << std::setfill('0') << std::setw(16) << key << ".vmtc";
+        return (std::filesystem::path(mDirectory) / name.str()).string();
+    }
+
+    std::shared_ptr<const DecodedInstruction> TranslationCache::Load(uint64_t key, uint64_t base, size_t count) const {
+        std::string path = GetPath(key);
+        uint64_t expectedSize = sizeof(TranslationCacheHeader) + count * sizeof(DecodedInstruction);
+
+#ifdef VM_HAVE_MMAP
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return nullptr;
+        }
+
+        struct stat info{};
+        void* mapping = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && static_cast<uint64_t>(info.st_size) == expectedSize) {
+            mapping = mmap(nullptr, expectedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            return nullptr;
+        }
+
+        std::shared_ptr<const uint8_t> file(static_cast<const uint8_t*>(mapping), [expectedSize](const uint8_t* data) {
+            munmap(const_cast<uint8_t*>(data), expectedSize);
+        });
+#else
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream.is_open()) {
+            return nullptr;
+        }
+        std::shared_ptr<uint8_t> buffer(new uint8_t[expectedSize], std::default_delete<uint8_t[]>());
+        stream.read(reinterpret_cast<char*>(buffer.get()), static_cast<std::streamsize>(expectedSize));
+        if (stream.gcount() != static_cast<std::streamsize>(expectedSize) || stream.peek() != EOF) {
+            return nullptr;
+        }
+        std::shared_ptr<const uint8_t> file = buffer;
+#endif
+
+        TranslationCacheHeader header;
+        std::memcpy(&header, file.get(), sizeof(header));
+        if (!HeaderMatches(header, key, base, count)) {
+            return nullptr;
+        }
+
+        const auto* entries = reinterpret_cast<const DecodedInstruction*>(file.get() + sizeof(header));
+        if (FirmwareChecksum(entries, count * sizeof(DecodedInstruction)) != header.mEntryChecksum ||
+            !EntriesInRange(entries, count)) {
+            return nullptr;
+        }
+
+        // Aliasing constructor: points at the entries, owns the whole file
+        return std::shared_ptr<const DecodedInstruction>(file, entries);
+    }
+
+    bool TranslationCache::Store(uint64_t key, const DecodeCache& cache) const {
+        std::error_code error;
+        std::filesystem::create_directories(mDirectory, error);
+
+        TranslationCacheHeader header{};
+        std::memcpy(header.mMagic, "VMTC001", 8);
+        header.mFormat = TRANSLATION_CACHE_FORMAT;
+        header.mVmVersion = VM_VERSION;
+        header.mKey = key;
+        header.mCodeBase = cache.GetBase();
+        header.mCount = cache.GetCount();
+        header.mEntrySize = sizeof(DecodedInstruction);
+        header.mEntryChecksum = FirmwareChecksum(cache.GetEntries(), cache.GetCount() * sizeof(DecodedInstruction));
+
+        std::string path = GetPath(key);
+        std::ostringstream temporary;
+        temporary << path << ".tmp" << std::hex
+                  << std::hash<std::thread::id>{}(std::this_thread::get_id())
+                  << std::chrono::steady_clock::now().time_since_epoch().count();
+
+        {
+            std::ofstream file(temporary.str(), std::ios::binary);
+            if (!file.is_open()) {
+                return false;
+            }
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(cache.GetEntries()),
+                       static_cast<std::streamsize>(cache.GetCount() * sizeof(DecodedInstruction)));
+            if (!file.good()) {
+                file.close();
+                std::filesystem::remove(temporary.str(), error);
+                return false;
+            }
+        }
+
+        std::filesystem::rename(temporary.str(), path, error);
+        if (error) {
+            std::filesystem::remove(temporary.str(), error);
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,51 @@
+// src/vm/translation_cache.h
+#ifndef VM_TRANSLATION_CACHE_H
+#define VM_TRANSLATION_CACHE_H
+
+#include <common/types.h>
+#include <cpu/decode_cache.h>
+#include <memory>
+#include <string>
+
+namespace vm {
+    // Bumped whenever DecodedInstruction or the file layout changes
+    constexpr uint32_t TRANSLATION_CACHE_FORMAT = 3;
+
+    struct TranslationCacheHeader {
+        char mMagic[8];             // "VMTC001\0"
+        uint32_t mFormat;           // TRANSLATION_CACHE_FORMAT
+        uint32_t mVmVersion;        // VM_VERSION
+        uint64_t mKey;
+        uint64_t mCodeBase;
+        uint64_t mCount;            // DecodedInstruction entries following the header
+        uint32_t mEntrySize;
+        uint32_t mReserved;
+        uint64_t mEntryChecksum;    // FirmwareChecksum of the entries
+        uint8_t mPadding[8];
+    };
+    static_assert(sizeof(TranslationCacheHeader) == 64, "TranslationCacheHeader layout is part of the file format");
+
+    // Directory of decoded code streams, one <key>.vmtc file per distinct code image.
+    // The key covers the code bytes, their load address, the VM version and the cache
+    // format, so a stale entry is never picked up: it simply stops being looked up.
+    // Files are still untrusted input: a load checks the entry checksum (truncated or
+    // corrupted files) and that every register field and block stays in range.
+    class TranslationCache {
+    private:
+        std::string mDirectory;
+
+    public:
+        explicit TranslationCache(const std::string& directory);
+
+        static uint64_t ComputeKey(const uint8_t* code, uint64_t size, uint64_t base);
+        std::string GetPath(uint64_t key) const;
+
+        // Map a cached stream; nullptr on a miss or an unusable file
+        std::shared_ptr<const DecodedInstruction> Load(uint64_t key, uint64_t base, size_t count) const;
+
+        // Write a stream atomically (temporary file + rename), safe with concurrent writers
+        bool Store(uint64_t key, const DecodeCache& cache) const;
+    };
+}
+
+#endif // VM_TRANSLATION_CACHE_H
@@ -3,15 +3,22 @@
 //
 
 #include "vm.h"
+#include "firmware_codec.h"
+#include "firmware_format.h"
+#include "translation_cache.h"
+#include <analysis/verifier.h>
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <stdexcept>
 
 namespace vm {
     VirtualMachine::VirtualMachine(size_t memorySize) 
         : mMemory(std::make_unique<Memory>(memorySize))
         , mCPU(std::make_unique<CPU>(mMemory.get()))
         , mDebugMode(false)
-        , mRunning(false) {
+        , mRunning(false)
+        , mTranslationCacheHit(false) {
         InitializeSystem();
     }
 
@@ -23,6 +30,7 @@ namespace vm {
         mCPU->Reset();
         mMemory->Clear();
         mRunning = false;
+        mLastError.clear();
         
         if (mDebugMode) {
             std::cout << "Virtual Machine initialized with " 
@@ -63,11 +71,8 @@ namespace vm {
         }
 
         try {
-            for (size_t i = 0; i < program.size(); ++i) {
-                uint64_t address = startAddress + (i * 8);
-                mMemory->Write64(address, program[i]);
-            }
-
+            mMemory->WriteBlock(startAddress, program.data(), programSize);
+            PrepareDecodedCode(startAddress, programSize);
             mCPU->SetPC(startAddress);
             
             if (mDebugMode) {
@@ -79,6 +84,7 @@ namespace vm {
             
             return true;
         } catch (const std::exception& e) {
+            mLastError = e.what();
             if (mDebugMode) {
                 std::cerr << "Error loading program: " << e.what() << std::endl;
             }
@@ -86,6 +92,155 @@ namespace vm {
         }
     }
 
+    void VirtualMachine::LoadCompressedSection(const MappedFirmware& firmware, const FirmwareSection& section) {
+        // Block by block: the scratch buffer stays cache resident whatever the image size
+        CodeDecompressor decompressor(firmware.GetSectionData(section), section.mFileSize);
+        std::vector<uint64_t> block(CODEC_BLOCK_INSTRUCTIONS);
+        uint64_t address = section.mLoadAddress;
+        uint64_t end = section.mLoadAddress + section.mMemorySize;
+
+        while (size_t count = decompressor.NextBlock(block.data())) {
+            uint64_t bytes = count * sizeof(uint64_t);
+            if (bytes > end - address) {
+                throw std::runtime_error("Compressed code section is larger than declared");
+            }
+            mMemory->WriteBlock(address, block.data(), bytes);
+            address += bytes;
+        }
+
+        if (decompressor.HasError() || address != end) {
+            throw std::runtime_error(decompressor.HasError() ? decompressor.GetError()
+                                                             : "Compressed code section is truncated");
+        }
+    }
+
+    bool VirtualMachine::LoadFirmware(const std::string& filename, bool verifyChecksums) {
+        MappedFirmware firmware;
+        if (!firmware.Open(filename) || (verifyChecksums && !firmware.VerifyChecksums())) {
+            mLastError = firmware.GetError();
+            if (mDebugMode) {
+                std::cerr << "Error loading firmware: " << mLastError << std::endl;
+            }
+            return false;
+        }
+        return LoadFirmware(firmware, filename);
+    }
+
+    bool VirtualMachine::LoadFirmware(const MappedFirmware& firmware, const std::string& name) {
+        try {
+            // Sections are loaded against the default layout; the image's own layout
+            // (if any) takes effect once its contents are in place
+            mMemory->SetDefaultSegments();
+
+            uint64_t codeBytes = 0;
+            uint64_t codeBase = 0;
+            for (const auto& section : firmware.GetSections()) {
+                SectionType type = static_cast<SectionType>(section.mType);
+                if (type != SectionType::CODE && type != SectionType::DATA) {
+                    continue;
+                }
+
+                if (section.mFlags & SECTION_FLAG_COMPRESSED) {
+                    LoadCompressedSection(firmware, section);
+                } else {
+                    uint64_t stored = std::min(section.mFileSize, section.mMemorySize);
+                    if (firmware.GetFileDescriptor() < 0 ||
+                        !mMemory->LoadFromFile(firmware.GetFileDescriptor(), section.mOffset,
+                                               section.mLoadAddress, stored)) {
+                        mMemory->WriteBlock(section.mLoadAddress, firmware.GetSectionData(section), stored);
+                    }
+                    mMemory->FillBlock(section.mLoadAddress + stored, 0, section.mMemorySize - stored);
+                }
+
+                if (type == SectionType::CODE) {
+                    codeBytes = section.mMemorySize;
+                    codeBase = section.mLoadAddress;
+                }
+            }
+
+            std::vector<FirmwareSegment> layout = firmware.GetSegments();
+            if (!layout.empty()) {
+                std::vector<MemorySegment> segments;
+                for (const auto& segment : layout) {
+                    if (segment.base > mMemory->GetSize() || segment.size > mMemory->GetSize() - segment.base) {
+                        throw std::runtime_error("Segment " + segment.name + " does not fit in guest memory");
+                    }
+                    segments.emplace_back(segment.base, segment.size, segment.permissions, segment.name);
+                }
+                mMemory->SetSegments(segments);
+            }
+
+            PrepareDecodedCode(codeBase, codeBytes);
+
+            if (firmware.GetEntryPoint() >= mMemory->GetSize()) {
+                throw std::runtime_error("Entry point outside guest memory");
+            }
+            mCPU->SetPC(firmware.GetEntryPoint());
+
+            if (mDebugMode) {
+                std::cout << "Firmware loaded successfully: " << name
+                          << " (format v" << firmware.GetVersion() << ")" << std::endl;
+                std::cout << "Program size: " << std::dec << codeBytes / 8
+                          << " instructions (" << codeBytes << " bytes)" << std::endl;
+                std::cout << "Entry point: 0x" << std::hex << firmware.GetEntryPoint() << std::dec << std::endl;
+            }
+            return true;
+        } catch (const std::exception& e) {
+            mLastError = e.what();
+            if (mDebugMode) {
+                std::cerr << "Error loading firmware: " << e.what() << std::endl;
+            }
+            return false;
+        }
+    }
+
+    void VirtualMachine::PrepareDecodedCode(uint64_t base, uint64_t size) {
+        size_t count = static_cast<size_t>(size / sizeof(uint64_t));
+        mTranslationCacheHit = false;
+        if (mTranslationCacheDir.empty()) {
+            mCPU->DecodeCode(base, count);
+            VerifyDecodedCode(base, count);
+            return;
+        }
+
+        TranslationCache cache(mTranslationCacheDir);
+        uint64_t key = TranslationCache::ComputeKey(mMemory->GetSpan(base, size, AccessType::READ), size, base);
+        if (auto entries = cache.Load(key, base, count)) {
+            // Block flags were verified before the file was stored; Load() rejects files
+            // whose checksum or block bounds do not hold
+            mCPU->AttachDecodedCode(std::move(entries), base, count);
+            mTranslationCacheHit = true;
+        } else {
+            mCPU->DecodeCode(base, count);
+            VerifyDecodedCode(base, count);
+            if (!cache.Store(key, mCPU->GetDecodeCache()) && mDebugMode) {
+                std::cerr << "Warning: Cannot write translation cache " << cache.GetPath(key) << std::endl;
+            }
+        }
+
+        if (mDebugMode) {
+            std::cout << "Translation cache " << (mTranslationCacheHit ? "hit: " : "miss: ")
+                      << cache.GetPath(key) << std::endl;
+        }
+    }
+
+    void VirtualMachine::VerifyDecodedCode(uint64_t base, size_t count) {
+        // Code is loaded at an 8-byte aligned address, so the span can be read as words
+        const uint8_t* bytes = mMemory->GetSpan(base, count * sizeof(uint64_t), AccessType::READ);
+        VerificationReport report = FirmwareVerifier::Verify(reinterpret_cast<const uint64_t*>(bytes), count, base);
+        DecodeCache& cache = mCPU->GetDecodeCache();
+        for (const auto& block : report.blocks) {
+            cache.MarkBlock(block.start, block.length, block.verified);
+        }
+
+        if (mDebugMode) {
+            std::cout << "Verified blocks: " << report.verifiedBlocks << "/" << report.blocks.size() << std::endl;
+            for (const auto& issue : report.issues) {
+                std::cout << "  0x" << std::hex << issue.address << std::dec << ": " << issue.message << std::endl;
+            }
+        }
+    }
+
     void VirtualMachine::Run() {
         if (!mMemory || !mCPU) {
             if (mDebugMode) {
@@ -104,6 +259,7 @@ namespace vm {
             mCPU->EnableDebug(mDebugMode);
             mCPU->Run();
         } catch (const std::exception& e) {
+            mLastError = e.what();
             if (mDebugMode) {
                 std::cerr << "Runtime error: " << e.what() << std::endl;
             }
@@ -134,6 +290,7 @@ namespace vm {
             mCPU->Step();
             mRunning = mCPU->IsRunning();
         } catch (const std::exception& e) {
+            mLastError = e.what();
             if (mDebugMode) {
                 std::cerr << "Runtime error: " << e.what() << std::endl;
             }
@@ -171,6 +328,8 @@ namespace vm {
         std::cout << "Running: " << (mRunning ? "Yes" : "No") << std::endl;
         std::cout << "Debug Mode: " << (mDebugMode ? "Enabled" : "Disabled") << std::endl;
         std::cout << "Memory Size: " << mMemory->GetSize() << " bytes" << std::endl;
+        std::cout << "Instructions retired: " << std::dec << GetCounter(CounterType::INSTRUCTIONS)
+                  << " (" << GetCounter(CounterType::CYCLES) << " cycles)" << std::endl;
         
         mCPU->PrintState();
         std::cout << "=============================" << std::endl;
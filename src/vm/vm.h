@@ -7,18 +7,28 @@
 #include <cpu/cpu.h>
 #include <vector>
 #include <memory>
+#include <string>
 
 namespace vm {
+    class MappedFirmware;
+    struct FirmwareSection;
+
     class VirtualMachine {
     private:
         std::unique_ptr<Memory> mMemory;
         std::unique_ptr<CPU> mCPU;
         bool mDebugMode;
         bool mRunning;
+        std::string mLastError;   // Message of the last runtime/load error
+        std::string mTranslationCacheDir; // Empty: decode in memory only
+        bool mTranslationCacheHit;
 
         // Private methods
         void InitializeSystem();
         void Shutdown();
+        void LoadCompressedSection(const MappedFirmware& firmware, const FirmwareSection& section);
+        void PrepareDecodedCode(uint64_t base, uint64_t size);
+        void VerifyDecodedCode(uint64_t base, size_t count);
 
     public:
         VirtualMachine(size_t memorySize = 1024 * 1024); // 1MB by default
@@ -26,6 +36,10 @@ namespace vm {
 
         // Lifecycle management
         bool LoadProgram(const std::vector<uint64_t>& program, uint64_t startAddress = 0);
+        // Map (v2) or read (v1) a firmware file straight into guest memory and jump to its entry point
+        bool LoadFirmware(const std::string& filename, bool verifyChecksums = true);
+        // Same from an image opened by the caller (file or memory); checksums are the caller's call
+        bool LoadFirmware(const MappedFirmware& firmware, const std::string& name = "<memory>");
         void Run();
         void Step();
         void Stop();
@@ -42,6 +56,21 @@ namespace vm {
         void EnableStepByStep(bool enable = true);
         bool IsDebugging() const { return mDebugMode; }
         bool IsRunning() const { return mRunning; }
+        const std::string& GetLastError() const { return mLastError; }
+        const PerformanceCounters& GetCounters() const { return mCPU->GetCounters(); }
+        uint64_t GetCounter(CounterType type) const { return mCPU->GetCounter(type); }
+        void SetClockMode(ClockMode mode) { mCPU->SetClockMode(mode); }
+        ClockMode GetClockMode() const { return mCPU->GetClock().GetMode(); }
+        void SetInstructionLimit(uint64_t limit) { mCPU->SetInstructionLimit(limit); }
+        bool ReachedInstructionLimit() const { return mCPU->ReachedInstructionLimit(); }
+        void SetTranslationCacheDirectory(const std::string& directory) { mTranslationCacheDir = directory; }
+        bool WasTranslationCacheHit() const { return mTranslationCacheHit; }
+
+        // Native functions for HCALL <index>; registrations survive Reset() and reloads
+        bool RegisterHostFunction(uint32_t index, const std::string& name, HostFunction function, void* context = nullptr) {
+            return mCPU->GetHostCalls().Register(index, name, function, context);
+        }
+        void UnregisterHostFunction(uint32_t index) { mCPU->GetHostCalls().Unregister(index); }
         void PrintState() const;
         void DumpMemory(uint64_t start, uint64_t length) const;
 
@@ -0,0 +1,438 @@
+// src/workloads/workloads.cpp
+#include "workloads.h"
+#include <common/instruction.h>
+#include <map>
+#include <stdexcept>
+
+namespace vm {
+    namespace {
+        constexpr uint64_t HEAP_BASE = 0x200000;
+        constexpr uint64_t HEAP_SIZE = 0x100000;
+
+        // 64-bit LCG (Knuth MMIX constants), replicated on the host to compute expected results
+        constexpr uint64_t LCG_MULTIPLIER = 6364136223846793005ULL;
+        constexpr uint64_t LCG_INCREMENT = 1442695040888963407ULL;
+        constexpr uint64_t LCG_SEED = 0x2545F4914F6CDD1DULL;
+
+        // Registers reserved by the helpers below
+        constexpr uint8_t R_CHECK = 14;
+
+        // Emits instructions with symbolic jump targets, resolved by Finish()
+        class ProgramBuilder {
+        private:
+            std::vector<uint64_t> mCode;
+            std::map<std::string, uint64_t> mLabels;
+            std::vector<std::pair<size_t, std::string>> mFixups;
+
+        public:
+            void Emit(Opcode opcode, AddressingMode mode, uint8_t reg1, uint8_t reg2 = 0, uint32_t immediate = 0) {
+                mCode.push_back(makeInstruction(opcode, mode, reg1, reg2, immediate));
+            }
+
+            // reg = reg2
+            void Reg(Opcode opcode, uint8_t reg1, uint8_t reg2) {
+                Emit(opcode, AddressingMode::REGISTER, reg1, reg2, 0);
+            }
+
+            // reg = reg op immediate
+            void Imm(Opcode opcode, uint8_t reg1, uint32_t immediate) {
+                Emit(opcode, AddressingMode::IMMEDIATE, reg1, 0, immediate);
+            }
+
+            // Jump, call or loop to a label (reg1 is the LOOP counter)
+            void Jump(Opcode opcode, const std::string& label, uint8_t reg1 = 0) {
+                mFixups.emplace_back(mCode.size(), label);
+                Emit(opcode, AddressingMode::IMMEDIATE, reg1, 0, 0);
+            }
+
+            void Label(const std::string& name) {
+                mLabels[name] = mCode.size() * 8;
+            }
+
+            // Load an arbitrary 64-bit constant (immediates are 32 bits wide)
+            void LoadConstant(uint8_t reg, uint64_t value) {
+                if ((value >> 32) == 0) {
+                    Imm(Opcode::MOV, reg, static_cast<uint32_t>(value));
+                    return;
+                }
+                Imm(Opcode::MOV, reg, static_cast<uint32_t>(value >> 32));
+                Imm(Opcode::SHL, reg, 32);
+                Imm(Opcode::OR, reg, static_cast<uint32_t>(value));
+            }
+
+            // Compare reg with the host-computed value and publish the status
+            void CheckAndHalt(uint8_t reg, uint64_t expected) {
+                LoadConstant(R_CHECK, expected);
+                Reg(Opcode::CMP, reg, R_CHECK);
+                Jump(Opcode::JNE, "fail");
+                Imm(Opcode::MOV, WORKLOAD_STATUS_REGISTER, static_cast<uint32_t>(WORKLOAD_PASS));
+                Emit(Opcode::HLT, AddressingMode::REGISTER, 0);
+                Label("fail");
+                Imm(Opcode::MOV, WORKLOAD_STATUS_REGISTER, static_cast<uint32_t>(WORKLOAD_FAIL));
+                Emit(Opcode::HLT, AddressingMode::REGISTER, 0);
+            }
+
+            std::vector<uint64_t> Finish() {
+                for (const auto& [index, label] : mFixups) {
+                    auto it = mLabels.find(label);
+                    if (it == mLabels.end()) {
+                        throw std::runtime_error("Undefined workload label: " + label);
+                    }
+                    mCode[index] |= it->second;
+                }
+                return mCode;
+            }
+        };
+
+        uint64_t NextRandom(uint64_t& state) {
+            state = state * LCG_MULTIPLIER + LCG_INCREMENT;
+            return state;
+        }
+
+        // Guest side of NextRandom: state in R8, multiplier in R9, increment in R10
+        void EmitRandomSetup(ProgramBuilder& b) {
+            b.LoadConstant(8, LCG_SEED);
+            b.LoadConstant(9, LCG_MULTIPLIER);
+            b.LoadConstant(10, LCG_INCREMENT);
+        }
+
+        void EmitNextRandom(ProgramBuilder& b) {
+            b.Reg(Opcode::MUL, 8, 9);
+            b.Reg(Opcode::ADD, 8, 10);
+        }
+    }
+
+    std::vector<uint64_t> createMemoryStreamWorkload(uint32_t scale) {
+        const uint64_t words = HEAP_SIZE / 8;
+        const uint64_t passes = 8ULL * scale;
+        ProgramBuilder b;
+
+        // a[i] = i over the whole HEAP segment
+        b.Imm(Opcode::MOV, 3, HEAP_BASE);
+        b.Imm(Opcode::MOV, 1, words);
+        b.Imm(Opcode::MOV, 4, 0);
+        b.Label("fill");
+        b.Reg(Opcode::STORE, 3, 4);
+        b.Reg(Opcode::INC, 4, 0);
+        b.Imm(Opcode::ADD, 3, 8);
+        b.Jump(Opcode::LOOP, "fill", 1);
+
+        // Sum the array 'passes' times
+        b.Imm(Opcode::MOV, 0, 0);
+        b.Imm(Opcode::MOV, 5, passes);
+        b.Label("pass");
+        b.Imm(Opcode::MOV, 3, HEAP_BASE);
+        b.Imm(Opcode::MOV, 1, words);
+        b.Label("sum");
+        b.Reg(Opcode::LOAD, 2, 3);
+        b.Reg(Opcode::ADD, 0, 2);
+        b.Imm(Opcode::ADD, 3, 8);
+        b.Jump(Opcode::LOOP, "sum", 1);
+        b.Reg(Opcode::DEC, 5, 0);
+        b.Jump(Opcode::JNZ, "pass");
+
+        b.CheckAndHalt(0, passes * (words * (words - 1) / 2));
+        return b.Finish();
+    }
+
+    std::vector<uint64_t> createPointerChaseWorkload(uint32_t scale) {
+        // next(i) = (A * i + C) mod n is a single full-length cycle (n power of two,
+        // A = 1 mod 4, C odd), so the walk visits every node in a scattered order
+        const uint64_t nodes = 65536;
+        const uint64_t multiplier = 1664525;
+        const uint64_t increment = 1013904223;
+        const uint64_t stepsPerRound = nodes * 8;
+        ProgramBuilder b;
+
+        b.Imm(Opcode::MOV, 3, HEAP_BASE);
+        b.Imm(Opcode::MOV, 4, 0);
+        b.Imm(Opcode::MOV, 1, nodes);
+        b.Label("build");
+        b.Reg(Opcode::MOV, 5, 4);
+        b.Imm(Opcode::MUL, 5, multiplier);
+        b.Imm(Opcode::ADD, 5, increment);
+        b.Imm(Opcode::AND, 5, nodes - 1);
+        b.Imm(Opcode::SHL, 5, 3);
+        b.Imm(Opcode::ADD, 5, HEAP_BASE);
+        b.Reg(Opcode::STORE, 3, 5);
+        b.Imm(Opcode::ADD, 3, 8);
+        b.Reg(Opcode::INC, 4, 0);
+        b.Jump(Opcode::LOOP, "build", 1);
+
+        b.Imm(Opcode::MOV, 0, 0);
+        b.Imm(Opcode::MOV, 3, HEAP_BASE);
+        b.Imm(Opcode::MOV, 6, scale);
+        b.Label("round");
+        b.Imm(Opcode::MOV, 1, stepsPerRound);
+        b.Label("walk");
+        b.Reg(Opcode::LOAD, 3, 3);
+        b.Reg(Opcode::ADD, 0, 3);
+        b.Jump(Opcode::LOOP, "walk", 1);
+        b.Reg(Opcode::DEC, 6, 0);
+        b.Jump(Opcode::JNZ, "round");
+
+        uint64_t expected = 0;
+        uint64_t node = 0;
+        for (uint64_t step = 0; step < stepsPerRound * scale; ++step) {
+            node = (multiplier * node + increment) & (nodes - 1);
+            expected += HEAP_BASE + node * 8;
+        }
+
+        b.CheckAndHalt(0, expected);
+        return b.Finish();
+    }
+
+    std::vector<uint64_t> createQuicksortWorkload(uint32_t scale) {
+        const uint64_t elements = 32768;
+        const uint64_t lastElement = HEAP_BASE + (elements - 1) * 8;
+        ProgramBuilder b;
+
+        EmitRandomSetup(b);
+        b.Imm(Opcode::MOV, 0, 0);
+        b.Imm(Opcode::MOV, 11, scale);
+
+        b.Label("round");
+        // Fill with 31-bit pseudo-random values (signed compares stay valid)
+        b.Imm(Opcode::MOV, 3, HEAP_BASE);
+        b.Imm(Opcode::MOV, 1, elements);
+        b.Label("fill");
+        EmitNextRandom(b);
+        b.Reg(Opcode::MOV, 4, 8);
+        b.Imm(Opcode::SHR, 4, 33);
+        b.Reg(Opcode::STORE, 3, 4);
+        b.Imm(Opcode::ADD, 3, 8);
+        b.Jump(Opcode::LOOP, "fill", 1);
+
+        b.Imm(Opcode::MOV, 1, HEAP_BASE);
+        b.Imm(Opcode::MOV, 2, lastElement);
+        b.Jump(Opcode::CALL, "qsort");
+
+        // Verify ordering and accumulate the checksum
+        b.Imm(Opcode::MOV, 3, HEAP_BASE);
+        b.Imm(Opcode::MOV, 1, elements - 1);
+        b.Reg(Opcode::LOAD, 4, 3);
+        b.Reg(Opcode::ADD, 0, 4);
+        b.Label("verify");
+        b.Imm(Opcode::ADD, 3, 8);
+        b.Reg(Opcode::LOAD, 5, 3);
+        b.Reg(Opcode::ADD, 0, 5);
+        b.Reg(Opcode::CMP, 4, 5);
+        b.Jump(Opcode::JG, "fail");
+        b.Reg(Opcode::MOV, 4, 5);
+        b.Jump(Opcode::LOOP, "verify", 1);
+
+        b.Reg(Opcode::DEC, 11, 0);
+        b.Jump(Opcode::JNZ, "round");
+
+        uint64_t expected = 0;
+        uint64_t state = LCG_SEED;
+        for (uint64_t i = 0; i < elements * scale; ++i) {
+            expected += NextRandom(state) >> 33;
+        }
+        b.CheckAndHalt(0, expected);
+
+        // qsort(R1 = address of first element, R2 = address of last element), Lomuto partition.
+        // Clobbers R1-R7.
+        b.Label("qsort");
+        b.Reg(Opcode::CMP, 1, 2);
+        b.Jump(Opcode::JGE, "qsort_ret");
+        b.Reg(Opcode::LOAD, 3, 2);          // pivot = a[hi]
+        b.Reg(Opcode::MOV, 4, 1);           // i = lo
+        b.Reg(Opcode::MOV, 5, 1);           // j = lo
+        b.Label("partition");
+        b.Reg(Opcode::CMP, 5, 2);
+        b.Jump(Opcode::JGE, "partition_done");
+        b.Reg(Opcode::LOAD, 6, 5);
+        b.Reg(Opcode::CMP, 6, 3);
+        b.Jump(Opcode::JGE, "partition_next");
+        b.Reg(Opcode::LOAD, 7, 4);          // swap a[i], a[j]
+        b.Reg(Opcode::STORE, 4, 6);
+        b.Reg(Opcode::STORE, 5, 7);
+        b.Imm(Opcode::ADD, 4, 8);
+        b.Label("partition_next");
+        b.Imm(Opcode::ADD, 5, 8);
+        b.Jump(Opcode::JMP, "partition");
+        b.Label("partition_done");
+        b.Reg(Opcode::LOAD, 7, 4);          // swap a[i], a[hi]
+        b.Reg(Opcode::STORE, 4, 3);
+        b.Reg(Opcode::STORE, 2, 7);
+        b.Reg(Opcode::PUSH, 2, 0);
+        b.Reg(Opcode::PUSH, 4, 0);
+        b.Reg(Opcode::MOV, 2, 4);           // qsort(lo, i - 1)
+        b.Imm(Opcode::SUB, 2, 8);
+        b.Jump(Opcode::CALL, "qsort");
+        b.Reg(Opcode::POP, 4, 0);
+        b.Reg(Opcode::POP, 2, 0);
+        b.Reg(Opcode::MOV, 1, 4);           // qsort(i + 1, hi)
+        b.Imm(Opcode::ADD, 1, 8);
+        b.Jump(Opcode::CALL, "qsort");
+        b.Label("qsort_ret");
+        b.Emit(Opcode::RET, AddressingMode::REGISTER, 0);
+
+        return b.Finish();
+    }
+
+    std::vector<uint64_t> createRecursionWorkload(uint32_t scale) {
+        const uint64_t depth = 50000;       // 16 bytes of stack per frame
+        const uint64_t repeats = 20ULL * scale;
+        ProgramBuilder b;
+
+        b.Imm(Opcode::MOV, 12, 0);
+        b.Imm(Opcode::MOV, 11, repeats);
+        b.Label("repeat");
+        b.Imm(Opcode::MOV, 1, depth);
+        b.Jump(Opcode::CALL, "sum_to");
+        b.Reg(Opcode::ADD, 12, 0);
+        b.Reg(Opcode::DEC, 11, 0);
+        b.Jump(Opcode::JNZ, "repeat");
+        b.CheckAndHalt(12, repeats * (depth * (depth + 1) / 2));
+
+        // R0 = sum_to(R1) = R1 + sum_to(R1 - 1)
+        b.Label("sum_to");
+        b.Imm(Opcode::CMP, 1, 0);
+        b.Jump(Opcode::JNZ, "sum_to_recurse");
+        b.Imm(Opcode::MOV, 0, 0);
+        b.Emit(Opcode::RET, AddressingMode::REGISTER, 0);
+        b.Label("sum_to_recurse");
+        b.Reg(Opcode::PUSH, 1, 0);
+        b.Reg(Opcode::DEC, 1, 0);
+        b.Jump(Opcode::CALL, "sum_to");
+        b.Reg(Opcode::POP, 1, 0);
+        b.Reg(Opcode::ADD, 0, 1);
+        b.Emit(Opcode::RET, AddressingMode::REGISTER, 0);
+
+        return b.Finish();
+    }
+
+    std::vector<uint64_t> createHashTableWorkload(uint32_t scale) {
+        // 65536 buckets of {key, value} fill the HEAP segment; ~69% load factor
+        const uint64_t buckets = HEAP_SIZE / 16;
+        const uint64_t keys = 45000;
+        const uint64_t passes = 4ULL * scale;
+        const uint32_t keyMultiplier = 0x9E3779B1;
+        const uint64_t hashMultiplier = 0xFF51AFD7ED558CCDULL;
+        ProgramBuilder b;
+
+        b.LoadConstant(12, hashMultiplier);
+
+        // Hash of the key in R5 into bucket index R6, bucket address in R7
+        auto emitHash = [&](const std::string& probeLabel) {
+            b.Reg(Opcode::MOV, 5, 4);
+            b.Imm(Opcode::MUL, 5, keyMultiplier);
+            b.Reg(Opcode::MOV, 6, 5);
+            b.Reg(Opcode::MUL, 6, 12);
+            b.Imm(Opcode::SHR, 6, 48);
+            b.Label(probeLabel);
+            b.Reg(Opcode::MOV, 7, 6);
+            b.Imm(Opcode::SHL, 7, 4);
+            b.Imm(Opcode::ADD, 7, HEAP_BASE);
+            b.Reg(Opcode::LOAD, 2, 7);
+        };
+
+        // Insert key(k) -> k for k = 1..keys, linear probing
+        b.Imm(Opcode::MOV, 4, 1);
+        b.Imm(Opcode::MOV, 1, keys);
+        b.Label("insert");
+        emitHash("insert_probe");
+        b.Imm(Opcode::CMP, 2, 0);
+        b.Jump(Opcode::JZ, "insert_slot");
+        b.Reg(Opcode::INC, 6, 0);
+        b.Imm(Opcode::AND, 6, buckets - 1);
+        b.Jump(Opcode::JMP, "insert_probe");
+        b.Label("insert_slot");
+        b.Reg(Opcode::STORE, 7, 5);
+        b.Imm(Opcode::ADD, 7, 8);
+        b.Reg(Opcode::STORE, 7, 4);
+        b.Reg(Opcode::INC, 4, 0);
+        b.Jump(Opcode::LOOP, "insert", 1);
+
+        // Look every key up 'passes' times and sum the values
+        b.Imm(Opcode::MOV, 0, 0);
+        b.Imm(Opcode::MOV, 11, passes);
+        b.Label("pass");
+        b.Imm(Opcode::MOV, 4, 1);
+        b.Imm(Opcode::MOV, 1, keys);
+        b.Label("lookup");
+        emitHash("lookup_probe");
+        b.Reg(Opcode::CMP, 2, 5);
+        b.Jump(Opcode::JZ, "lookup_found");
+        b.Imm(Opcode::CMP, 2, 0);
+        b.Jump(Opcode::JZ, "fail");         // Key missing
+        b.Reg(Opcode::INC, 6, 0);
+        b.Imm(Opcode::AND, 6, buckets - 1);
+        b.Jump(Opcode::JMP, "lookup_probe");
+        b.Label("lookup_found");
+        b.Imm(Opcode::ADD, 7, 8);
+        b.Reg(Opcode::LOAD, 2, 7);
+        b.Reg(Opcode::ADD, 0, 2);
+        b.Reg(Opcode::INC, 4, 0);
+        b.Jump(Opcode::LOOP, "lookup", 1);
+        b.Reg(Opcode::DEC, 11, 0);
+        b.Jump(Opcode::JNZ, "pass");
+
+        b.CheckAndHalt(0, passes * (keys * (keys + 1) / 2));
+        return b.Finish();
+    }
+
+    std::vector<uint64_t> createBranchStressWorkload(uint32_t scale) {
+        const uint64_t iterations = 1000000;
+        ProgramBuilder b;
+
+        EmitRandomSetup(b);
+        b.Imm(Opcode::MOV, 0, 0);
+        b.Imm(Opcode::MOV, 11, scale);
+        b.Label("round");
+        b.Imm(Opcode::MOV, 1, iterations);
+        b.Label("branch");
+        EmitNextRandom(b);
+        b.Reg(Opcode::MOV, 4, 8);
+        b.Imm(Opcode::SHR, 4, 40);
+        b.Imm(Opcode::AND, 4, 3);
+        b.Imm(Opcode::CMP, 4, 0);
+        b.Jump(Opcode::JZ, "case0");
+        b.Imm(Opcode::CMP, 4, 1);
+        b.Jump(Opcode::JZ, "case1");
+        b.Imm(Opcode::CMP, 4, 2);
+        b.Jump(Opcode::JZ, "case2");
+        b.Imm(Opcode::SUB, 0, 3);
+        b.Jump(Opcode::JMP, "next");
+        b.Label("case0");
+        b.Imm(Opcode::ADD, 0, 1);
+        b.Jump(Opcode::JMP, "next");
+        b.Label("case1");
+        b.Imm(Opcode::SHL, 0, 1);
+        b.Jump(Opcode::JMP, "next");
+        b.Label("case2");
+        b.Reg(Opcode::XOR, 0, 8);
+        b.Label("next");
+        b.Jump(Opcode::LOOP, "branch", 1);
+        b.Reg(Opcode::DEC, 11, 0);
+        b.Jump(Opcode::JNZ, "round");
+
+        uint64_t expected = 0;
+        uint64_t state = LCG_SEED;
+        for (uint64_t i = 0; i < iterations * scale; ++i) {
+            uint64_t value = NextRandom(state);
+            switch ((value >> 40) & 3) {
+                case 0: expected += 1; break;
+                case 1: expected <<= 1; break;
+                case 2: expected ^= value; break;
+                default: expected -= 3; break;
+            }
+        }
+
+        b.CheckAndHalt(0, expected);
+        return b.Finish();
+    }
+
+    std::vector<WorkloadProgram> getWorkloadCorpus() {
+        return {
+            {"memory_stream", "Sequential fill and summing of the HEAP segment", createMemoryStreamWorkload},
+            {"pointer_chase", "Linked-list walk through scattered HEAP nodes", createPointerChaseWorkload},
+            {"quicksort", "Recursive quicksort of 32768 elements in the HEAP segment", createQuicksortWorkload},
+            {"recursion", "Deep recursive CALL/RET chains (depth 50000)", createRecursionWorkload},
+            {"hash_table", "Open-addressing hash table inserts and lookups", createHashTableWorkload},
+            {"branch_stress", "Unpredictable data-dependent branches", createBranchStressWorkload}
+        };
+    }
+}
@@ -0,0 +1,47 @@
+// src/workloads/workloads.h
+#ifndef VM_WORKLOADS_H
+#define VM_WORKLOADS_H
+
+#include <common/types.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace vm {
+    // Long-running, self-checking guest programs used for performance work.
+    // Every workload leaves WORKLOAD_PASS in the status register when its result
+    // matches the value computed on the host, WORKLOAD_FAIL otherwise.
+    // The instruction count grows linearly with the scale parameter.
+    constexpr size_t WORKLOAD_MEMORY_SIZE = 4 * 1024 * 1024; // Needs the HEAP segment
+    constexpr uint8_t WORKLOAD_STATUS_REGISTER = 15;
+    constexpr uint64_t WORKLOAD_PASS = 1;
+    constexpr uint64_t WORKLOAD_FAIL = 0xBAD;
+
+    struct WorkloadProgram {
+        std::string name;
+        std::string description;
+        std::function<std::vector<uint64_t>(uint32_t scale)> generator;
+    };
+
+    // Sequential fill then repeated summing of the whole HEAP segment
+    std::vector<uint64_t> createMemoryStreamWorkload(uint32_t scale);
+
+    // Walk a linked list whose nodes are scattered through the HEAP segment
+    std::vector<uint64_t> createPointerChaseWorkload(uint32_t scale);
+
+    // Recursive quicksort of pseudo-random arrays in the HEAP segment
+    std::vector<uint64_t> createQuicksortWorkload(uint32_t scale);
+
+    // Deep recursive CALL/RET chains
+    std::vector<uint64_t> createRecursionWorkload(uint32_t scale);
+
+    // Open-addressing hash table inserts and lookups
+    std::vector<uint64_t> createHashTableWorkload(uint32_t scale);
+
+    // Data-dependent, unpredictable branches
+    std::vector<uint64_t> createBranchStressWorkload(uint32_t scale);
+
+    std::vector<WorkloadProgram> getWorkloadCorpus();
+}
+
+#endif // VM_WORKLOADS_H
@@ -0,0 +1,111 @@
+// tools/vmasm.cpp
+// Assembler: translates VM assembly source into a .vmfw firmware image.
+#include "src/asm/assembler.h"
+#include "src/vm/firmware_loader.h"
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+    constexpr size_t kMaxReportedErrors = 20;
+
+    void printUsage(const char* programName) {
+        std::cout << "Usage: " << programName << " <input.asm> [OPTIONS]" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "  -o <file>     Output file (default: <input>.vmfw)" << std::endl;
+        std::cout << "  --v2          Always write format v2 (with symbols)" << std::endl;
+        std::cout << "  --compress    Write format v2 with a compressed code section" << std::endl;
+        std::cout << "  -h, --help    Show this help message" << std::endl;
+    }
+
+    std::string defaultOutputName(const std::string& input) {
+        size_t slash = input.find_last_of('/');
+        size_t dot = input.find_last_of('.');
+        if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+            return input.substr(0, dot) + ".vmfw";
+        }
+        return input + ".vmfw";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string input;
+    std::string output;
+    bool forceV2 = false;
+    bool compress = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-o") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: -o option requires a filename" << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--v2") == 0) {
+            forceV2 = true;
+        } else if (strcmp(argv[i], "--compress") == 0) {
+            compress = true;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else if (argv[i][0] == '-' || !input.empty()) {
+            std::cerr << "Error: Unexpected argument: " << argv[i] << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            input = argv[i];
+        }
+    }
+
+    if (input.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (output.empty()) {
+        output = defaultOutputName(input);
+    }
+
+    vm::Assembler assembler;
+    auto start = std::chrono::steady_clock::now();
+    bool assembled = assembler.AssembleFile(input);
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    const auto& errors = assembler.GetErrors();
+    for (size_t i = 0; i < errors.size() && i < kMaxReportedErrors; ++i) {
+        std::cerr << input << ":" << errors[i].line << ": error: " << errors[i].message << std::endl;
+    }
+    if (errors.size() > kMaxReportedErrors) {
+        std::cerr << "... " << errors.size() - kMaxReportedErrors << " more errors" << std::endl;
+    }
+    if (!assembled) {
+        return 1;
+    }
+
+    const vm::FirmwareImage& image = assembler.GetImage();
+    if (image.code.empty()) {
+        std::cerr << "Error: " << input << " contains no instructions" << std::endl;
+        return 1;
+    }
+
+    // v1 holds code only; data and symbols need v2
+    bool v2 = forceV2 || compress || !image.data.empty();
+    bool saved = v2 ? vm::FirmwareLoader::SaveFirmwareV2(output, image, compress)
+                    : vm::FirmwareLoader::SaveFirmware(output, image.code, image.description, image.entryPoint);
+    if (!saved) {
+        std::cerr << "Error: Cannot write " << output << std::endl;
+        return 1;
+    }
+
+    std::cout << std::dec << "Assembled " << input << " (" << assembler.GetLineCount() << " lines) in "
+              << std::fixed << std::setprecision(2) << elapsed << " ms" << std::endl;
+    std::cout << "Instructions: " << image.code.size() << std::endl;
+    if (!image.data.empty()) {
+        std::cout << "Data: " << image.data.size() << " bytes at 0x" << std::hex << image.dataAddress << std::dec << std::endl;
+    }
+    std::cout << "Symbols: " << image.symbols.size() << std::endl;
+    std::cout << "Output: " << output << " (format v" << (v2 ? 2 : 1) << (compress ? ", compressed" : "") << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,88 @@
+// tools/vmdis.cpp
+// Disassembler: prints a .vmfw as vmasm source, optionally annotated with a sampling profile.
+#include "src/asm/disassembler.h"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+    void printUsage(const char* programName) {
+        std::cout << "Usage: " << programName << " <input.vmfw> [OPTIONS]" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "  -o <file>         Output file (default: standard output)" << std::endl;
+        std::cout << "  --profile <file>  Annotate instructions with sample counts from a --profile histogram" << std::endl;
+        std::cout << "  --context <n>     With --profile, only print instructions within n of a sampled one" << std::endl;
+        std::cout << "  --no-encoding     Omit the address and instruction word comments" << std::endl;
+        std::cout << "  -h, --help        Show this help message" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string input;
+    std::string output;
+    std::string profile;
+    vm::DisassemblyOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--profile") == 0 || strcmp(argv[i], "--context") == 0) {
+            if (!hasValue) {
+                std::cerr << "Error: " << argv[i] << " option requires a value" << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+            if (strcmp(argv[i], "-o") == 0) {
+                output = argv[++i];
+            } else if (strcmp(argv[i], "--profile") == 0) {
+                profile = argv[++i];
+            } else {
+                options.context = std::strtoull(argv[++i], nullptr, 10);
+            }
+        } else if (strcmp(argv[i], "--no-encoding") == 0) {
+            options.showEncoding = false;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else if (argv[i][0] == '-' || !input.empty()) {
+            std::cerr << "Error: Unexpected argument: " << argv[i] << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            input = argv[i];
+        }
+    }
+
+    if (input.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    vm::Disassembler disassembler;
+    if (!disassembler.Open(input)) {
+        std::cerr << "Error: " << disassembler.GetError() << std::endl;
+        return 1;
+    }
+    if (!profile.empty() && !disassembler.LoadProfile(profile)) {
+        std::cerr << "Error: " << disassembler.GetError() << std::endl;
+        return 1;
+    }
+
+    std::ofstream file;
+    if (!output.empty()) {
+        file.open(output);
+        if (!file.is_open()) {
+            std::cerr << "Error: Cannot create " << output << std::endl;
+            return 1;
+        }
+    }
+
+    std::ostream& out = output.empty() ? std::cout : file;
+    if (!disassembler.Write(out, options)) {
+        std::cerr << "Error: " << (disassembler.GetError().empty() ? "Cannot write " + output : disassembler.GetError())
+                  << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+// tools/vmopt.cpp
+// Firmware optimizer: reads a .vmfw, applies the peephole optimizer and writes the
+// result in the same format (v1, v2, compressed v2).
+#include "src/vm/firmware_loader.h"
+#include "src/vm/firmware_format.h"
+#include "src/analysis/optimizer.h"
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+    void printUsage(const char* programName) {
+        std::cout << "Usage: " << programName << " <input.vmfw> [OPTIONS]" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "  -o <file>     Output file (default: <input>.opt.vmfw)" << std::endl;
+        std::cout << "  --dry-run     Report what would change without writing anything" << std::endl;
+        std::cout << "  -h, --help    Show this help message" << std::endl;
+    }
+
+    std::string defaultOutputName(const std::string& input) {
+        const std::string extension = ".vmfw";
+        if (input.size() > extension.size() && input.compare(input.size() - extension.size(), extension.size(), extension) == 0) {
+            return input.substr(0, input.size() - extension.size()) + ".opt" + extension;
+        }
+        return input + ".opt";
+    }
+
+    void printStats(const vm::OptimizerStats& stats) {
+        double saved = stats.instructionsBefore
+                           ? 100.0 * (static_cast<double>(stats.instructionsBefore) - static_cast<double>(stats.instructionsAfter)) /
+                                 static_cast<double>(stats.instructionsBefore)
+                           : 0.0;
+        std::cout << "Instructions: " << stats.instructionsBefore << " -> " << stats.instructionsAfter
+                  << std::fixed << std::setprecision(1) << " (-" << saved << "%)" << std::endl;
+        std::cout << "Passes: " << stats.passes << std::endl;
+        std::cout << "  Constants folded:        " << stats.constantsFolded << std::endl;
+        std::cout << "  Redundant MOVs removed:  " << stats.movesRemoved << std::endl;
+        std::cout << "  MOVs merged into ALU:    " << stats.movesMerged << std::endl;
+        std::cout << "  PUSH/POP pairs:          " << stats.stackPairs << std::endl;
+        std::cout << "  MUL -> SHL:              " << stats.strengthReduced << std::endl;
+        std::cout << "  Jumps threaded:          " << stats.jumpsThreaded << std::endl;
+        std::cout << "  Dead code removed:       " << stats.deadRemoved << std::endl;
+        std::cout << "  Unreachable removed:     " << stats.unreachableRemoved << std::endl;
+        if (!stats.relocatable) {
+            std::cout << "Note: indirect jumps or calls present, removed instructions were replaced by NOPs" << std::endl;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string input;
+    std::string output;
+    bool dryRun = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-o") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: -o option requires a filename" << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--dry-run") == 0) {
+            dryRun = true;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else if (argv[i][0] == '-' || !input.empty()) {
+            std::cerr << "Error: Unexpected argument: " << argv[i] << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            input = argv[i];
+        }
+    }
+
+    if (input.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (output.empty()) {
+        output = defaultOutputName(input);
+    }
+
+    // Keep the input's format: version and whether the code section is compressed
+    vm::MappedFirmware firmware;
+    if (!firmware.Open(input) || !firmware.VerifyChecksums()) {
+        std::cerr << "Error: " << firmware.GetError() << std::endl;
+        return 1;
+    }
+    uint32_t version = firmware.GetVersion();
+    const vm::FirmwareSection* codeSection = firmware.FindSection(vm::SectionType::CODE);
+    bool compressed = codeSection && (codeSection->mFlags & vm::SECTION_FLAG_COMPRESSED);
+    firmware.Close();
+
+    vm::FirmwareImage image;
+    if (!vm::FirmwareLoader::LoadFirmwareImage(input, image, false)) {
+        std::cerr << "Error: Cannot load firmware " << input << std::endl;
+        return 1;
+    }
+
+    vm::PeepholeOptimizer optimizer;
+    vm::OptimizerStats stats = optimizer.Optimize(image.code, image.codeAddress, image.entryPoint);
+    for (auto& symbol : image.symbols) {
+        symbol.address = optimizer.Relocate(symbol.address);
+    }
+
+    std::cout << "Input: " << input << " (format v" << version << (compressed ? ", compressed" : "") << ")" << std::endl;
+    printStats(stats);
+
+    if (dryRun) {
+        return 0;
+    }
+
+    bool saved = version == vm::FIRMWARE_VERSION_2
+                     ? vm::FirmwareLoader::SaveFirmwareV2(output, image, compressed)
+                     : vm::FirmwareLoader::SaveFirmware(output, image.code, image.description, image.entryPoint);
+    if (!saved) {
+        std::cerr << "Error: Cannot write " << output << std::endl;
+        return 1;
+    }
+    std::cout << "Output: " << output << std::endl;
+    return 0;
+}